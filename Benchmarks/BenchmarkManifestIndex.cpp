@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: BenchmarkManifestIndex.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "..\Packet\PacketConfig.h"
+#include "..\Packet\PacketCondensedManifest.h"
+
+PacketUsingDevelopmentNamespace(Packet)
+
+// The info stored by the old std::map index
+struct MappedInternalFileInfo
+{
+    uint32_t fileIndex;
+    uint64_t location;
+    uint64_t size;
+};
+
+// Run a lookup for each hash and return the average time (in nanoseconds) per lookup
+template <typename LookupMethod>
+static double MeasureLookups(const std::vector<HashPrimitive>& _hashes, uint64_t& _checksum, LookupMethod _lookupMethod)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (auto hash : _hashes)
+    {
+        _checksum += _lookupMethod(hash);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) / double(_hashes.size());
+}
+
+int main(int _argc, char** _argv)
+{
+    const uint32_t totalEntries = _argc > 1 ? uint32_t(std::stoul(_argv[1])) : 1000000;
+    const uint32_t totalRounds = 5;
+    const std::string manifestPath = "BenchmarkManifestIndex.manifest";
+
+    PacketLogger logger;
+
+    // Create the condensed file infos (entries are split between a few condensed files) and the std::map index (the
+    // way the condensed loader used to do), paths with colliding hashes are skipped
+    std::vector<CondensedFileInfo> condensedFileInfos(8);
+    std::map<HashPrimitive, MappedInternalFileInfo> mappedInternalFileInfos;
+    std::vector<HashPrimitive> hashes;
+    for (uint32_t i = 0; hashes.size() < totalEntries; i++)
+    {
+        uint32_t fileIndex = i % uint32_t(condensedFileInfos.size());
+        auto& condensedFileInfo = condensedFileInfos[fileIndex];
+
+        CondensedFileInfo::InternalFileInfo internalFileInfo = {};
+        internalFileInfo.hash = Hash(std::string("Data/folder_") + std::to_string(i % 1000) + "/file_" + std::to_string(i) + ".bin");
+        internalFileInfo.location = condensedFileInfo.fileSize;
+        internalFileInfo.size = 64 + i % 4096;
+        if (!mappedInternalFileInfos.insert({ internalFileInfo.hash.GetHashValue(), { fileIndex, internalFileInfo.location, internalFileInfo.size } }).second)
+        {
+            continue;
+        }
+
+        condensedFileInfo.fileSize += internalFileInfo.size;
+        condensedFileInfo.fileInfos.push_back(internalFileInfo);
+        hashes.push_back(internalFileInfo.hash.GetHashValue());
+    }
+
+    PacketCondensedManifest manifest;
+    if (!PacketCondensedManifest::Write(manifestPath, condensedFileInfos, {}, {}, 0, &logger) || !manifest.Open(manifestPath, &logger))
+    {
+        return 1;
+    }
+
+    // Lookups are done in a random order
+    std::shuffle(hashes.begin(), hashes.end(), std::mt19937_64(42));
+
+    printf("Looking up %u entries, %u rounds\n", totalEntries, totalRounds);
+    for (uint32_t round = 0; round < totalRounds; round++)
+    {
+        uint64_t mapChecksum = 0;
+        double mapTime = MeasureLookups(hashes, mapChecksum, [&](HashPrimitive _hash)
+        {
+            auto& info = mappedInternalFileInfos.find(_hash)->second;
+            return info.location + info.size + info.fileIndex;
+        });
+
+        uint64_t indexChecksum = 0;
+        double indexTime = MeasureLookups(hashes, indexChecksum, [&](HashPrimitive _hash)
+        {
+            auto info = manifest.FindEntry(_hash);
+            return info->location + info->size + info->packIndex;
+        });
+
+        printf("round %u: std::map %.1f ns/lookup, manifest index %.1f ns/lookup (%.2fx)%s\n", 
+               round, 
+               mapTime, 
+               indexTime, 
+               mapTime / indexTime, 
+               mapChecksum == indexChecksum ? "" : " CHECKSUM MISMATCH");
+    }
+
+    return 0;
+}
@@ -36,6 +36,14 @@ typedef __development__Packet::PacketResourceManager		     ResourceManager;
 typedef __development__Packet::PacketSystem					     System;
 
 typedef __development__Packet::OperationMode				     OperationMode;
+typedef __development__Packet::CondensedReaderMode			     CondensedReaderMode;
+typedef __development__Packet::CondensedVerifyMode			     CondensedVerifyMode;
+typedef __development__Packet::AsyncReadMode				     AsyncReadMode;
+typedef __development__Packet::PacketSystemSettings			     SystemSettings;
+typedef __development__Packet::PacketFileLoaderStats		     FileLoaderStats;
+typedef __development__Packet::PacketResourceManagerStats	     ResourceManagerStats;
+typedef __development__Packet::PacketCondenseSettings		     CondenseSettings;
+typedef __development__Packet::CondensedCompression			     Compression;
 typedef __development__Packet::ReferenceFixer				     ReferenceFixer;
 typedef __development__Packet::Hash							     Hash;
 typedef __development__Packet::PacketResourceData			     ResourceData;
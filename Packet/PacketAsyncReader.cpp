@@ -0,0 +1,815 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketAsyncReader.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketAsyncReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// io_uring is used through raw system calls, there is no dependency on liburing
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define PacketAsyncReaderIoUring
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+#endif
+
+///////////////
+// NAMESPACE //
+///////////////
+PacketUsingDevelopmentNamespace(Packet)
+
+#if defined(PacketAsyncReaderIoUring)
+
+struct PacketAsyncReader::RingData
+{
+	// The ring file descriptor and the mapped submission ring, completion ring and submission entries
+	int ringDescriptor = -1;
+	uint8_t* submissionRing = nullptr;
+	size_t submissionRingSize = 0;
+	uint8_t* completionRing = nullptr;
+	size_t completionRingSize = 0;
+	io_uring_sqe* submissionEntries = nullptr;
+	size_t submissionEntriesSize = 0;
+
+	// The ring fields shared with the kernel
+	uint32_t* submissionTail = nullptr;
+	uint32_t* submissionArray = nullptr;
+	uint32_t submissionMask = 0;
+	uint32_t* completionHead = nullptr;
+	uint32_t* completionTail = nullptr;
+	uint32_t completionMask = 0;
+	io_uring_cqe* completionEntries = nullptr;
+
+	// One slot for each read in flight (its index is the entry user data), the free slots, the reads waiting for a
+	// free slot and how many entries weren't submitted yet
+	std::vector<Operation> slots;
+	std::vector<iovec> slotBuffers;
+	std::vector<uint32_t> freeSlots;
+	std::deque<Operation> backlog;
+	uint32_t totalUnsubmitted = 0;
+
+	// The event signalled by the kernel when completions are posted, the thread that reaps them and its exit flag
+	int completionEventDescriptor = -1;
+	std::thread completionThread;
+	std::atomic<bool> completionThreadShouldExit = false;
+};
+
+#else
+
+struct PacketAsyncReader::RingData
+{
+};
+
+#endif
+
+PacketAsyncReader::PacketAsyncReader()
+{
+	// Set the initial data
+	// ...
+}
+
+PacketAsyncReader::~PacketAsyncReader()
+{
+	Release();
+}
+
+bool PacketAsyncReader::Initialize(AsyncReadMode _mode, uint32_t _queueDepth, uint32_t _totalThreads, PacketLogger* _logger)
+{
+	// Set the data
+	m_Logger = _logger;
+
+	// Try to use io_uring, the thread pool is used when it isn't supported (or isn't allowed)
+	if (_mode == AsyncReadMode::Automatic && !InitializeRing(std::max(1u, _queueDepth)))
+	{
+		m_Logger->LogInfo("io_uring isn't available, asynchronous reads will use the thread pool");
+	}
+
+	// Start the worker threads, they are always needed for tasks and finalizers
+	for (uint32_t i = 0; i < std::max(1u, _totalThreads); i++)
+	{
+		m_WorkerThreads.push_back(std::thread(&PacketAsyncReader::WorkerThread, this));
+	}
+
+	return true;
+}
+
+void PacketAsyncReader::Release()
+{
+	// Release the ring first, its completion thread queues operations for the worker threads
+	ReleaseRing();
+
+	// Stop the worker threads after they finish the queued operations
+	{
+		std::lock_guard<std::mutex> lock(m_OperationQueueMutex);
+		m_ShouldExit = true;
+	}
+	m_OperationQueueCondition.notify_all();
+	for (auto& workerThread : m_WorkerThreads)
+	{
+		workerThread.join();
+	}
+	m_WorkerThreads.clear();
+
+	// Close our files
+	for (auto fileHandle : m_FileHandles)
+	{
+#ifdef _WIN32
+		CloseHandle(fileHandle);
+#else
+		close(fileHandle);
+#endif
+	}
+	m_FileHandles.clear();
+	m_DirectIoFiles.clear();
+
+	// Free the bounce buffers
+	for (auto bounceBuffer : m_BounceBuffers)
+	{
+		::operator delete[](bounceBuffer, std::align_val_t(DirectReadAlignment));
+	}
+	m_BounceBuffers.clear();
+}
+
+bool PacketAsyncReader::OpenFile(const std::string& _filePath, uint32_t& _fileIndexOut, bool _directIo)
+{
+#ifdef _WIN32
+	DWORD flags = _directIo ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL;
+	HANDLE fileHandle = CreateFileA(_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+#else
+	int flags = O_RDONLY | O_CLOEXEC;
+	if (_directIo)
+	{
+#ifdef O_DIRECT
+		flags |= O_DIRECT;
+#else
+		// Direct I/O isn't supported on this platform
+		return false;
+#endif
+	}
+
+	int fileHandle = open(_filePath.c_str(), flags);
+	if (fileHandle < 0)
+	{
+		return false;
+	}
+#endif
+
+	_fileIndexOut = uint32_t(m_FileHandles.size());
+	m_FileHandles.push_back(fileHandle);
+	m_DirectIoFiles.push_back(_directIo);
+
+	return true;
+}
+
+void PacketAsyncReader::SubmitRead(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut, std::function<bool()> _finalizer, uint64_t _userData)
+{
+	Operation operation;
+	operation.fileIndex = _fileIndex;
+	operation.offset = _offset;
+	operation.size = _size;
+	operation.dataOut = _dataOut;
+	operation.finalizer = std::move(_finalizer);
+	operation.userData = _userData;
+
+	QueueRead(std::move(operation));
+}
+
+void PacketAsyncReader::SubmitMergedRead(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut, std::function<void(bool)> _completionHandler)
+{
+	Operation operation;
+	operation.fileIndex = _fileIndex;
+	operation.offset = _offset;
+	operation.size = _size;
+	operation.dataOut = _dataOut;
+	operation.completionHandler = std::move(_completionHandler);
+
+	QueueRead(std::move(operation));
+}
+
+void PacketAsyncReader::QueueRead(Operation&& _operation)
+{
+	// Invalid files are completed right away
+	if (_operation.fileIndex >= m_FileHandles.size())
+	{
+		_operation.readDone = true;
+		EnqueueOperation(std::move(_operation));
+		return;
+	}
+
+	// Direct I/O reads are split by the worker threads
+	if (m_Ring != nullptr && !m_DirectIoFiles[_operation.fileIndex])
+	{
+		std::lock_guard<std::mutex> lock(m_RingMutex);
+		PushRingOperation(std::move(_operation));
+		return;
+	}
+
+	EnqueueOperation(std::move(_operation));
+}
+
+void PacketAsyncReader::CompleteRead(Operation& _operation, bool _readSucceeded)
+{
+	if (_operation.completionHandler)
+	{
+		_operation.completionHandler(_readSucceeded);
+		return;
+	}
+
+	PostCompletion(_operation.userData, _readSucceeded && (!_operation.finalizer || _operation.finalizer()));
+}
+
+void PacketAsyncReader::SubmitTask(std::function<bool()> _task, uint64_t _userData)
+{
+	Operation operation;
+	operation.task = std::move(_task);
+	operation.userData = _userData;
+
+	EnqueueOperation(std::move(operation));
+}
+
+void PacketAsyncReader::PostCompletion(uint64_t _userData, bool _succeeded)
+{
+	m_Completions.enqueue({ _userData, _succeeded });
+
+	std::lock_guard<std::mutex> lock(m_CompletionCallbackMutex);
+	if (m_CompletionCallback)
+	{
+		m_CompletionCallback();
+	}
+}
+
+void PacketAsyncReader::SetCompletionCallback(std::function<void()> _callback)
+{
+	std::lock_guard<std::mutex> lock(m_CompletionCallbackMutex);
+	m_CompletionCallback = std::move(_callback);
+}
+
+uint32_t PacketAsyncReader::DrainCompletions(std::vector<PacketReadCompletion>& _completionsOut)
+{
+	// Process the io_uring completions first, reads that need more work are resubmitted
+	if (m_Ring != nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_RingMutex);
+		ReapRingCompletions();
+	}
+	Flush();
+
+	uint32_t totalCompletions = 0;
+	PacketReadCompletion completion;
+	while (m_Completions.try_dequeue(completion))
+	{
+		_completionsOut.push_back(completion);
+		totalCompletions++;
+	}
+
+	return totalCompletions;
+}
+
+void PacketAsyncReader::AdviseFileRange(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, bool _willBeNeeded)
+{
+	if (_fileIndex >= m_FileHandles.size())
+	{
+		return;
+	}
+
+#if defined(POSIX_FADV_WILLNEED) && defined(POSIX_FADV_DONTNEED)
+	posix_fadvise(m_FileHandles[_fileIndex], off_t(_offset), off_t(_size), _willBeNeeded ? POSIX_FADV_WILLNEED : POSIX_FADV_DONTNEED);
+#else
+	// There is no way to advise the system about a file range here
+	(void)_offset;
+	(void)_size;
+	(void)_willBeNeeded;
+#endif
+}
+
+bool PacketAsyncReader::Read(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut)
+{
+	return _fileIndex < m_FileHandles.size() && ReadFileRange(_fileIndex, _offset, _size, _dataOut);
+}
+
+bool PacketAsyncReader::ReadInChunks(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, const std::function<void(const uint8_t*, uint64_t)>& _chunkConsumer)
+{
+	if (_fileIndex >= m_FileHandles.size())
+	{
+		return false;
+	}
+
+	// Direct I/O files are read in whole aligned blocks (the bounce buffer is aligned), only the part of each chunk that
+	// is inside the range is given to the consumer so nothing needs to be copied
+	uint64_t alignmentMask = m_DirectIoFiles[_fileIndex] ? DirectReadAlignment - 1 : 0;
+	uint8_t* bounceBuffer = AcquireBounceBuffer();
+	bool succeeded = true;
+	uint64_t position = _offset;
+	uint64_t end = _offset + _size;
+	while (position < end)
+	{
+		uint64_t blockBegin = position & ~alignmentMask;
+		uint64_t skipSize = position - blockBegin;
+		uint64_t readSize = std::min((end - blockBegin + alignmentMask) & ~alignmentMask, DirectReadBounceBufferSize);
+		int64_t bytesRead = ReadFileChunk(_fileIndex, blockBegin, readSize, bounceBuffer);
+		if (bytesRead <= int64_t(skipSize))
+		{
+			succeeded = false;
+			break;
+		}
+
+		uint64_t chunkSize = std::min(end - position, uint64_t(bytesRead) - skipSize);
+		_chunkConsumer(bounceBuffer + skipSize, chunkSize);
+		position += chunkSize;
+	}
+	ReleaseBounceBuffer(bounceBuffer);
+
+	return succeeded;
+}
+
+bool PacketAsyncReader::UsesIoUring() const
+{
+	return m_Ring != nullptr;
+}
+
+uint64_t PacketAsyncReader::GetTotalBounceBufferBytes() const
+{
+	return m_TotalBounceBufferBytes;
+}
+
+void PacketAsyncReader::EnqueueOperation(Operation&& _operation)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_OperationQueueMutex);
+		m_OperationQueue.push_back(std::move(_operation));
+	}
+	m_OperationQueueCondition.notify_one();
+}
+
+void PacketAsyncReader::WorkerThread()
+{
+	while (true)
+	{
+		// Wait for an operation, the queue is emptied before exiting
+		Operation operation;
+		{
+			std::unique_lock<std::mutex> lock(m_OperationQueueMutex);
+			m_OperationQueueCondition.wait(lock, [&]() { return m_ShouldExit || !m_OperationQueue.empty(); });
+			if (m_OperationQueue.empty())
+			{
+				return;
+			}
+
+			operation = std::move(m_OperationQueue.front());
+			m_OperationQueue.pop_front();
+		}
+
+		// Run the task or perform the read (unless io_uring already did it)
+		if (operation.task)
+		{
+			PostCompletion(operation.userData, operation.task());
+		}
+		else
+		{
+			CompleteRead(operation, operation.readDone 
+				? operation.readSucceeded 
+				: ReadFileRange(operation.fileIndex, operation.offset, operation.size, operation.dataOut));
+		}
+	}
+}
+
+bool PacketAsyncReader::ReadFileRange(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut)
+{
+	if (m_DirectIoFiles[_fileIndex])
+	{
+		return ReadDirectFileRange(_fileIndex, _offset, _size, _dataOut);
+	}
+
+	// Read until the whole range is done, a single call can return less than requested
+	uint64_t totalRead = 0;
+	while (totalRead < _size)
+	{
+		int64_t bytesRead = ReadFileChunk(_fileIndex, _offset + totalRead, _size - totalRead, _dataOut + totalRead);
+		if (bytesRead <= 0)
+		{
+			return false;
+		}
+
+		totalRead += uint64_t(bytesRead);
+	}
+
+	return true;
+}
+
+bool PacketAsyncReader::ReadDirectFileRange(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut)
+{
+	const uint64_t alignmentMask = uint64_t(DirectReadAlignment) - 1;
+
+	uint8_t* bounceBuffer = nullptr;
+	uint64_t position = _offset;
+	uint64_t totalRead = 0;
+	bool succeeded = true;
+	while (totalRead < _size && succeeded)
+	{
+		uint64_t remaining = _size - totalRead;
+		uint8_t* dataOut = _dataOut + totalRead;
+
+		// When the position and the output are aligned, the whole aligned blocks are read straight into the output
+		if ((position & alignmentMask) == 0 && (reinterpret_cast<uintptr_t>(dataOut) & alignmentMask) == 0 && remaining > alignmentMask)
+		{
+			int64_t bytesRead = ReadFileChunk(_fileIndex, position, remaining & ~alignmentMask, dataOut);
+			succeeded = bytesRead > 0;
+			position += uint64_t(std::max<int64_t>(bytesRead, 0));
+			totalRead += uint64_t(std::max<int64_t>(bytesRead, 0));
+			continue;
+		}
+
+		// Everything else (the unaligned head and tail, or the whole range when the output isn't aligned) is read in 
+		// aligned blocks into a bounce buffer and copied, the last block can go past the end of the file
+		if (bounceBuffer == nullptr)
+		{
+			bounceBuffer = AcquireBounceBuffer();
+		}
+
+		uint64_t blockBegin = position & ~alignmentMask;
+		uint64_t blockEnd = (position + remaining + alignmentMask) & ~alignmentMask;
+		uint64_t skipSize = position - blockBegin;
+		int64_t bytesRead = ReadFileChunk(_fileIndex, blockBegin, std::min(blockEnd - blockBegin, DirectReadBounceBufferSize), bounceBuffer);
+		if (bytesRead <= int64_t(skipSize))
+		{
+			succeeded = false;
+			continue;
+		}
+
+		uint64_t copySize = std::min(remaining, uint64_t(bytesRead) - skipSize);
+		memcpy(dataOut, bounceBuffer + skipSize, size_t(copySize));
+		m_TotalBounceBufferBytes += copySize;
+		position += copySize;
+		totalRead += copySize;
+	}
+
+	if (bounceBuffer != nullptr)
+	{
+		ReleaseBounceBuffer(bounceBuffer);
+	}
+
+	return succeeded;
+}
+
+int64_t PacketAsyncReader::ReadFileChunk(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const
+{
+	// Never read more than 1GB at once (this keeps direct I/O reads aligned)
+	uint64_t chunkSize = std::min<uint64_t>(_size, 0x40000000);
+
+#ifdef _WIN32
+	OVERLAPPED overlapped = {};
+	overlapped.Offset = DWORD(_offset & 0xffffffff);
+	overlapped.OffsetHigh = DWORD(_offset >> 32);
+
+	DWORD bytesRead = 0;
+	if (!ReadFile(m_FileHandles[_fileIndex], _dataOut, DWORD(chunkSize), &bytesRead, &overlapped) && GetLastError() != ERROR_HANDLE_EOF)
+	{
+		return -1;
+	}
+
+	return int64_t(bytesRead);
+#else
+	while (true)
+	{
+		ssize_t bytesRead = pread(m_FileHandles[_fileIndex], _dataOut, size_t(chunkSize), off_t(_offset));
+		if (bytesRead < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		return int64_t(bytesRead);
+	}
+#endif
+}
+
+uint8_t* PacketAsyncReader::AcquireBounceBuffer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_BounceBufferMutex);
+		if (!m_BounceBuffers.empty())
+		{
+			uint8_t* bounceBuffer = m_BounceBuffers.back();
+			m_BounceBuffers.pop_back();
+			return bounceBuffer;
+		}
+	}
+
+	return new (std::align_val_t(DirectReadAlignment)) uint8_t[size_t(DirectReadBounceBufferSize)];
+}
+
+void PacketAsyncReader::ReleaseBounceBuffer(uint8_t* _bounceBuffer)
+{
+	std::lock_guard<std::mutex> lock(m_BounceBufferMutex);
+	m_BounceBuffers.push_back(_bounceBuffer);
+}
+
+#if defined(PacketAsyncReaderIoUring)
+
+bool PacketAsyncReader::InitializeRing(uint32_t _queueDepth)
+{
+	// Create the ring, this fails on kernels without io_uring (or when it's blocked)
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int ringDescriptor = int(syscall(__NR_io_uring_setup, _queueDepth, &params));
+	if (ringDescriptor < 0)
+	{
+		return false;
+	}
+
+	auto ring = std::make_unique<RingData>();
+	ring->ringDescriptor = ringDescriptor;
+
+	// Map the submission ring, the completion ring and the submission entries
+	auto MapRing = [&](size_t _size, off_t _offset)
+	{
+		void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringDescriptor, _offset);
+		return data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+	};
+
+	ring->submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	ring->completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	ring->submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+	ring->submissionRing = MapRing(ring->submissionRingSize, IORING_OFF_SQ_RING);
+	ring->completionRing = MapRing(ring->completionRingSize, IORING_OFF_CQ_RING);
+	ring->submissionEntries = reinterpret_cast<io_uring_sqe*>(MapRing(ring->submissionEntriesSize, IORING_OFF_SQES));
+	m_Ring = std::move(ring);
+	if (m_Ring->submissionRing == nullptr || m_Ring->completionRing == nullptr || m_Ring->submissionEntries == nullptr)
+	{
+		ReleaseRing();
+		return false;
+	}
+
+	// Get the ring fields
+	m_Ring->submissionTail = reinterpret_cast<uint32_t*>(m_Ring->submissionRing + params.sq_off.tail);
+	m_Ring->submissionArray = reinterpret_cast<uint32_t*>(m_Ring->submissionRing + params.sq_off.array);
+	m_Ring->submissionMask = *reinterpret_cast<uint32_t*>(m_Ring->submissionRing + params.sq_off.ring_mask);
+	m_Ring->completionHead = reinterpret_cast<uint32_t*>(m_Ring->completionRing + params.cq_off.head);
+	m_Ring->completionTail = reinterpret_cast<uint32_t*>(m_Ring->completionRing + params.cq_off.tail);
+	m_Ring->completionMask = *reinterpret_cast<uint32_t*>(m_Ring->completionRing + params.cq_off.ring_mask);
+	m_Ring->completionEntries = reinterpret_cast<io_uring_cqe*>(m_Ring->completionRing + params.cq_off.cqes);
+
+	// Never keep more reads in flight than the submission ring can hold, the completion ring is at least twice as big
+	// so it can't overflow
+	m_Ring->slots.resize(params.sq_entries);
+	m_Ring->slotBuffers.resize(params.sq_entries);
+	for (uint32_t i = 0; i < params.sq_entries; i++)
+	{
+		m_Ring->freeSlots.push_back(params.sq_entries - i - 1);
+	}
+
+	// Have the kernel signal an event when completions are posted so they are reaped as soon as possible instead of
+	// only when they are drained (kernels that can't do it use the thread pool)
+	m_Ring->completionEventDescriptor = eventfd(0, EFD_CLOEXEC);
+	if (m_Ring->completionEventDescriptor < 0 
+		|| syscall(__NR_io_uring_register, ringDescriptor, IORING_REGISTER_EVENTFD, &m_Ring->completionEventDescriptor, 1) < 0)
+	{
+		ReleaseRing();
+		return false;
+	}
+	m_Ring->completionThread = std::thread(&PacketAsyncReader::RingCompletionThread, this);
+
+	return true;
+}
+
+void PacketAsyncReader::ReleaseRing()
+{
+	if (m_Ring == nullptr)
+	{
+		return;
+	}
+
+	// Stop the completion thread, the event is signalled to wake it up
+	if (m_Ring->completionThread.joinable())
+	{
+		m_Ring->completionThreadShouldExit = true;
+		uint64_t eventValue = 1;
+		while (write(m_Ring->completionEventDescriptor, &eventValue, sizeof(eventValue)) < 0 && errno == EINTR)
+		{
+		}
+		m_Ring->completionThread.join();
+	}
+	if (m_Ring->completionEventDescriptor >= 0)
+	{
+		close(m_Ring->completionEventDescriptor);
+	}
+
+	if (m_Ring->submissionEntries != nullptr)
+	{
+		munmap(m_Ring->submissionEntries, m_Ring->submissionEntriesSize);
+	}
+	if (m_Ring->completionRing != nullptr)
+	{
+		munmap(m_Ring->completionRing, m_Ring->completionRingSize);
+	}
+	if (m_Ring->submissionRing != nullptr)
+	{
+		munmap(m_Ring->submissionRing, m_Ring->submissionRingSize);
+	}
+	close(m_Ring->ringDescriptor);
+
+	m_Ring.reset();
+}
+
+void PacketAsyncReader::PushRingOperation(Operation&& _operation)
+{
+	// If all slots are in use the read waits until one is free
+	if (m_Ring->freeSlots.empty())
+	{
+		m_Ring->backlog.push_back(std::move(_operation));
+		return;
+	}
+
+	uint32_t slot = m_Ring->freeSlots.back();
+	m_Ring->freeSlots.pop_back();
+	m_Ring->slots[slot] = std::move(_operation);
+
+	WriteRingEntry(slot);
+}
+
+void PacketAsyncReader::WriteRingEntry(uint32_t _slot)
+{
+	Operation& operation = m_Ring->slots[_slot];
+	m_Ring->slotBuffers[_slot].iov_base = operation.dataOut;
+	m_Ring->slotBuffers[_slot].iov_len = size_t(operation.size);
+
+	// We are the only producer, so the tail can be read directly
+	uint32_t tail = *m_Ring->submissionTail;
+	uint32_t index = tail & m_Ring->submissionMask;
+
+	// Readv is used (instead of read) so kernels from the first io_uring release are supported
+	io_uring_sqe& entry = m_Ring->submissionEntries[index];
+	memset(&entry, 0, sizeof(entry));
+	entry.opcode = IORING_OP_READV;
+	entry.fd = m_FileHandles[operation.fileIndex];
+	entry.off = operation.offset;
+	entry.addr = reinterpret_cast<uint64_t>(&m_Ring->slotBuffers[_slot]);
+	entry.len = 1;
+	entry.user_data = _slot;
+
+	m_Ring->submissionArray[index] = index;
+	__atomic_store_n(m_Ring->submissionTail, tail + 1, __ATOMIC_RELEASE);
+	m_Ring->totalUnsubmitted++;
+}
+
+void PacketAsyncReader::Flush()
+{
+	if (m_Ring == nullptr)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_RingMutex);
+	if (m_Ring->totalUnsubmitted == 0)
+	{
+		return;
+	}
+
+	// Entries that couldn't be submitted now (the call was interrupted or the kernel is busy) stay on the submission
+	// ring and are submitted on the next flush
+	int totalSubmitted = int(syscall(__NR_io_uring_enter, m_Ring->ringDescriptor, m_Ring->totalUnsubmitted, 0, 0, nullptr, 0));
+	if (totalSubmitted > 0)
+	{
+		m_Ring->totalUnsubmitted -= std::min(m_Ring->totalUnsubmitted, uint32_t(totalSubmitted));
+	}
+}
+
+void PacketAsyncReader::ReapRingCompletions()
+{
+	uint32_t head = *m_Ring->completionHead;
+	uint32_t tail = __atomic_load_n(m_Ring->completionTail, __ATOMIC_ACQUIRE);
+	while (head != tail)
+	{
+		const io_uring_cqe& entry = m_Ring->completionEntries[head & m_Ring->completionMask];
+		uint32_t slot = uint32_t(entry.user_data);
+		int32_t result = entry.res;
+		head++;
+
+		// Retry interrupted reads and continue short reads (they are common on network volumes)
+		Operation& operation = m_Ring->slots[slot];
+		if (result == -EINTR || result == -EAGAIN)
+		{
+			WriteRingEntry(slot);
+			continue;
+		}
+		else if (result > 0 && uint64_t(result) < operation.size)
+		{
+			operation.offset += uint64_t(result);
+			operation.dataOut += result;
+			operation.size -= uint64_t(result);
+			WriteRingEntry(slot);
+			continue;
+		}
+
+		// The read is done, free its slot
+		Operation finishedOperation = std::move(operation);
+		m_Ring->freeSlots.push_back(slot);
+
+		// The finalizer and the completion handler run on a worker thread so the caller isn't blocked by them
+		bool succeeded = result >= 0 && uint64_t(result) == finishedOperation.size;
+		if (finishedOperation.finalizer || finishedOperation.completionHandler)
+		{
+			finishedOperation.readDone = true;
+			finishedOperation.readSucceeded = succeeded;
+			EnqueueOperation(std::move(finishedOperation));
+		}
+		else
+		{
+			PostCompletion(finishedOperation.userData, succeeded);
+		}
+	}
+	__atomic_store_n(m_Ring->completionHead, head, __ATOMIC_RELEASE);
+
+	// Move the reads waiting for a slot into the ring
+	while (!m_Ring->backlog.empty() && !m_Ring->freeSlots.empty())
+	{
+		Operation operation = std::move(m_Ring->backlog.front());
+		m_Ring->backlog.pop_front();
+		PushRingOperation(std::move(operation));
+	}
+}
+
+void PacketAsyncReader::RingCompletionThread()
+{
+	while (true)
+	{
+		// Sleep until the kernel posts completions (or until we must exit)
+		uint64_t eventValue = 0;
+		if (read(m_Ring->completionEventDescriptor, &eventValue, sizeof(eventValue)) < 0 && errno != EINTR)
+		{
+			return;
+		}
+		if (m_Ring->completionThreadShouldExit)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_RingMutex);
+			ReapRingCompletions();
+		}
+
+		// Submit the reads that were continued or moved from the backlog
+		Flush();
+	}
+}
+
+#else
+
+bool PacketAsyncReader::InitializeRing(uint32_t /*_queueDepth*/)
+{
+	return false;
+}
+
+void PacketAsyncReader::ReleaseRing()
+{
+}
+
+void PacketAsyncReader::PushRingOperation(Operation&& /*_operation*/)
+{
+}
+
+void PacketAsyncReader::WriteRingEntry(uint32_t /*_slot*/)
+{
+}
+
+void PacketAsyncReader::Flush()
+{
+}
+
+void PacketAsyncReader::ReapRingCompletions()
+{
+}
+
+void PacketAsyncReader::RingCompletionThread()
+{
+}
+
+#endif
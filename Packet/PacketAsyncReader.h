@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketAsyncReader.h
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//////////////
+// INCLUDES //
+//////////////
+#include "PacketConfig.h"
+
+#include "concurrentqueue.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+///////////////
+// NAMESPACE //
+///////////////
+
+/////////////
+// DEFINES //
+/////////////
+
+////////////
+// GLOBAL //
+////////////
+
+///////////////
+// NAMESPACE //
+///////////////
+
+// Packet data explorer
+PacketDevelopmentNamespaceBegin(Packet)
+
+////////////////
+// FORWARDING //
+////////////////
+
+////////////////
+// STRUCTURES //
+////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PacketAsyncReader
+////////////////////////////////////////////////////////////////////////////////
+class PacketAsyncReader
+{
+private:
+
+	// A queued operation, a positional read on one of our files or a task that runs on a worker thread
+	struct Operation
+	{
+		// The read file index, its range and the output buffer (reads only)
+		uint32_t fileIndex = 0;
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		uint8_t* dataOut = nullptr;
+
+		// The task to run (tasks only) or the finalizer that runs on a worker thread after the read succeeds (reads
+		// only, optional), their return value is the operation result
+		std::function<bool()> task;
+		std::function<bool()> finalizer;
+
+		// The handler that runs on a worker thread once the read is done (merged reads only), it receives if the read
+		// succeeded and posts the completions itself
+		std::function<void(bool)> completionHandler;
+
+		// If the read was already performed by io_uring and its result, the operation is only queued for the workers
+		// to run its finalizer or completion handler
+		bool readDone = false;
+		bool readSucceeded = false;
+
+		// The user data returned with the completion
+		uint64_t userData = 0;
+	};
+
+	// The io_uring state (only available on Linux)
+	struct RingData;
+
+//////////////////
+// CONSTRUCTORS //
+public: //////////
+
+	// Constructor / destructor
+	PacketAsyncReader();
+	~PacketAsyncReader();
+
+	// This object owns threads and native handles, it can't be copied
+	PacketAsyncReader(const PacketAsyncReader&) = delete;
+	PacketAsyncReader& operator=(const PacketAsyncReader&) = delete;
+
+//////////////////
+// MAIN METHODS //
+public: //////////
+
+	// Initialize the reader, setting up io_uring (if allowed and supported) and starting the worker threads
+	bool Initialize(AsyncReadMode _mode, uint32_t _queueDepth, uint32_t _totalThreads, PacketLogger* _logger);
+
+	// Wait for the worker threads to finish the queued operations and release everything
+	void Release();
+
+	// Open a file for positional reads, all files must be opened before any read is submitted. Files opened for direct
+	// I/O bypass the page cache, their reads are never submitted to io_uring since the worker threads split them into
+	// aligned reads (opening fails if the file system doesn't support direct I/O)
+	bool OpenFile(const std::string& _filePath, uint32_t& _fileIndexOut, bool _directIo = false);
+
+	// Queue a positional read, on io_uring it's only submitted to the kernel when Flush() is called, else it's
+	// performed by a worker thread
+	void SubmitRead(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut, std::function<bool()> _finalizer, uint64_t _userData);
+
+	// Queue a positional read that serves multiple requests, instead of a single completion the given handler runs on a 
+	// worker thread once the read is done (receiving if it succeeded) and posts the completions with PostCompletion()
+	void SubmitMergedRead(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut, std::function<void(bool)> _completionHandler);
+
+	// Queue a task to run on a worker thread
+	void SubmitTask(std::function<bool()> _task, uint64_t _userData);
+
+	// Complete an operation without doing anything
+	void PostCompletion(uint64_t _userData, bool _succeeded);
+
+	// Set the callback that is called (from any thread) each time a completion is posted, so the thread that drains
+	// them can sleep until then
+	void SetCompletionCallback(std::function<void()> _callback);
+
+	// Advise the system that the given file range will be read soon (it's read ahead in the background) or that it won't
+	// be used soon (its pages are dropped from the page cache), this does nothing where it isn't supported
+	void AdviseFileRange(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, bool _willBeNeeded);
+
+	// Perform a blocking positional read on the calling thread
+	bool Read(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut);
+
+	// Perform a blocking positional read on the calling thread in chunks (of up to DirectReadBounceBufferSize bytes) read
+	// into a bounce buffer, each chunk is given to the consumer in order so a range can be processed without a buffer
+	// as big as it (and without copying it, even on direct I/O files)
+	bool ReadInChunks(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, const std::function<void(const uint8_t*, uint64_t)>& _chunkConsumer);
+
+	// Submit the queued io_uring reads to the kernel using a single system call
+	void Flush();
+
+	// Append the completions of the operations that finished since the last call, returns how many were appended
+	uint32_t DrainCompletions(std::vector<PacketReadCompletion>& _completionsOut);
+
+	// Return if reads are submitted to io_uring
+	bool UsesIoUring() const;
+
+	// Return how many bytes of the direct I/O reads were read through bounce buffers
+	uint64_t GetTotalBounceBufferBytes() const;
+
+private:
+
+	// The worker thread loop
+	void WorkerThread();
+
+	// Enqueue an operation for the worker threads
+	void EnqueueOperation(Operation&& _operation);
+
+	// Queue a read operation on io_uring or for the worker threads
+	void QueueRead(Operation&& _operation);
+
+	// Complete a read operation, running its finalizer or completion handler (on a worker thread)
+	void CompleteRead(Operation& _operation, bool _readSucceeded);
+
+	// Perform a blocking positional read
+	bool ReadFileRange(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut);
+
+	// Perform a blocking positional read on a direct I/O file, the aligned part of the range is read straight into the
+	// output buffer (when it's aligned too) and everything else goes through bounce buffers
+	bool ReadDirectFileRange(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut);
+
+	// Perform a single positional read, returns the number of bytes read (0 at the end of the file) or -1 on errors
+	int64_t ReadFileChunk(uint32_t _fileIndex, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const;
+
+	// Get an aligned bounce buffer (with DirectReadBounceBufferSize bytes) from the pool and return it when done
+	uint8_t* AcquireBounceBuffer();
+	void ReleaseBounceBuffer(uint8_t* _bounceBuffer);
+
+	// Setup and release io_uring, returns false if it isn't supported
+	bool InitializeRing(uint32_t _queueDepth);
+	void ReleaseRing();
+
+	// Place an operation into a free ring slot (or on the backlog if all slots are in use), the ring mutex must be held
+	void PushRingOperation(Operation&& _operation);
+
+	// Write the submission entry for the operation on the given slot, the ring mutex must be held
+	void WriteRingEntry(uint32_t _slot);
+
+	// Process the io_uring completions, the ring mutex must be held
+	void ReapRingCompletions();
+
+	// The io_uring completion thread loop, it sleeps until the kernel posts completions and reaps them
+	void RingCompletionThread();
+
+///////////////
+// VARIABLES //
+private: //////
+
+	// The logger
+	PacketLogger* m_Logger = nullptr;
+
+	// The io_uring state (nullptr if io_uring isn't used) and the mutex that protects it
+	std::unique_ptr<RingData> m_Ring;
+	std::mutex m_RingMutex;
+
+	// The worker threads, their operation queue and the exit flag
+	std::vector<std::thread> m_WorkerThreads;
+	std::deque<Operation> m_OperationQueue;
+	std::mutex m_OperationQueueMutex;
+	std::condition_variable m_OperationQueueCondition;
+	bool m_ShouldExit = false;
+
+	// The completed operations and the callback called when one is posted
+	moodycamel::ConcurrentQueue<PacketReadCompletion> m_Completions;
+	std::function<void()> m_CompletionCallback;
+	std::mutex m_CompletionCallbackMutex;
+
+	// The native file handles and if each one was opened for direct I/O
+#ifdef _WIN32
+	std::vector<void*> m_FileHandles;
+#else
+	std::vector<int> m_FileHandles;
+#endif
+	std::vector<bool> m_DirectIoFiles;
+
+	// The free bounce buffers and how many bytes were read through them
+	std::vector<uint8_t*> m_BounceBuffers;
+	std::mutex m_BounceBufferMutex;
+	std::atomic<uint64_t> m_TotalBounceBufferBytes = 0;
+};
+
+// Packet data explorer
+PacketDevelopmentNamespaceEnd(Packet)
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketChecksum.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketChecksum.h"
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <nmmintrin.h>
+#define PacketChecksumX86
+#define PacketChecksumTarget
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define PacketChecksumX86
+#define PacketChecksumTarget __attribute__((target("sse4.2")))
+#endif
+
+///////////////
+// NAMESPACE //
+///////////////
+PacketUsingDevelopmentNamespace(Packet)
+
+// The reflected CRC32C polynomial
+static const uint32_t ChecksumPolynomial = 0x82F63B78;
+
+// The lookup tables used by the software implementation (slicing by 8)
+struct ChecksumTables
+{
+	ChecksumTables()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t value = i;
+			for (uint32_t j = 0; j < 8; j++)
+			{
+				value = (value >> 1) ^ ((value & 1) != 0 ? ChecksumPolynomial : 0);
+			}
+			table[0][i] = value;
+		}
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			for (uint32_t j = 1; j < 8; j++)
+			{
+				table[j][i] = (table[j - 1][i] >> 8) ^ table[0][table[j - 1][i] & 0xFF];
+			}
+		}
+	}
+
+	uint32_t table[8][256];
+};
+
+static uint32_t ComputeSoftware(const uint8_t* _data, uint64_t _size, uint32_t _checksum)
+{
+	static const ChecksumTables tables;
+	auto& table = tables.table;
+
+	// Process 8 bytes at once
+	while (_size >= 8)
+	{
+		uint32_t low;
+		uint32_t high;
+		memcpy(&low, _data, sizeof(uint32_t));
+		memcpy(&high, _data + 4, sizeof(uint32_t));
+		low ^= _checksum;
+
+		_checksum = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+			^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+
+		_data += 8;
+		_size -= 8;
+	}
+
+	while (_size > 0)
+	{
+		_checksum = (_checksum >> 8) ^ table[0][(_checksum ^ *_data) & 0xFF];
+		_data++;
+		_size--;
+	}
+
+	return _checksum;
+}
+
+#if defined(PacketChecksumX86)
+
+PacketChecksumTarget static uint32_t ComputeHardware(const uint8_t* _data, uint64_t _size, uint32_t _checksum)
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	uint64_t checksum = _checksum;
+	while (_size >= 8)
+	{
+		uint64_t value;
+		memcpy(&value, _data, sizeof(uint64_t));
+		checksum = _mm_crc32_u64(checksum, value);
+		_data += 8;
+		_size -= 8;
+	}
+	_checksum = uint32_t(checksum);
+#endif
+
+	while (_size > 0)
+	{
+		_checksum = _mm_crc32_u8(_checksum, *_data);
+		_data++;
+		_size--;
+	}
+
+	return _checksum;
+}
+
+static bool SupportsHardwareChecksum()
+{
+#if defined(_MSC_VER)
+	int registers[4];
+	__cpuid(registers, 1);
+	return (registers[2] & (1 << 20)) != 0;
+#else
+	return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+#endif
+
+uint32_t PacketChecksum::Compute(const uint8_t* _data, uint64_t _size, uint32_t _checksum)
+{
+	_checksum = ~_checksum;
+
+#if defined(PacketChecksumX86)
+	static const bool supportsHardwareChecksum = SupportsHardwareChecksum();
+	if (supportsHardwareChecksum)
+	{
+		return ~ComputeHardware(_data, _size, _checksum);
+	}
+#endif
+
+	return ~ComputeSoftware(_data, _size, _checksum);
+}
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketChecksum.h
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//////////////
+// INCLUDES //
+//////////////
+#include "PacketConfig.h"
+
+///////////////
+// NAMESPACE //
+///////////////
+
+/////////////
+// DEFINES //
+/////////////
+
+////////////
+// GLOBAL //
+////////////
+
+///////////////
+// NAMESPACE //
+///////////////
+
+// Packet data explorer
+PacketDevelopmentNamespaceBegin(Packet)
+
+////////////////
+// FORWARDING //
+////////////////
+
+////////////////
+// STRUCTURES //
+////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PacketChecksum
+////////////////////////////////////////////////////////////////////////////////
+class PacketChecksum
+{
+//////////////////
+// MAIN METHODS //
+public: //////////
+
+	// Compute the CRC32C (Castagnoli) checksum of the given data, the hardware CRC instructions are used when the
+	// processor supports them. A previous checksum can be given to continue it with more data
+	static uint32_t Compute(const uint8_t* _data, uint64_t _size, uint32_t _checksum = 0);
+};
+
+// Packet data explorer
+PacketDevelopmentNamespaceEnd(Packet)
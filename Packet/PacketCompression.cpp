@@ -0,0 +1,512 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketCompression.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketCompression.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+///////////////
+// NAMESPACE //
+///////////////
+PacketUsingDevelopmentNamespace(Packet)
+
+// The LZ4 block format constants, a match is at least 4 bytes long, the last 5 bytes are always literals and the last
+// match must start at least 12 bytes before the end of the block
+static const uint64_t MinimumMatch			= 4;
+static const uint64_t LastLiterals			= 5;
+static const uint64_t MatchFindLimit		= 12;
+static const uint64_t MaximumOffset			= 65535;
+static const uint32_t CompressionHashLog	= 16;
+
+// The dictionary training segment size and the size of the sequences counted when training
+static const uint64_t DictionarySegmentSize	= 64;
+static const uint64_t DictionarySequenceSize	= 8;
+
+// The chunk table flag used to indicate that a chunk is stored raw (it didn't shrink)
+static const uint32_t RawChunkFlag			= 0x80000000;
+
+static uint32_t ReadUnaligned32(const uint8_t* _data)
+{
+	uint32_t value;
+	memcpy(&value, _data, sizeof(uint32_t));
+	return value;
+}
+
+static uint64_t ReadUnaligned64(const uint8_t* _data)
+{
+	uint64_t value;
+	memcpy(&value, _data, sizeof(uint64_t));
+	return value;
+}
+
+static uint32_t HashSequence(uint32_t _sequence)
+{
+	return (_sequence * 2654435761U) >> (32 - CompressionHashLog);
+}
+
+uint64_t PacketCompression::GetMaximumCompressedSize(uint64_t _size)
+{
+	return _size + _size / 255 + 16;
+}
+
+// Compress the bytes between _begin and _end, the bytes before _begin (the dictionary) can be referenced by matches
+static uint64_t CompressSequences(const uint8_t* _data, uint64_t _begin, uint64_t _end, uint8_t* _dataOut, uint64_t _bufferSize)
+{
+	uint64_t outputPosition = 0;
+	uint64_t anchor = _begin;
+
+	// Write a length using the LZ4 format (the first 15 are on the token, the remaining on 255 byte steps)
+	auto WriteLength = [&](uint64_t _length)
+	{
+		for (; _length >= 255; _length -= 255)
+		{
+			_dataOut[outputPosition++] = 255;
+		}
+		_dataOut[outputPosition++] = uint8_t(_length);
+	};
+
+	// Write a sequence with the literals from the anchor up to the given position followed by a match (a match with
+	// length 0 indicates the last sequence that contains only literals)
+	auto WriteSequence = [&](uint64_t _position, uint64_t _matchOffset, uint64_t _matchLength)
+	{
+		uint64_t literalLength = _position - anchor;
+
+		// Check if the worst case for this sequence fits on the output buffer
+		if (outputPosition + 1 + literalLength + literalLength / 255 + 1 + 2 + _matchLength / 255 + 1 > _bufferSize)
+		{
+			return false;
+		}
+
+		// Write the token and the literals
+		uint8_t& token = _dataOut[outputPosition++];
+		token = uint8_t(std::min<uint64_t>(literalLength, 15) << 4);
+		if (literalLength >= 15)
+		{
+			WriteLength(literalLength - 15);
+		}
+		memcpy(&_dataOut[outputPosition], &_data[anchor], size_t(literalLength));
+		outputPosition += literalLength;
+
+		// Check if this is the last sequence
+		if (_matchLength == 0)
+		{
+			return true;
+		}
+
+		// Write the match offset and its length
+		_dataOut[outputPosition++] = uint8_t(_matchOffset);
+		_dataOut[outputPosition++] = uint8_t(_matchOffset >> 8);
+		uint64_t matchLength = _matchLength - MinimumMatch;
+		token |= uint8_t(std::min<uint64_t>(matchLength, 15));
+		if (matchLength >= 15)
+		{
+			WriteLength(matchLength - 15);
+		}
+
+		return true;
+	};
+
+	// Small blocks can't have matches
+	if (_end - _begin > MatchFindLimit)
+	{
+		// The last positions of each hashed sequence, the dictionary sequences are inserted first
+		std::vector<uint32_t> hashTable(size_t(1) << CompressionHashLog, 0);
+		for (uint64_t position = 0; position + MinimumMatch <= _begin; position++)
+		{
+			hashTable[HashSequence(ReadUnaligned32(&_data[position]))] = uint32_t(position);
+		}
+
+		uint64_t matchLimit = _end - LastLiterals;
+		uint64_t position = _begin;
+		while (position + MatchFindLimit <= _end)
+		{
+			// Find a previous position with the same sequence
+			uint32_t sequence = ReadUnaligned32(&_data[position]);
+			uint32_t& hashEntry = hashTable[HashSequence(sequence)];
+			uint64_t reference = hashEntry;
+			hashEntry = uint32_t(position);
+			if (reference >= position || position - reference > MaximumOffset || ReadUnaligned32(&_data[reference]) != sequence)
+			{
+				// Skip faster over data that doesn't compress
+				position += 1 + ((position - anchor) >> 6);
+				continue;
+			}
+
+			// Extend the match backwards and forwards
+			while (position > anchor && reference > 0 && _data[position - 1] == _data[reference - 1])
+			{
+				position--;
+				reference--;
+			}
+			uint64_t matchLength = MinimumMatch;
+			while (position + matchLength < matchLimit && _data[position + matchLength] == _data[reference + matchLength])
+			{
+				matchLength++;
+			}
+
+			// Write the sequence
+			if (!WriteSequence(position, position - reference, matchLength))
+			{
+				return 0;
+			}
+
+			// Move to the end of the match, also insert a position inside the match into the hash table
+			position += matchLength;
+			anchor = position;
+			hashTable[HashSequence(ReadUnaligned32(&_data[position - 2]))] = uint32_t(position - 2);
+		}
+	}
+
+	// Write the last literals
+	if (!WriteSequence(_end, 0, 0))
+	{
+		return 0;
+	}
+
+	return outputPosition;
+}
+
+uint64_t PacketCompression::CompressBlock(const uint8_t* _data, uint64_t _size, uint8_t* _dataOut, uint64_t _bufferSize, const uint8_t* _dictionary, uint64_t _dictionarySize)
+{
+	// Without a dictionary the block can be compressed in place
+	if (_dictionarySize == 0)
+	{
+		return CompressSequences(_data, 0, _size, _dataOut, _bufferSize);
+	}
+
+	// Compress the block as if it was placed right after the dictionary, only the dictionary end can be referenced
+	uint64_t usedDictionarySize = std::min(_dictionarySize, MaximumOffset);
+	std::vector<uint8_t> source(_dictionary + (_dictionarySize - usedDictionarySize), _dictionary + _dictionarySize);
+	source.insert(source.end(), _data, _data + _size);
+
+	return CompressSequences(source.data(), usedDictionarySize, source.size(), _dataOut, _bufferSize);
+}
+
+bool PacketCompression::DecompressBlock(const uint8_t* _data, uint64_t _size, uint8_t* _dataOut, uint64_t _outputSize, const uint8_t* _dictionary, uint64_t _dictionarySize)
+{
+	uint64_t inputPosition = 0;
+	uint64_t outputPosition = 0;
+
+	// Read a length using the LZ4 format
+	auto ReadLength = [&](uint64_t& _length)
+	{
+		uint8_t value;
+		do
+		{
+			if (inputPosition >= _size)
+			{
+				return false;
+			}
+
+			value = _data[inputPosition++];
+			_length += value;
+		} while (value == 255);
+
+		return true;
+	};
+
+	while (inputPosition < _size)
+	{
+		// Read the token and the literals
+		uint8_t token = _data[inputPosition++];
+		uint64_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(literalLength))
+		{
+			return false;
+		}
+		if (literalLength > _size - inputPosition || literalLength > _outputSize - outputPosition)
+		{
+			return false;
+		}
+		memcpy(&_dataOut[outputPosition], &_data[inputPosition], size_t(literalLength));
+		inputPosition += literalLength;
+		outputPosition += literalLength;
+
+		// The last sequence has only literals
+		if (inputPosition == _size)
+		{
+			break;
+		}
+
+		// Read the match offset and its length
+		if (_size - inputPosition < 2)
+		{
+			return false;
+		}
+		uint64_t matchOffset = uint64_t(_data[inputPosition]) | (uint64_t(_data[inputPosition + 1]) << 8);
+		inputPosition += 2;
+		uint64_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(matchLength))
+		{
+			return false;
+		}
+		matchLength += MinimumMatch;
+		if (matchOffset == 0 || matchOffset > outputPosition + _dictionarySize || matchLength > _outputSize - outputPosition)
+		{
+			return false;
+		}
+
+		// Copy the part of the match that references the dictionary end
+		uint64_t copiedLength = 0;
+		if (matchOffset > outputPosition)
+		{
+			copiedLength = std::min(matchOffset - outputPosition, matchLength);
+			memcpy(&_dataOut[outputPosition], &_dictionary[_dictionarySize - (matchOffset - outputPosition)], size_t(copiedLength));
+		}
+
+		// Copy the match, it can overlap the bytes being written
+		if (matchOffset >= matchLength && copiedLength == 0)
+		{
+			memcpy(&_dataOut[outputPosition], &_dataOut[outputPosition - matchOffset], size_t(matchLength));
+		}
+		else
+		{
+			for (uint64_t i = copiedLength; i < matchLength; i++)
+			{
+				_dataOut[outputPosition + i] = _dataOut[outputPosition + i - matchOffset];
+			}
+		}
+		outputPosition += matchLength;
+	}
+
+	return outputPosition == _outputSize;
+}
+
+std::vector<uint8_t> PacketCompression::TrainDictionary(const std::vector<std::vector<uint8_t>>& _samples, uint64_t _dictionarySize)
+{
+	// Only the last 64KB of a dictionary can be referenced
+	_dictionarySize = std::min(_dictionarySize, MaximumOffset);
+
+	// Count in how many samples each sequence appears
+	std::unordered_map<uint64_t, uint32_t> sequenceFrequencies;
+	for (auto& sample : _samples)
+	{
+		std::unordered_set<uint64_t> sampleSequences;
+		for (uint64_t position = 0; position + DictionarySequenceSize <= sample.size(); position++)
+		{
+			uint64_t sequence = ReadUnaligned64(&sample[size_t(position)]);
+			if (sampleSequences.insert(sequence).second)
+			{
+				sequenceFrequencies[sequence]++;
+			}
+		}
+	}
+
+	// Score a segment using the sequences it contains, only sequences that appear on multiple samples are useful
+	auto ScoreSegment = [&](const uint8_t* _data, uint64_t _size)
+	{
+		uint64_t score = 0;
+		for (uint64_t position = 0; position + DictionarySequenceSize <= _size; position++)
+		{
+			auto iter = sequenceFrequencies.find(ReadUnaligned64(&_data[position]));
+			score += iter != sequenceFrequencies.end() && iter->second > 1 ? iter->second - 1 : 0;
+		}
+
+		return score;
+	};
+
+	// Split each sample into segments and score them
+	struct Segment
+	{
+		const uint8_t* data;
+		uint64_t size;
+		uint64_t score;
+	};
+	std::vector<Segment> segments;
+	for (auto& sample : _samples)
+	{
+		for (uint64_t begin = 0; begin < sample.size(); begin += DictionarySegmentSize)
+		{
+			Segment segment = { &sample[size_t(begin)], std::min<uint64_t>(DictionarySegmentSize, sample.size() - begin), 0 };
+			segment.score = ScoreSegment(segment.data, segment.size);
+			if (segment.score > 0)
+			{
+				segments.push_back(segment);
+			}
+		}
+	}
+	std::stable_sort(segments.begin(), segments.end(), [](const Segment& _a, const Segment& _b)
+	{
+		return _a.score > _b.score;
+	});
+
+	// Select the best segments, the sequences of a selected segment don't count for the next ones so the dictionary
+	// doesn't end up with the same content many times
+	std::vector<const Segment*> selectedSegments;
+	uint64_t totalSize = 0;
+	for (auto& segment : segments)
+	{
+		if (totalSize + segment.size > _dictionarySize || ScoreSegment(segment.data, segment.size) * 2 < segment.score)
+		{
+			continue;
+		}
+
+		for (uint64_t position = 0; position + DictionarySequenceSize <= segment.size; position++)
+		{
+			sequenceFrequencies.erase(ReadUnaligned64(&segment.data[position]));
+		}
+
+		selectedSegments.push_back(&segment);
+		totalSize += segment.size;
+	}
+
+	// Build the dictionary, the best segments are placed at its end (closer to the data, with smaller offsets)
+	std::vector<uint8_t> dictionary;
+	dictionary.reserve(size_t(totalSize));
+	for (auto iter = selectedSegments.rbegin(); iter != selectedSegments.rend(); iter++)
+	{
+		dictionary.insert(dictionary.end(), (*iter)->data, (*iter)->data + (*iter)->size);
+	}
+
+	return dictionary;
+}
+
+bool PacketCompression::CompressEntry(CondensedCompression _compression, const uint8_t* _data, uint64_t _size, std::vector<uint8_t>& _dataOut)
+{
+	// Check if we should compress this entry
+	if (_compression == CondensedCompression::None || _size == 0)
+	{
+		return false;
+	}
+
+	// Setup the chunk table
+	uint64_t totalChunks = (_size + CompressionChunkSize - 1) / CompressionChunkSize;
+	uint64_t chunkTableSize = totalChunks * sizeof(uint32_t);
+	_dataOut.resize(size_t(chunkTableSize + GetMaximumCompressedSize(_size) + totalChunks * 16));
+
+	// Compress each chunk
+	uint64_t outputPosition = chunkTableSize;
+	for (uint64_t i = 0; i < totalChunks; i++)
+	{
+		uint64_t chunkBegin = i * CompressionChunkSize;
+		uint64_t chunkSize = std::min<uint64_t>(CompressionChunkSize, _size - chunkBegin);
+
+		// Compress this chunk, if it doesn't shrink store it raw
+		uint32_t chunkTableValue;
+		uint64_t compressedSize = CompressBlock(&_data[chunkBegin], chunkSize, &_dataOut[size_t(outputPosition)], _dataOut.size() - outputPosition);
+		if (compressedSize == 0 || compressedSize >= chunkSize)
+		{
+			memcpy(&_dataOut[size_t(outputPosition)], &_data[chunkBegin], size_t(chunkSize));
+			compressedSize = chunkSize;
+			chunkTableValue = uint32_t(chunkSize) | RawChunkFlag;
+		}
+		else
+		{
+			chunkTableValue = uint32_t(compressedSize);
+		}
+
+		memcpy(&_dataOut[size_t(i * sizeof(uint32_t))], &chunkTableValue, sizeof(uint32_t));
+		outputPosition += compressedSize;
+
+		// If we are already bigger than the original data there is no reason to continue
+		if (outputPosition >= _size)
+		{
+			return false;
+		}
+	}
+
+	_dataOut.resize(size_t(outputPosition));
+
+	return true;
+}
+
+bool PacketCompression::DecompressEntry(CondensedCompression _compression, const uint8_t* _data, uint64_t _size, uint64_t _entrySize, uint8_t* _dataOut, uint64_t _bufferSize)
+{
+	return DecompressEntryRange(_compression, _data, _size, _entrySize, 0, _dataOut, _bufferSize);
+}
+
+bool PacketCompression::DecompressEntryRange(CondensedCompression _compression, 
+                                             const uint8_t* _data, 
+                                             uint64_t _size, 
+                                             uint64_t _entrySize, 
+                                             uint64_t _offset, 
+                                             uint8_t* _dataOut, 
+                                             uint64_t _bufferSize)
+{
+	// Check if we support this compression and if the range is inside the entry
+	if (_compression != CondensedCompression::LZ4 || _offset > _entrySize || _bufferSize > _entrySize - _offset)
+	{
+		return false;
+	}
+
+	// Check if the chunk table is valid
+	uint64_t totalChunks = (_entrySize + CompressionChunkSize - 1) / CompressionChunkSize;
+	uint64_t chunkTableSize = totalChunks * sizeof(uint32_t);
+	if (chunkTableSize > _size)
+	{
+		return false;
+	}
+
+	// Find where each chunk data begins
+	std::vector<uint64_t> chunkLocations(size_t(totalChunks + 1), chunkTableSize);
+	for (uint64_t i = 0; i < totalChunks; i++)
+	{
+		uint32_t chunkTableValue = ReadUnaligned32(&_data[i * sizeof(uint32_t)]);
+		chunkLocations[size_t(i + 1)] = chunkLocations[size_t(i)] + (chunkTableValue & ~RawChunkFlag);
+	}
+	if (chunkLocations.back() > _size)
+	{
+		return false;
+	}
+
+	// Decompress a chunk, only the bytes that are inside the range are written
+	auto DecompressChunk = [&](uint64_t _chunkIndex)
+	{
+		uint64_t chunkBegin = _chunkIndex * CompressionChunkSize;
+		uint64_t chunkSize = std::min<uint64_t>(CompressionChunkSize, _entrySize - chunkBegin);
+		uint64_t chunkDataSize = chunkLocations[size_t(_chunkIndex + 1)] - chunkLocations[size_t(_chunkIndex)];
+		const uint8_t* chunkData = &_data[chunkLocations[size_t(_chunkIndex)]];
+		bool isRaw = (ReadUnaligned32(&_data[_chunkIndex * sizeof(uint32_t)]) & RawChunkFlag) != 0;
+		uint64_t outputBegin = std::max(chunkBegin, _offset);
+		uint64_t outputSize = std::min(chunkBegin + chunkSize, _offset + _bufferSize) - outputBegin;
+
+		// Raw chunks are just copied
+		if (isRaw)
+		{
+			if (chunkDataSize != chunkSize)
+			{
+				return false;
+			}
+
+			memcpy(&_dataOut[outputBegin - _offset], &chunkData[outputBegin - chunkBegin], size_t(outputSize));
+			return true;
+		}
+
+		// If the whole chunk fits decompress it in place, else use a temporary buffer
+		if (outputSize == chunkSize)
+		{
+			return DecompressBlock(chunkData, chunkDataSize, &_dataOut[chunkBegin - _offset], chunkSize);
+		}
+
+		std::vector<uint8_t> chunkBuffer(static_cast<size_t>(chunkSize));
+		if (!DecompressBlock(chunkData, chunkDataSize, chunkBuffer.data(), chunkSize))
+		{
+			return false;
+		}
+		memcpy(&_dataOut[outputBegin - _offset], &chunkBuffer[size_t(outputBegin - chunkBegin)], size_t(outputSize));
+
+		return true;
+	};
+
+	// Only the chunks that intersect the range are needed
+	if (_bufferSize == 0)
+	{
+		return true;
+	}
+	uint64_t firstNeededChunk = _offset / CompressionChunkSize;
+	uint64_t totalNeededChunks = (_offset + _bufferSize + CompressionChunkSize - 1) / CompressionChunkSize - firstNeededChunk;
+
+	// The chunks are decompressed on the calling thread, entries are already spread across the loader threads so
+	// spawning more threads here would only oversubscribe them
+	for (uint64_t i = 0; i < totalNeededChunks; i++)
+	{
+		if (!DecompressChunk(firstNeededChunk + i))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketCompression.h
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//////////////
+// INCLUDES //
+//////////////
+#include "PacketConfig.h"
+
+#include <vector>
+
+///////////////
+// NAMESPACE //
+///////////////
+
+/////////////
+// DEFINES //
+/////////////
+
+////////////
+// GLOBAL //
+////////////
+
+///////////////
+// NAMESPACE //
+///////////////
+
+// Packet data explorer
+PacketDevelopmentNamespaceBegin(Packet)
+
+////////////////
+// FORWARDING //
+////////////////
+
+////////////////
+// STRUCTURES //
+////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PacketCompression
+////////////////////////////////////////////////////////////////////////////////
+class PacketCompression
+{
+//////////////////
+// MAIN METHODS //
+public: //////////
+
+	// Return the maximum size a block with the given size can have after being compressed
+	static uint64_t GetMaximumCompressedSize(uint64_t _size);
+
+	// Compress a block using the LZ4 block format, returns the compressed size or 0 if the output buffer is too small.
+	// If a dictionary is given the block can reference its last 64KB as if they were placed right before the block
+	static uint64_t CompressBlock(const uint8_t* _data, uint64_t _size, uint8_t* _dataOut, uint64_t _bufferSize, const uint8_t* _dictionary = nullptr, uint64_t _dictionarySize = 0);
+
+	// Decompress a LZ4 block, the output size must match the original block size exactly and the dictionary must be
+	// the same used when compressing. All reads and writes are bounds checked so a corrupted block will only make this
+	// method return false
+	static bool DecompressBlock(const uint8_t* _data, uint64_t _size, uint8_t* _dataOut, uint64_t _outputSize, const uint8_t* _dictionary = nullptr, uint64_t _dictionarySize = 0);
+
+	// Train a dictionary (at most 64KB) using the given samples, it will contain the sample segments with the most 
+	// common sequences between different samples
+	static std::vector<uint8_t> TrainDictionary(const std::vector<std::vector<uint8_t>>& _samples, uint64_t _dictionarySize);
+
+	// Compress an entry using the given compression, the entry is split into chunks of CompressionChunkSize bytes
+	// that are compressed independently (so only the chunks that are needed must be decompressed), a chunk table 
+	// with each chunk stored size precedes the chunk data. Returns false if the compressed entry wouldn't be smaller 
+	// than the original data, in this case the entry should be stored raw
+	static bool CompressEntry(CondensedCompression _compression, const uint8_t* _data, uint64_t _size, std::vector<uint8_t>& _dataOut);
+
+	// Decompress the first _bufferSize bytes of an entry compressed with CompressEntry(), the chunks are decompressed
+	// on the calling thread
+	static bool DecompressEntry(CondensedCompression _compression, const uint8_t* _data, uint64_t _size, uint64_t _entrySize, uint8_t* _dataOut, uint64_t _bufferSize);
+
+	// Decompress _bufferSize bytes of an entry compressed with CompressEntry(), beginning at the given offset. Only the
+	// chunks that intersect the range are decompressed
+	static bool DecompressEntryRange(
+        CondensedCompression _compression, 
+        const uint8_t* _data, 
+        uint64_t _size, 
+        uint64_t _entrySize, 
+        uint64_t _offset, 
+        uint8_t* _dataOut, 
+        uint64_t _bufferSize);
+};
+
+// Packet data explorer
+PacketDevelopmentNamespaceEnd(Packet)
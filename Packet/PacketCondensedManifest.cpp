@@ -0,0 +1,463 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketCondensedManifest.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketCondensedManifest.h"
+#include <algorithm>
+#include <unordered_map>
+#include <fstream>
+#include <chrono>
+#include <functional>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PacketPrefetch(_address) _mm_prefetch(reinterpret_cast<const char*>(_address), _MM_HINT_T0)
+#else
+#define PacketPrefetch(_address) __builtin_prefetch(_address)
+#endif
+
+///////////////
+// NAMESPACE //
+///////////////
+PacketUsingDevelopmentNamespace(Packet)
+
+// Align a manifest location to 8 bytes so each table can be used directly from the mapped memory
+static uint64_t AlignManifestLocation(uint64_t _location)
+{
+	return (_location + 7) & ~uint64_t(7);
+}
+
+PacketCondensedManifest::PacketCondensedManifest()
+{
+	// Set the initial data
+	// ...
+}
+
+PacketCondensedManifest::~PacketCondensedManifest()
+{
+}
+
+bool PacketCondensedManifest::Write(const std::string& _manifestPath, 
+                                    const std::vector<CondensedFileInfo>& _condensedFileInfos, 
+                                    const std::vector<Hash>& _removedFiles, 
+                                    const std::vector<uint8_t>& _dictionary, 
+                                    uint32_t _alignment, 
+                                    PacketLogger* _logger)
+{
+	// The string table and a map used to deduplicate its strings, the location 0 is always the empty string
+	std::vector<char> stringTable(1, '\0');
+	std::unordered_map<std::string, uint32_t> stringLocations = { { std::string(), 0 } };
+
+	// Insert a string into the string table (if it isn't there yet) and return its location
+	auto InsertString = [&](const std::string& _string)
+	{
+		auto iter = stringLocations.find(_string);
+		if (iter != stringLocations.end())
+		{
+			return iter->second;
+		}
+
+		uint32_t location = uint32_t(stringTable.size());
+		stringTable.insert(stringTable.end(), _string.begin(), _string.end());
+		stringTable.push_back('\0');
+		stringLocations.insert({ _string, location });
+
+		return location;
+	};
+
+	// Split an entry path into its directory and name and insert both, many entries share the same directory (and 
+	// sometimes the same name) so both parts are deduplicated independently
+	auto InsertEntryPath = [&](CondensedEntryInfo& _entryInfo, const std::string& _entryPath)
+	{
+		size_t separatorPosition = _entryPath.find_last_of("/\\");
+		size_t nameStart = separatorPosition == std::string::npos ? 0 : separatorPosition + 1;
+		_entryInfo.directoryLocation = InsertString(_entryPath.substr(0, nameStart));
+		_entryInfo.nameLocation = InsertString(_entryPath.substr(nameStart));
+	};
+
+	// The pack, entry and block tables
+	std::vector<CondensedPackInfo> packTable;
+	std::vector<CondensedEntryInfo> entryTable;
+	std::vector<CondensedBlockInfo> blockTable;
+
+	// For each condensed file info
+	for (auto& condensedFileInfo : _condensedFileInfos)
+	{
+		// Setup the pack info
+		CondensedPackInfo packInfo = {};
+		packInfo.size = condensedFileInfo.fileSize;
+		packInfo.pathLocation = InsertString(condensedFileInfo.filePath.String());
+		packInfo.totalEntries = uint32_t(condensedFileInfo.fileInfos.size());
+
+		// The block indices stored on each internal file info are relative to its condensed file
+		uint32_t firstBlockIndex = uint32_t(blockTable.size());
+
+		// For each internal block info
+		for (auto& internalBlockInfo : condensedFileInfo.blockInfos)
+		{
+			// Setup the block info and insert it
+			CondensedBlockInfo blockInfo = {};
+			blockInfo.location = internalBlockInfo.location;
+			blockInfo.storedSize = internalBlockInfo.storedSize;
+			blockInfo.size = internalBlockInfo.size;
+			blockInfo.packIndex = uint32_t(packTable.size());
+			blockInfo.flags = uint32_t(internalBlockInfo.compression) & CondensedEntryCompressionMask;
+			blockInfo.checksum = internalBlockInfo.checksum;
+			blockTable.push_back(blockInfo);
+		}
+
+		// For each internal file info
+		for (auto& internalFileInfo : condensedFileInfo.fileInfos)
+		{
+			// Setup the entry info
+			CondensedEntryInfo entryInfo = {};
+			entryInfo.hash = uint64_t(internalFileInfo.hash.GetHashValue());
+			entryInfo.location = internalFileInfo.location;
+			entryInfo.size = internalFileInfo.size;
+			entryInfo.time = internalFileInfo.time;
+			entryInfo.storedSize = internalFileInfo.storedSize;
+			entryInfo.packIndex = uint32_t(packTable.size());
+			entryInfo.flags = uint32_t(internalFileInfo.compression) & CondensedEntryCompressionMask;
+			entryInfo.checksum = internalFileInfo.checksum;
+			InsertEntryPath(entryInfo, Hash(internalFileInfo.hash).GetPath().String());
+
+			// Check if this entry is inside a solid block
+			if (internalFileInfo.isSolid)
+			{
+				entryInfo.flags |= CondensedEntrySolidFlag;
+				entryInfo.blockIndex = firstBlockIndex + internalFileInfo.blockIndex;
+				entryInfo.blockOffset = internalFileInfo.blockOffset;
+			}
+
+			// Insert it
+			entryTable.push_back(entryInfo);
+		}
+
+		// Insert the pack info
+		packTable.push_back(packInfo);
+	}
+
+	// For each removed file, insert a tombstone entry (it has no data)
+	for (auto& removedFile : _removedFiles)
+	{
+		CondensedEntryInfo entryInfo = {};
+		entryInfo.hash = uint64_t(removedFile.GetHashValue());
+		entryInfo.flags = CondensedEntryTombstoneFlag;
+		InsertEntryPath(entryInfo, Hash(removedFile).GetPath().String());
+		entryTable.push_back(entryInfo);
+	}
+
+	// Sort the entries by their hashes
+	std::sort(entryTable.begin(), entryTable.end(), [](const CondensedEntryInfo& _a, const CondensedEntryInfo& _b)
+	{
+		return _a.hash < _b.hash;
+	});
+
+	// Reorder the entries using an Eytzinger (breadth-first binary tree) layout, this way a lookup walks the index
+	// table from its beginning and the first levels (that are visited by every lookup) always share the same cache
+	// lines. The index table contains only the entry hashes (1-based, slot 0 is unused) so each cache line holds
+	// 8 tree nodes, the entry at index i - 1 has the hash stored at the index slot i
+	std::vector<CondensedEntryInfo> sortedEntryTable = std::move(entryTable);
+	std::vector<uint32_t> eytzingerOrder = ComputeEytzingerOrder(uint32_t(sortedEntryTable.size()));
+	std::vector<uint64_t> indexTable(sortedEntryTable.size() + 1, 0);
+	entryTable.resize(sortedEntryTable.size());
+	for (size_t i = 0; i < eytzingerOrder.size(); i++)
+	{
+		entryTable[i] = sortedEntryTable[eytzingerOrder[i]];
+		indexTable[i + 1] = entryTable[i].hash;
+	}
+
+	// Setup the header
+	CondensedHeaderInfo header = {};
+	header.saveTime = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
+	header.magic = CondensedManifestMagic;
+	header.majorVersion = CondensedMajorVersion;
+	header.minorVersion = CondensedMinorVersion;
+	header.totalPacks = uint32_t(packTable.size());
+	header.totalEntries = uint32_t(entryTable.size());
+	header.totalBlocks = uint32_t(blockTable.size());
+	header.alignment = _alignment;
+	header.packTableLocation = AlignManifestLocation(sizeof(CondensedHeaderInfo));
+	header.indexTableLocation = AlignManifestLocation(header.packTableLocation + sizeof(CondensedPackInfo) * packTable.size());
+	header.entryTableLocation = AlignManifestLocation(header.indexTableLocation + sizeof(uint64_t) * indexTable.size());
+	header.blockTableLocation = AlignManifestLocation(header.entryTableLocation + sizeof(CondensedEntryInfo) * entryTable.size());
+	header.stringTableLocation = AlignManifestLocation(header.blockTableLocation + sizeof(CondensedBlockInfo) * blockTable.size());
+	header.stringTableSize = uint64_t(stringTable.size());
+	header.dictionaryLocation = AlignManifestLocation(header.stringTableLocation + header.stringTableSize);
+	header.dictionarySize = uint64_t(_dictionary.size());
+
+	// Create the file and check if we are ok to proceed
+	std::ofstream file(_manifestPath, std::ios::binary);
+	if (!file.is_open())
+	{
+		// Error openning the file!
+		_logger->LogError(std::string("Error trying to create the manifest file: ").append(_manifestPath).c_str());
+
+		return false;
+	}
+
+	// Write a block of data at the given location, padding the file if necessary
+	auto WriteAt = [&](uint64_t _location, const void* _data, uint64_t _size)
+	{
+		static const char padding[8] = {};
+		file.write(padding, std::streamsize(_location - uint64_t(file.tellp())));
+		file.write(static_cast<const char*>(_data), std::streamsize(_size));
+	};
+
+	// Write the header and all tables
+	WriteAt(0, &header, sizeof(CondensedHeaderInfo));
+	WriteAt(header.packTableLocation, packTable.data(), sizeof(CondensedPackInfo) * packTable.size());
+	WriteAt(header.indexTableLocation, indexTable.data(), sizeof(uint64_t) * indexTable.size());
+	WriteAt(header.entryTableLocation, entryTable.data(), sizeof(CondensedEntryInfo) * entryTable.size());
+	WriteAt(header.blockTableLocation, blockTable.data(), sizeof(CondensedBlockInfo) * blockTable.size());
+	WriteAt(header.stringTableLocation, stringTable.data(), stringTable.size());
+	WriteAt(header.dictionaryLocation, _dictionary.data(), _dictionary.size());
+	if (!file)
+	{
+		// Error writing the file!
+		_logger->LogError(std::string("Error writing the manifest file: ").append(_manifestPath).c_str());
+
+		return false;
+	}
+
+	// Close the file
+	file.close();
+
+	return true;
+}
+
+bool PacketCondensedManifest::Open(const std::string& _manifestPath, PacketLogger* _logger)
+{
+	// Map the file
+	if (!m_File.Open(_manifestPath))
+	{
+		_logger->LogError(std::string("Error trying to open the manifest file: ").append(_manifestPath).c_str());
+
+		return false;
+	}
+
+	// Get the header
+	m_Header = reinterpret_cast<const CondensedHeaderInfo*>(m_File.GetData(0, sizeof(CondensedHeaderInfo)));
+
+	// Check the version, the major version is always stored at the same location so older manifests can be detected
+	if (m_Header == nullptr || m_Header->majorVersion != CondensedMajorVersion)
+	{
+		_logger->LogError(std::string("The manifest file: ")
+			.append(_manifestPath)
+			.append(m_Header == nullptr ? std::string(" is too small to be valid") :
+				std::string(" has major version ").append(std::to_string(m_Header->majorVersion)))
+			.append(" but the expected major version is ")
+			.append(std::to_string(CondensedMajorVersion))
+			.append(", the condensed files must be constructed again!")
+			.c_str());
+
+		m_File.Close();
+		m_Header = nullptr;
+
+		return false;
+	}
+
+	// Get each table, GetData() will return nullptr if any table is outside the file bounds
+	m_Packs = reinterpret_cast<const CondensedPackInfo*>(m_File.GetData(m_Header->packTableLocation, sizeof(CondensedPackInfo) * uint64_t(m_Header->totalPacks)));
+	m_Index = reinterpret_cast<const uint64_t*>(m_File.GetData(m_Header->indexTableLocation, sizeof(uint64_t) * (uint64_t(m_Header->totalEntries) + 1)));
+	m_Entries = reinterpret_cast<const CondensedEntryInfo*>(m_File.GetData(m_Header->entryTableLocation, sizeof(CondensedEntryInfo) * uint64_t(m_Header->totalEntries)));
+	m_Blocks = reinterpret_cast<const CondensedBlockInfo*>(m_File.GetData(m_Header->blockTableLocation, sizeof(CondensedBlockInfo) * uint64_t(m_Header->totalBlocks)));
+	m_Strings = reinterpret_cast<const char*>(m_File.GetData(m_Header->stringTableLocation, m_Header->stringTableSize));
+	m_Dictionary = m_File.GetData(m_Header->dictionaryLocation, m_Header->dictionarySize);
+
+	// Validate the manifest identifier, the tables and check if the string table is terminated
+	if (m_Header->magic != CondensedManifestMagic
+		|| m_Packs == nullptr
+		|| m_Index == nullptr
+		|| m_Entries == nullptr
+		|| m_Blocks == nullptr
+		|| m_Strings == nullptr
+		|| m_Dictionary == nullptr
+		|| m_Header->stringTableSize == 0
+		|| m_Strings[m_Header->stringTableSize - 1] != '\0'
+		|| (m_Header->alignment & (m_Header->alignment - 1)) != 0)
+	{
+		_logger->LogError(std::string("The manifest file: ").append(_manifestPath).append(" is corrupted!").c_str());
+
+		m_File.Close();
+		m_Header = nullptr;
+		m_Packs = nullptr;
+		m_Index = nullptr;
+		m_Entries = nullptr;
+		m_Blocks = nullptr;
+		m_Strings = nullptr;
+		m_Dictionary = nullptr;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool PacketCondensedManifest::IsOpen() const
+{
+	return m_Header != nullptr;
+}
+
+const CondensedHeaderInfo& PacketCondensedManifest::GetHeader() const
+{
+	return *m_Header;
+}
+
+uint32_t PacketCondensedManifest::GetTotalPacks() const
+{
+	return m_Header != nullptr ? m_Header->totalPacks : 0;
+}
+
+const CondensedPackInfo& PacketCondensedManifest::GetPack(uint32_t _packIndex) const
+{
+	return m_Packs[_packIndex];
+}
+
+uint32_t PacketCondensedManifest::GetTotalEntries() const
+{
+	return m_Header != nullptr ? m_Header->totalEntries : 0;
+}
+
+const CondensedEntryInfo* PacketCondensedManifest::GetEntries() const
+{
+	return m_Entries;
+}
+
+uint32_t PacketCondensedManifest::GetTotalBlocks() const
+{
+	return m_Header != nullptr ? m_Header->totalBlocks : 0;
+}
+
+const CondensedBlockInfo& PacketCondensedManifest::GetBlock(uint32_t _blockIndex) const
+{
+	return m_Blocks[_blockIndex];
+}
+
+const uint8_t* PacketCondensedManifest::GetDictionary() const
+{
+	return m_Dictionary;
+}
+
+uint64_t PacketCondensedManifest::GetDictionarySize() const
+{
+	return m_Header != nullptr ? m_Header->dictionarySize : 0;
+}
+
+uint32_t PacketCondensedManifest::GetAlignment() const
+{
+	return m_Header != nullptr ? m_Header->alignment : 0;
+}
+
+std::vector<uint32_t> PacketCondensedManifest::ComputeEytzingerOrder(uint32_t _totalNodes)
+{
+	// An in-order walk on the tree visits the nodes in sorted order
+	std::vector<uint32_t> order(_totalNodes);
+	uint32_t sortedIndex = 0;
+	std::function<void(uint64_t)> VisitNode = [&](uint64_t _node)
+	{
+		if (_node > _totalNodes)
+		{
+			return;
+		}
+
+		VisitNode(2 * _node);
+		order[_node - 1] = sortedIndex++;
+		VisitNode(2 * _node + 1);
+	};
+	VisitNode(1);
+
+	return order;
+}
+
+uint64_t PacketCondensedManifest::FindEytzingerNode(const uint64_t* _index, uint64_t _totalNodes, HashPrimitive _hash)
+{
+	// Walk the Eytzinger index, the children of the node i are the nodes 2i and 2i + 1
+	uint64_t node = 1;
+	while (node <= _totalNodes)
+	{
+		// The 16 possible descendants 4 levels below are contiguous, prefetching them while we walk the current levels
+		// hides most of the memory latency on big indices
+		PacketPrefetch(_index + std::min(node * 16, _totalNodes));
+
+		uint64_t nodeHash = _index[node];
+		if (nodeHash == uint64_t(_hash))
+		{
+			return node;
+		}
+
+		node = 2 * node + (nodeHash < uint64_t(_hash) ? 1 : 0);
+	}
+
+	return 0;
+}
+
+const CondensedEntryInfo* PacketCondensedManifest::FindEntry(HashPrimitive _hash) const
+{
+	uint64_t node = FindEytzingerNode(m_Index, GetTotalEntries(), _hash);
+
+	return node != 0 ? &m_Entries[node - 1] : nullptr;
+}
+
+uint64_t PacketCondensedManifest::CountAccessSeeks(const std::vector<Hash>& _accessTrace) const
+{
+	uint64_t totalSeeks = 0;
+	uint32_t currentPackIndex = std::numeric_limits<uint32_t>::max();
+	uint64_t currentBegin = 0;
+	uint64_t currentEnd = 0;
+	uint64_t alignment = std::max(uint64_t(GetAlignment()), uint64_t(1));
+
+	// For each load
+	for (auto& hash : _accessTrace)
+	{
+		const CondensedEntryInfo* entryInfo = FindEntry(hash.GetHashValue());
+		if (entryInfo == nullptr)
+		{
+			continue;
+		}
+
+		// Get the data range read, solid entries read their whole block
+		uint64_t begin = entryInfo->location;
+		uint64_t end = entryInfo->location + entryInfo->storedSize;
+		if ((entryInfo->flags & CondensedEntrySolidFlag) != 0 && entryInfo->blockIndex < GetTotalBlocks())
+		{
+			const CondensedBlockInfo& blockInfo = GetBlock(entryInfo->blockIndex);
+			begin = blockInfo.location;
+			end = blockInfo.location + blockInfo.storedSize;
+		}
+
+		// Check if this data is already in place or if it begins right after the previous one
+		bool isSequential = entryInfo->packIndex == currentPackIndex 
+			&& ((begin == currentBegin && end == currentEnd) || (begin >= currentEnd && begin - currentEnd < alignment));
+		if (!isSequential)
+		{
+			totalSeeks++;
+		}
+
+		currentPackIndex = entryInfo->packIndex;
+		currentBegin = begin;
+		currentEnd = end;
+	}
+
+	return totalSeeks;
+}
+
+std::string PacketCondensedManifest::GetPackPath(const CondensedPackInfo& _packInfo) const
+{
+	return GetString(_packInfo.pathLocation);
+}
+
+std::string PacketCondensedManifest::GetEntryPath(const CondensedEntryInfo& _entryInfo) const
+{
+	return std::string(GetString(_entryInfo.directoryLocation)).append(GetString(_entryInfo.nameLocation));
+}
+
+const char* PacketCondensedManifest::GetString(uint32_t _location) const
+{
+	if (m_Strings == nullptr || _location >= m_Header->stringTableSize)
+	{
+		return "";
+	}
+
+	return m_Strings + _location;
+}
@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketCondensedManifest.h
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//////////////
+// INCLUDES //
+//////////////
+#include "PacketConfig.h"
+#include "PacketMappedFile.h"
+
+#include <string>
+#include <vector>
+
+///////////////
+// NAMESPACE //
+///////////////
+
+/////////////
+// DEFINES //
+/////////////
+
+////////////
+// GLOBAL //
+////////////
+
+///////////////
+// NAMESPACE //
+///////////////
+
+// Packet data explorer
+PacketDevelopmentNamespaceBegin(Packet)
+
+////////////////
+// FORWARDING //
+////////////////
+
+////////////////
+// STRUCTURES //
+////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PacketCondensedManifest
+////////////////////////////////////////////////////////////////////////////////
+class PacketCondensedManifest
+{
+//////////////////
+// CONSTRUCTORS //
+public: //////////
+
+	// Constructor / destructor
+	PacketCondensedManifest();
+	~PacketCondensedManifest();
+
+//////////////////
+// MAIN METHODS //
+public: //////////
+
+	// Write a manifest file for the given condensed file infos. The manifest is composed by a header, a table with all
+	// condensed files, an index table with the entry hashes (using an Eytzinger layout), a table with all entries (in the
+	// same order as the index), a table with all solid blocks, a table with all deduplicated path strings and the 
+	// dictionary shared by the solid blocks. The alignment used by the condensed files is recorded on the header. The
+	// removed files are written as tombstone entries, they hide the files with the same hash on lower overlay layers
+	static bool Write(const std::string& _manifestPath, 
+	                  const std::vector<CondensedFileInfo>& _condensedFileInfos, 
+	                  const std::vector<Hash>& _removedFiles, 
+	                  const std::vector<uint8_t>& _dictionary, 
+	                  uint32_t _alignment, 
+	                  PacketLogger* _logger);
+
+	// Return, for each node of an Eytzinger layout with the given size (node i is at position i - 1), the position of
+	// the sorted element it holds
+	static std::vector<uint32_t> ComputeEytzingerOrder(uint32_t _totalNodes);
+
+	// Walk an Eytzinger index (1-based, slot 0 is unused) looking for the given hash, returns its node or 0 if the 
+	// hash isn't there
+	static uint64_t FindEytzingerNode(const uint64_t* _index, uint64_t _totalNodes, HashPrimitive _hash);
+
+	// Map a manifest file and validate it, the manifest data is used in place (nothing is parsed or copied), manifests
+	// with a different major version are rejected
+	bool Open(const std::string& _manifestPath, PacketLogger* _logger);
+
+	// Return if a manifest is currently open
+	bool IsOpen() const;
+
+	// Return the manifest header
+	const CondensedHeaderInfo& GetHeader() const;
+
+	// Return the total number of condensed files and a condensed file info
+	uint32_t GetTotalPacks() const;
+	const CondensedPackInfo& GetPack(uint32_t _packIndex) const;
+
+	// Return the total number of entries and a pointer to the first one (entries are not sorted)
+	uint32_t GetTotalEntries() const;
+	const CondensedEntryInfo* GetEntries() const;
+
+	// Return the total number of solid blocks and a solid block info
+	uint32_t GetTotalBlocks() const;
+	const CondensedBlockInfo& GetBlock(uint32_t _blockIndex) const;
+
+	// Return the dictionary shared by all solid blocks and its size
+	const uint8_t* GetDictionary() const;
+	uint64_t GetDictionarySize() const;
+
+	// Return the alignment used by the aligned entries and solid blocks inside the condensed files, 0 if none
+	uint32_t GetAlignment() const;
+
+	// Find the entry with the given hash using a single walk on the index table, returns nullptr if there is no entry
+	// with it (tombstone entries are returned too)
+	const CondensedEntryInfo* FindEntry(HashPrimitive _hash) const;
+
+	// Return how many seeks are needed to load the given entries in order, a load doesn't need a seek if its data
+	// begins where the previous load data ended (alignment gaps are ignored) or if both are inside the same solid block
+	uint64_t CountAccessSeeks(const std::vector<Hash>& _accessTrace) const;
+
+	// Return the path for a condensed file or for an entry
+	std::string GetPackPath(const CondensedPackInfo& _packInfo) const;
+	std::string GetEntryPath(const CondensedEntryInfo& _entryInfo) const;
+
+private:
+
+	// Return a string from the string table, returns an empty string if the location is invalid
+	const char* GetString(uint32_t _location) const;
+
+///////////////
+// VARIABLES //
+private: //////
+
+	// The mapped manifest file
+	PacketMappedFile m_File;
+
+	// The manifest tables (pointing directly to the mapped memory)
+	const CondensedHeaderInfo* m_Header     = nullptr;
+	const CondensedPackInfo*   m_Packs      = nullptr;
+	const uint64_t*            m_Index      = nullptr;
+	const CondensedEntryInfo*  m_Entries    = nullptr;
+	const CondensedBlockInfo*  m_Blocks     = nullptr;
+	const char*                m_Strings    = nullptr;
+	const uint8_t*             m_Dictionary = nullptr;
+};
+
+// Packet data explorer
+PacketDevelopmentNamespaceEnd(Packet)
@@ -2,17 +2,39 @@
 // Filename: FluxMyWrapper.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "PacketCondensedModeFileLoader.h"
+#include "PacketCompression.h"
+#include "PacketChecksum.h"
 #include <filesystem>
+#include <cstring>
+#include <chrono>
+#include <unordered_set>
+#include <algorithm>
 
 ///////////////
 // NAMESPACE //
 ///////////////
 PacketUsingDevelopmentNamespace(Packet)
 
-PacketCondensedModeFileLoader::PacketCondensedModeFileLoader(std::string _packetManifestDirectory, PacketLogger* _logger) : PacketFileLoader(_packetManifestDirectory, _logger)
+PacketCondensedModeFileLoader::PacketCondensedModeFileLoader(std::string _packetManifestDirectory, 
+                                                             PacketLogger* _logger, 
+                                                             CondensedReaderMode _readerMode, 
+                                                             uint64_t _solidBlockCacheSize, 
+                                                             CondensedVerifyMode _verifyMode, 
+                                                             std::vector<std::string> _overlayDirectories, 
+                                                             AsyncReadMode _asyncReadMode, 
+                                                             uint32_t _asyncReadQueueDepth, 
+                                                             uint32_t _asyncReadThreads, 
+                                                             uint64_t _readCoalesceGap, 
+                                                             uint64_t _directReadMinimumSize) : 
+	PacketFileLoader(_packetManifestDirectory, _logger), 
+	m_ReaderMode(_readerMode), 
+	m_VerifyMode(_verifyMode), 
+	m_ReadCoalesceGap(_readCoalesceGap), 
+	m_DirectReadMinimumSize(_directReadMinimumSize), 
+	m_SolidBlockCacheMaximumSize(_solidBlockCacheSize)
 {
 	// Load the packet data
-	m_PackedDataLoaded = ReadPacketData(_packetManifestDirectory);
+	m_PackedDataLoaded = ReadPacketData(_packetManifestDirectory, _overlayDirectories);
 	if (!m_PackedDataLoaded)
 	{
 		// Error!
@@ -22,12 +44,40 @@ PacketCondensedModeFileLoader::PacketCondensedModeFileLoader(std::string _packet
 	// Process the packet data
 	ProcessPacketData();
 
+	// Setup the asynchronous reads, each condensed file is opened once more for the direct reads when they are useful 
+	// (when io_uring is used or when a stream would be used instead, on mapped mode without io_uring the worker threads
+	// copy the mapped data)
+	m_AsyncReader.Initialize(_asyncReadMode, _asyncReadQueueDepth, _asyncReadThreads, m_Logger);
+	bool useDirectReads = m_AsyncReader.UsesIoUring() || m_ReaderMode == CondensedReaderMode::Stream;
+	for (auto& reader : m_FileReaders)
+	{
+		if (useDirectReads && !m_AsyncReader.OpenFile(reader.filePath, reader.asyncFileIndex))
+		{
+			reader.asyncFileIndex = std::numeric_limits<uint32_t>::max();
+		}
+
+		// Files that can contain a read big enough to use direct I/O are opened again for it, if the file system 
+		// doesn't support direct I/O the buffered reads are used instead
+		std::error_code errorCode;
+		uint64_t fileSize = std::filesystem::file_size(reader.filePath, errorCode);
+		if (m_DirectReadMinimumSize != 0 
+			&& !errorCode 
+			&& fileSize >= m_DirectReadMinimumSize 
+			&& !m_AsyncReader.OpenFile(reader.filePath, reader.directFileIndex, true))
+		{
+			reader.directFileIndex = std::numeric_limits<uint32_t>::max();
+		}
+	}
+
 	// Set the initial data
 	// ...
 }
 
 PacketCondensedModeFileLoader::~PacketCondensedModeFileLoader()
 {
+	// Finish the queued asynchronous reads before closing our files
+	m_AsyncReader.Release();
+
 	// For each condensed file reader
 	for (auto& reader : m_FileReaders)
 	{
@@ -42,60 +92,401 @@ PacketCondensedModeFileLoader::~PacketCondensedModeFileLoader()
 
 bool PacketCondensedModeFileLoader::FileExist(Hash _fileHash) const
 {
-	// Check if we have this file inside our mapped files
-	if (m_MappedInternalFileInfos.find(_fileHash) != m_MappedInternalFileInfos.end())
+	// Check if we have this file inside our layers
+	const CondensedLayer* layer = nullptr;
+	return FindEntry(_fileHash, layer) != nullptr;
+}
+
+uint64_t PacketCondensedModeFileLoader::GetFileSize(Hash _fileHash) const
+{
+	// Get the file info
+	const CondensedLayer* layer = nullptr;
+	const CondensedEntryInfo* entryInfo = FindEntry(_fileHash, layer);
+	if (entryInfo == nullptr)
 	{
-		return true;
+		// Invalid file
+		return 0;
 	}
 
-	return false;
+	return entryInfo->size;
 }
 
-uint64_t PacketCondensedModeFileLoader::GetFileSize(Hash _fileHash) const
+bool PacketCondensedModeFileLoader::GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const
 {
+	// Get the file info
+	const CondensedLayer* layer = nullptr;
+	const CondensedEntryInfo* entryInfo = FindEntry(_fileHash, layer);
+	if (entryInfo == nullptr || !ReadEntryData(_dataOut, 0, _bufferSize, *entryInfo, *layer, _fileHash))
+	{
+		return false;
+	}
 
-#ifndef NDEBUG
+	RecordRead(_bufferSize);
 
-	// If the file exist
-	if (!FileExist(_fileHash))
+	return true;
+}
+
+bool PacketCondensedModeFileLoader::ReadRange(Hash _fileHash, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const
+{
+	// Get the file info
+	const CondensedLayer* layer = nullptr;
+	const CondensedEntryInfo* entryInfo = FindEntry(_fileHash, layer);
+	if (entryInfo == nullptr || !ReadEntryData(_dataOut, _offset, _size, *entryInfo, *layer, _fileHash))
+	{
+		return false;
+	}
+
+	RecordRead(_size);
+
+	return true;
+}
+
+uint32_t PacketCondensedModeFileLoader::GetReadAlignment(Hash _fileHash, uint64_t _offset, uint64_t _size) const
+{
+	// Get the file info and check if the read uses direct I/O
+	const CondensedLayer* layer = nullptr;
+	const CondensedEntryInfo* entryInfo = FindEntry(_fileHash, layer);
+	const CondensedFileReader* reader = entryInfo != nullptr ? GetFileReader(*layer, entryInfo->packIndex) : nullptr;
+	if (reader == nullptr 
+		|| (entryInfo->flags & (CondensedEntrySolidFlag | CondensedEntryCompressionMask)) != 0 
+		|| !UsesDirectIo(*reader, _size))
 	{
-		// Invalid file
 		return 0;
 	}
 
-#endif
+	// The data only goes directly into an aligned buffer when the read location is aligned too (entries are aligned 
+	// using PacketCondenseSettings::alignment)
+	return (entryInfo->location + _offset) % DirectReadAlignment == 0 ? DirectReadAlignment : 0;
+}
+
+bool PacketCondensedModeFileLoader::ReadFile(Hash _fileHash, const std::function<uint8_t*(uint64_t)>& _allocator) const
+{
+	// Get the file info, its size and location are found together so this is the only lookup
+	const CondensedLayer* layer = nullptr;
+	const CondensedEntryInfo* entryInfo = FindEntry(_fileHash, layer);
+	if (entryInfo == nullptr)
+	{
+		return false;
+	}
+
+	// Allocate the output buffer
+	uint8_t* dataOut = _allocator(entryInfo->size);
+	if ((dataOut == nullptr && entryInfo->size != 0) || !ReadEntryData(dataOut, 0, entryInfo->size, *entryInfo, *layer, _fileHash))
+	{
+		return false;
+	}
+
+	RecordRead(entryInfo->size);
 
-	// Get the file info and return the size
-	auto iter = m_MappedInternalFileInfos.find(_fileHash);
-	return iter->second.info.size;
+	return true;
 }
 
-bool PacketCondensedModeFileLoader::GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const
+void PacketCondensedModeFileLoader::SubmitReads(const std::vector<PacketReadRequest>& _requests) const
 {
+	std::vector<DirectRead> directReads;
+	for (const auto& request : _requests)
+	{
+		// Raw entries are read directly from their condensed file and verified once their data arrives, when only part
+		// of an entry is read and it must be verified, it's read by a worker thread instead
+		const CondensedLayer* layer = nullptr;
+		const CondensedEntryInfo* entryInfo = FindEntry(request.hash, layer);
+		const CondensedFileReader* reader = entryInfo != nullptr ? GetFileReader(*layer, entryInfo->packIndex) : nullptr;
+		if (reader != nullptr 
+			&& (entryInfo->flags & (CondensedEntrySolidFlag | CondensedEntryCompressionMask)) == 0 
+			&& request.offset <= entryInfo->size 
+			&& request.size <= entryInfo->size - request.offset)
+		{
+			bool usesDirectIo = UsesDirectIo(*reader, request.size);
+			uint32_t fileIndex = usesDirectIo ? reader->directFileIndex : reader->asyncFileIndex;
+			bool isWholeEntry = request.offset == 0 && request.size == entryInfo->storedSize;
+			std::atomic<bool>& verified = GetEntryVerifiedState(*entryInfo, *layer);
+			if (fileIndex != std::numeric_limits<uint32_t>::max() && (isWholeEntry || !NeedsVerification(verified)))
+			{
+				DirectRead directRead = { request, entryInfo, &verified, fileIndex, entryInfo->location + request.offset, isWholeEntry };
+
+				// Big reads bypass the page cache and are never merged with their neighbours
+				if (usesDirectIo)
+				{
+					m_AsyncReader.SubmitRead(directRead.fileIndex, directRead.location, request.size, request.dataOut, [this, directRead]()
+					{
+						return FinishDirectRead(directRead);
+					}, request.userData);
+					m_TotalDirectIoReads++;
+					continue;
+				}
+
+				directReads.push_back(directRead);
+				continue;
+			}
+		}
+
+		// Everything else is read by a worker thread
+		m_AsyncReader.SubmitTask([this, request]()
+		{
+			return ReadRange(request.hash, request.offset, request.size, request.dataOut);
+		}, request.userData);
+	}
 
-#ifndef NDEBUG
+	// Sort the direct reads by condensed file and location, so the reads that are close to each other can be merged 
+	// into a single bigger read (the gaps between them are read and discarded)
+	std::sort(directReads.begin(), directReads.end(), [](const DirectRead& _a, const DirectRead& _b)
+	{
+		return _a.fileIndex != _b.fileIndex ? _a.fileIndex < _b.fileIndex : _a.location < _b.location;
+	});
 
-	// If the file doesn't exist
-	if (!FileExist(_fileHash))
+	for (size_t first = 0; first < directReads.size();)
+	{
+		// Find the reads that will be merged with the first one
+		uint64_t begin = directReads[first].location;
+		uint64_t end = begin + directReads[first].request.size;
+		size_t last = first + 1;
+		while (last < directReads.size() 
+			&& directReads[last].fileIndex == directReads[first].fileIndex 
+			&& directReads[last].location <= end + m_ReadCoalesceGap 
+			&& std::max(end, directReads[last].location + directReads[last].request.size) - begin <= ReadCoalesceMaximumSize)
+		{
+			end = std::max(end, directReads[last].location + directReads[last].request.size);
+			last++;
+		}
+
+		// A read that wasn't merged goes straight into its output buffer
+		if (last - first == 1)
+		{
+			DirectRead directRead = directReads[first];
+			m_AsyncReader.SubmitRead(directRead.fileIndex, directRead.location, directRead.request.size, directRead.request.dataOut, [this, directRead]()
+			{
+				return FinishDirectRead(directRead);
+			}, directRead.request.userData);
+		}
+		// Merged reads use a temporary buffer that is scattered into each output buffer
+		else
+		{
+			auto mergedReads = std::make_shared<std::vector<DirectRead>>(directReads.begin() + first, directReads.begin() + last);
+			auto mergedData = std::make_shared<std::vector<uint8_t>>(size_t(end - begin));
+			m_AsyncReader.SubmitMergedRead(directReads[first].fileIndex, begin, end - begin, mergedData->data(), [this, mergedReads, mergedData, begin](bool _readSucceeded)
+			{
+				for (const auto& directRead : *mergedReads)
+				{
+					if (_readSucceeded && directRead.request.size != 0)
+					{
+						memcpy(directRead.request.dataOut, mergedData->data() + (directRead.location - begin), size_t(directRead.request.size));
+					}
+
+					m_AsyncReader.PostCompletion(directRead.request.userData, _readSucceeded && FinishDirectRead(directRead));
+				}
+			});
+
+			m_TotalCoalescedReads += last - first;
+		}
+
+		first = last;
+	}
+
+	// Submit the whole batch to the kernel at once
+	m_AsyncReader.Flush();
+}
+
+bool PacketCondensedModeFileLoader::FinishDirectRead(const DirectRead& _directRead) const
+{
+	if (_directRead.isWholeEntry 
+		&& !VerifyStoredData(_directRead.request.dataOut, _directRead.request.size, _directRead.entryInfo->checksum, *_directRead.verified, _directRead.request.hash))
 	{
 		return false;
 	}
 
-#endif
+	RecordRead(_directRead.request.size);
 
-	// Get the file info
-    const MappedInternalFileInfo& mappedFileInfo = m_MappedInternalFileInfos.find(_fileHash)->second;
+	return true;
+}
 
-	// Check if the file reader is valid
-	if (mappedFileInfo.readerIndex < 0 || mappedFileInfo.readerIndex >= m_FileReaders.size())
+uint32_t PacketCondensedModeFileLoader::DrainReadCompletions(std::vector<PacketReadCompletion>& _completionsOut) const
+{
+	return m_AsyncReader.DrainCompletions(_completionsOut);
+}
+
+void PacketCondensedModeFileLoader::SetReadCompletionCallback(std::function<void()> _callback) const
+{
+	m_AsyncReader.SetCompletionCallback(std::move(_callback));
+}
+
+const CondensedEntryInfo* PacketCondensedModeFileLoader::FindEntry(Hash _fileHash, const CondensedLayer*& _layerOut) const
+{
+	// Without overlays the manifest index is used directly
+	if (m_Layers.size() == 1)
+	{
+		const CondensedEntryInfo* entryInfo = m_Layers[0].manifest.FindEntry(_fileHash.GetHashValue());
+		if (entryInfo == nullptr || (entryInfo->flags & CondensedEntryTombstoneFlag) != 0)
+		{
+			return nullptr;
+		}
+
+		_layerOut = &m_Layers[0];
+
+		return entryInfo;
+	}
+
+	// Walk the merged index
+	uint64_t node = PacketCondensedManifest::FindEytzingerNode(m_MergedIndex.data(), m_MergedEntries.size(), _fileHash.GetHashValue());
+	if (node == 0)
+	{
+		return nullptr;
+	}
+
+	const MergedEntry& mergedEntry = m_MergedEntries[node - 1];
+	_layerOut = &m_Layers[mergedEntry.layerIndex];
+
+	return mergedEntry.entryInfo;
+}
+
+const PacketCondensedModeFileLoader::CondensedFileReader* PacketCondensedModeFileLoader::GetFileReader(const CondensedLayer& _layer, uint32_t _packIndex) const
+{
+	uint64_t readerIndex = uint64_t(_layer.firstReaderIndex) + _packIndex;
+	if (_packIndex >= _layer.manifest.GetTotalPacks() || readerIndex >= m_FileReaders.size())
+	{
+		return nullptr;
+	}
+
+	return &m_FileReaders[size_t(readerIndex)];
+}
+
+bool PacketCondensedModeFileLoader::ReadEntryData(uint8_t* _dataOut, 
+                                                  uint64_t _offset, 
+                                                  uint64_t _bufferSize, 
+                                                  const CondensedEntryInfo& _entryInfo, 
+                                                  const CondensedLayer& _layer, 
+                                                  Hash _fileHash) const
+{
+	// Get a short variable to the reader and check if it's valid
+	auto* reader = GetFileReader(_layer, _entryInfo.packIndex);
+	if (reader == nullptr)
+	{
+		return false;
+	}
+
+	// Check if we are not trying to read past the end of the file
+	if (_offset > _entryInfo.size || _bufferSize > _entryInfo.size - _offset)
+	{
+		m_Logger->LogError(std::string("Error reading the file: ")
+			.append(_fileHash.GetPath())
+			.append(", trying to read ")
+			.append(std::to_string(_bufferSize))
+			.append(" bytes at offset ")
+			.append(std::to_string(_offset))
+			.append(" but the file only has ")
+			.append(std::to_string(_entryInfo.size))
+			.append(" bytes!")
+			.c_str());
+
+		return false;
+	}
+
+	// Get the location of the range to read
+	uint64_t location = _entryInfo.location + _offset;
+
+	// Check if the entry is inside a solid block
+	CondensedCompression compression = CondensedCompression(_entryInfo.flags & CondensedEntryCompressionMask);
+	if ((_entryInfo.flags & CondensedEntrySolidFlag) != 0)
+	{
+		// Get the block info
+		const CondensedBlockInfo* blockInfo = GetSolidBlockInfo(_entryInfo, _layer);
+		if (blockInfo == nullptr)
+		{
+			// Error reading the file
+			m_Logger->LogError(std::string("Error reading the file: ")
+				.append(_fileHash.GetPath())
+				.append(", its solid block is invalid!")
+				.c_str());
+
+			return false;
+		}
+
+		// Compressed blocks are decompressed as a whole and kept on the block cache
+		if (CondensedCompression(blockInfo->flags & CondensedEntryCompressionMask) != CondensedCompression::None)
+		{
+			auto blockData = GetSolidBlockData(_entryInfo.blockIndex, _layer, _fileHash);
+			if (blockData == nullptr)
+			{
+				return false;
+			}
+
+			memcpy(_dataOut, blockData->data() + _entryInfo.blockOffset + _offset, size_t(_bufferSize));
+
+			return true;
+		}
+
+		// Raw blocks can be read directly after their data is verified
+		reader = GetFileReader(_layer, blockInfo->packIndex);
+		location = blockInfo->location + _entryInfo.blockOffset + _offset;
+		if (!VerifyStoredRange(*reader, blockInfo->location, blockInfo->storedSize, blockInfo->checksum, m_VerifiedBlocks[_layer.firstBlockIndex + _entryInfo.blockIndex], _fileHash))
+		{
+			return false;
+		}
+	}
+	// Check if the entry is compressed
+	else if (compression != CondensedCompression::None)
+	{
+		return ReadCompressedEntryData(_dataOut, _offset, _bufferSize, _entryInfo, _layer, compression, _fileHash);
+	}
+	// Big raw reads bypass the page cache using direct I/O, like on stream mode the data read is verified when it's the
+	// whole entry
+	else if (UsesDirectIo(*reader, _bufferSize))
+	{
+		bool isWholeEntry = _offset == 0 && _bufferSize == _entryInfo.storedSize;
+		if (!isWholeEntry 
+			&& !VerifyStoredRange(*reader, _entryInfo.location, _entryInfo.storedSize, _entryInfo.checksum, GetEntryVerifiedState(_entryInfo, _layer), _fileHash))
+		{
+			return false;
+		}
+
+		if (!m_AsyncReader.Read(reader->directFileIndex, location, _bufferSize, _dataOut))
+		{
+			// Error reading the file
+			m_Logger->LogError(std::string("Error reading the file: ")
+				.append(_fileHash.GetPath())
+				.append(", its data couldn't be read using direct I/O!")
+				.c_str());
+
+			return false;
+		}
+
+		m_TotalDirectIoReads++;
+
+		return !isWholeEntry || VerifyStoredData(_dataOut, _bufferSize, _entryInfo.checksum, GetEntryVerifiedState(_entryInfo, _layer), _fileHash);
+	}
+	// Raw entries are verified before being read, except when the whole entry is read from a stream (the data read
+	// is verified instead, so it's read only once)
+	else if ((reader->mappedFile != nullptr || _offset != 0 || _bufferSize != _entryInfo.storedSize) 
+		&& !VerifyStoredRange(*reader, _entryInfo.location, _entryInfo.storedSize, _entryInfo.checksum, GetEntryVerifiedState(_entryInfo, _layer), _fileHash))
 	{
 		return false;
 	}
 
+	// If we are using a mapped file, just copy the data from its location (bounds checked)
+	if (reader->mappedFile != nullptr)
+	{
+		if (!reader->mappedFile->Read(_dataOut, location, _bufferSize))
+		{
+			// Error reading the file
+			m_Logger->LogError(std::string("Error reading the file: ")
+				.append(_fileHash.GetPath())
+				.append(", its location is outside the condensed file bounds!")
+				.c_str());
+
+			return false;
+		}
+
+		return true;
+	}
+
+	// Since the stream is shared we must prevent other threads from moving it until we finish reading
+	std::lock_guard<std::mutex> lock(*reader->fileMutex);
+
 	// Get a short variable to the file object
-	auto& file = *m_FileReaders[mappedFileInfo.readerIndex].file;
+	auto& file = *reader->file;
 
-	// Read the file data
+	// Move to the file location and read the file data
+	file.clear();
+	file.seekg(location);
 	file.read((char*)_dataOut, _bufferSize);
 	if (!file)
 	{
@@ -110,190 +501,649 @@ bool PacketCondensedModeFileLoader::GetFileData(uint8_t* _dataOut, uint64_t _buf
 		return false;
 	}
 
+	// Verify the data read (if the whole entry was read)
+	if ((_entryInfo.flags & CondensedEntrySolidFlag) == 0 
+		&& _offset == 0 
+		&& _bufferSize == _entryInfo.storedSize 
+		&& !VerifyStoredData(_dataOut, _bufferSize, _entryInfo.checksum, GetEntryVerifiedState(_entryInfo, _layer), _fileHash))
+	{
+		return false;
+	}
+
 	return true;
 }
 
-bool PacketCondensedModeFileLoader::ConstructPacket()
+bool PacketCondensedModeFileLoader::ReadCompressedEntryData(uint8_t* _dataOut, 
+                                                            uint64_t _offset, 
+                                                            uint64_t _bufferSize, 
+                                                            const CondensedEntryInfo& _entryInfo, 
+                                                            const CondensedLayer& _layer, 
+                                                            CondensedCompression _compression, 
+                                                            Hash _fileHash) const
 {
-	// We can't construct the packet structure on this mode!
-	m_Logger->LogError(std::string("We can't construct the packet structure on this mode!").c_str());
+	// Get the stored data
+	std::vector<uint8_t> storedBuffer;
+	const uint8_t* storedData = ReadStoredData(*GetFileReader(_layer, _entryInfo.packIndex), _entryInfo.location, _entryInfo.storedSize, storedBuffer);
+	if (storedData == nullptr)
+	{
+		// Error reading the file
+		m_Logger->LogError(std::string("Error reading the file: ")
+			.append(_fileHash.GetPath())
+			.append(", its compressed data is outside the condensed file bounds!")
+			.c_str());
 
-	return false;
+		return false;
+	}
+
+	// Verify the stored data before decompressing it
+	if (!VerifyStoredData(storedData, _entryInfo.storedSize, _entryInfo.checksum, GetEntryVerifiedState(_entryInfo, _layer), _fileHash))
+	{
+		return false;
+	}
+
+	// Decompress the range directly into the output buffer, only the chunks that intersect it are decompressed
+	if (!PacketCompression::DecompressEntryRange(_compression, storedData, _entryInfo.storedSize, _entryInfo.size, _offset, _dataOut, _bufferSize))
+	{
+		// Error decompressing the file
+		m_Logger->LogError(std::string("Error decompressing the file: ")
+			.append(_fileHash.GetPath())
+			.append(", the condensed data is corrupted!")
+			.c_str());
+
+		return false;
+	}
+
+	return true;
 }
 
-bool PacketCondensedModeFileLoader::ReadPacketData(std::string _packetManifestDirectory)
+const uint8_t* PacketCondensedModeFileLoader::ReadStoredData(const CondensedFileReader& _reader, uint64_t _location, uint64_t _size, std::vector<uint8_t>& _buffer) const
 {
-	// Get the root folder name
-	auto rootFolderName = GetRootFolder(_packetManifestDirectory);
+	// If we are using a mapped file the data can be used in place
+	if (_reader.mappedFile != nullptr)
+	{
+		return _reader.mappedFile->GetData(_location, _size);
+	}
+
+	// Since the stream is shared we must prevent other threads from moving it until we finish reading
+	std::lock_guard<std::mutex> lock(*_reader.fileMutex);
+
+	// Move to the location and read the stored data
+	_buffer.resize(size_t(_size));
+	_reader.file->clear();
+	_reader.file->seekg(_location);
+	_reader.file->read(reinterpret_cast<char*>(_buffer.data()), _size);
+
+	return *_reader.file ? _buffer.data() : nullptr;
+}
 
-	// Setup the condensed info file name
-	std::string condensedInfoName = rootFolderName;
-	condensedInfoName.append(CondensedInfoName);
-	condensedInfoName.append(CondensedInfoExtension);
+const CondensedBlockInfo* PacketCondensedModeFileLoader::GetSolidBlockInfo(const CondensedEntryInfo& _entryInfo, const CondensedLayer& _layer) const
+{
+	// Check if the block exist and if the entry is inside it
+	if (_entryInfo.blockIndex >= _layer.manifest.GetTotalBlocks())
+	{
+		return nullptr;
+	}
 
-	// Open the file and check if we are ok to proceed
-	std::ifstream file(condensedInfoName, std::ios::binary);
-	if (!file.is_open())
+	const CondensedBlockInfo& blockInfo = _layer.manifest.GetBlock(_entryInfo.blockIndex);
+	if (GetFileReader(_layer, blockInfo.packIndex) == nullptr || uint64_t(_entryInfo.blockOffset) + _entryInfo.size > blockInfo.size)
 	{
-		// Error openning the file!
-		m_Logger->LogError(std::string("Error trying to open the packed data on: ").append(_packetManifestDirectory).c_str());
+		return nullptr;
+	}
 
-		return false;
+	return &blockInfo;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> PacketCondensedModeFileLoader::GetSolidBlockData(uint32_t _blockIndex, const CondensedLayer& _layer, Hash _fileHash) const
+{
+	// The cache uses the block index considering all layers
+	uint32_t cachedBlockIndex = _layer.firstBlockIndex + _blockIndex;
+
+	// Check if the block is inside our cache
+	{
+		std::lock_guard<std::mutex> lock(m_SolidBlockCacheMutex);
+
+		auto iter = m_SolidBlockCacheMap.find(cachedBlockIndex);
+		if (iter != m_SolidBlockCacheMap.end())
+		{
+			// Move it to the front (most recently used)
+			m_SolidBlockCache.splice(m_SolidBlockCache.begin(), m_SolidBlockCache, iter->second);
+
+			return iter->second->data;
+		}
+	}
+
+	// Get the block info and read its stored data
+	const CondensedBlockInfo& blockInfo = _layer.manifest.GetBlock(_blockIndex);
+	std::vector<uint8_t> storedBuffer;
+	const uint8_t* storedData = ReadStoredData(*GetFileReader(_layer, blockInfo.packIndex), blockInfo.location, blockInfo.storedSize, storedBuffer);
+
+	// Verify the stored data before decompressing it
+	if (storedData != nullptr && !VerifyStoredData(storedData, blockInfo.storedSize, blockInfo.checksum, m_VerifiedBlocks[cachedBlockIndex], _fileHash))
+	{
+		return nullptr;
 	}
 
-	// Read the condensed header
-	file.read((char*)&m_CondensedFileHeader, sizeof(CondensedHeaderInfo));
+	// Decompress the block using the dictionary shared by its layer
+	auto blockData = std::make_shared<std::vector<uint8_t>>(size_t(blockInfo.size));
+	if (storedData == nullptr 
+		|| !PacketCompression::DecompressBlock(storedData, 
+		                                       blockInfo.storedSize, 
+		                                       blockData->data(), 
+		                                       blockInfo.size, 
+		                                       _layer.manifest.GetDictionary(), 
+		                                       _layer.manifest.GetDictionarySize()))
+	{
+		// Error decompressing the block
+		m_Logger->LogError(std::string("Error decompressing the solid block that contains the file: ")
+			.append(_fileHash.GetPath())
+			.append(", the condensed data is corrupted!")
+			.c_str());
 
-	// Allocate memory for all file infos
-	m_CondensedFileInfos.resize(m_CondensedFileHeader.totalInfos);
+		return nullptr;
+	}
 
-	// Read the condensed file infos
-	file.read((char*)m_CondensedFileInfos.data(), sizeof(CondensedFileInfo) * m_CondensedFileHeader.totalInfos);
+	// Insert the block into our cache, another thread could have inserted it while we were decompressing
+	std::lock_guard<std::mutex> lock(m_SolidBlockCacheMutex);
+	if (m_SolidBlockCacheMap.find(cachedBlockIndex) == m_SolidBlockCacheMap.end())
+	{
+		m_SolidBlockCache.push_front({ cachedBlockIndex, blockData });
+		m_SolidBlockCacheMap.insert({ cachedBlockIndex, m_SolidBlockCache.begin() });
+		m_SolidBlockCacheSize += blockData->size();
+	}
 
-	// Close the file
-	file.close();
+	// Evict the least recently used blocks until we are inside our limits
+	while (m_SolidBlockCacheSize > m_SolidBlockCacheMaximumSize && m_SolidBlockCache.size() > 0)
+	{
+		m_SolidBlockCacheSize -= m_SolidBlockCache.back().data->size();
+		m_SolidBlockCacheMap.erase(m_SolidBlockCache.back().blockIndex);
+		m_SolidBlockCache.pop_back();
+	}
 
-	return true;
+	return blockData;
 }
 
-void PacketCondensedModeFileLoader::ProcessPacketData()
+bool PacketCondensedModeFileLoader::GetFileDataView(PacketFileDataView& _viewOut, Hash _fileHash) const
 {
-	// For each file info
-	for (auto& fileInfo : m_CondensedFileInfos)
+	// Get the file info
+	const CondensedLayer* layer = nullptr;
+	const CondensedEntryInfo* entryInfo = FindEntry(_fileHash, layer);
+	if (entryInfo == nullptr)
 	{
-		// The condensed file header we will be using
-		CondensedFileReader fileReader = {};
-		fileReader.filePath = fileInfo.filePath;
-		fileReader.totalNumberFiles = fileInfo.totalNumberFiles;
+		return false;
+	}
 
-		// Open the file
-		fileReader.file = new std::ifstream(fileInfo.filePath, std::ios::binary);
-		if (!fileReader.file->is_open())
-		{
-			// Error openning the file!
-			m_Logger->LogError(std::string("Error reading a packet info data! File: ").append(fileInfo.filePath).c_str());
-			m_PackedDataLoaded = false;
-			delete fileReader.file;
+	// Check if the file reader is valid
+	const CondensedFileReader* reader = GetFileReader(*layer, entryInfo->packIndex);
+	if (reader == nullptr)
+	{
+		return false;
+	}
+
+	// Get the entry location and its compression
+	uint64_t location = entryInfo->location;
+	CondensedCompression compression = CondensedCompression(entryInfo->flags & CondensedEntryCompressionMask);
 
-			return;
+	// Check if the entry is inside a solid block
+	if ((entryInfo->flags & CondensedEntrySolidFlag) != 0)
+	{
+		// Get the block info
+		const CondensedBlockInfo* blockInfo = GetSolidBlockInfo(*entryInfo, *layer);
+		if (blockInfo == nullptr)
+		{
+			return false;
 		}
 
-		// For each internal file info
-		for (unsigned int i = 0; i < fileInfo.totalNumberFiles; i++)
+		// Compressed blocks can be viewed directly from the block cache, the view will keep the block alive
+		if (CondensedCompression(blockInfo->flags & CondensedEntryCompressionMask) != CondensedCompression::None)
 		{
-			// Get the internal file info reference
-			auto& internalFileInfo = fileInfo.fileInfos[i];
+			auto blockData = GetSolidBlockData(entryInfo->blockIndex, *layer, _fileHash);
+			if (blockData == nullptr)
+			{
+				return false;
+			}
 
-			// Setup the mapped internal file info
-			MappedInternalFileInfo mappedFileInfo = {};
-			mappedFileInfo.info = internalFileInfo;
-			mappedFileInfo.readerIndex = uint16_t(m_FileReaders.size());
+			_viewOut.data = blockData->data() + entryInfo->blockOffset;
+			_viewOut.size = entryInfo->size;
+			_viewOut.owner = blockData;
+			RecordRead(entryInfo->size);
 
-			// Insert it
-			m_MappedInternalFileInfos.insert({ internalFileInfo.hash.GetHashValue(), mappedFileInfo });
+			return true;
 		}
 
-		// Insert the file reader into our vector
-		m_FileReaders.push_back(fileReader);
+		// Raw blocks can be viewed from the condensed file after their data is verified
+		reader = GetFileReader(*layer, blockInfo->packIndex);
+		location = blockInfo->location + entryInfo->blockOffset;
+		compression = CondensedCompression::None;
+		if (reader->mappedFile != nullptr 
+			&& !VerifyStoredRange(*reader, blockInfo->location, blockInfo->storedSize, blockInfo->checksum, m_VerifiedBlocks[layer->firstBlockIndex + entryInfo->blockIndex], _fileHash))
+		{
+			return false;
+		}
+	}
+	// Check if the file is mapped and if the entry is stored raw (compressed entries can't be viewed), then verify it
+	else if (reader->mappedFile == nullptr 
+		|| compression != CondensedCompression::None 
+		|| !VerifyStoredRange(*reader, location, entryInfo->storedSize, entryInfo->checksum, GetEntryVerifiedState(*entryInfo, *layer), _fileHash))
+	{
+		return false;
 	}
 
-	// Log info
-	m_Logger->LogInfo(std::string("Found a total of ")
-		.append(std::to_string(m_MappedInternalFileInfos.size()))
-		.append(" file infos when reading the packet object!")
-		.c_str());
+	// Check if the file is mapped
+	if (reader->mappedFile == nullptr)
+	{
+		return false;
+	}
+
+	// Get the mapped file
+	auto& mappedFile = reader->mappedFile;
+
+	// Get the data range (bounds checked)
+	const uint8_t* data = mappedFile->GetData(location, entryInfo->size);
+	if (data == nullptr)
+	{
+		return false;
+	}
+
+	// Set the view, it will keep the mapped file alive
+	_viewOut.data = data;
+	_viewOut.size = entryInfo->size;
+	_viewOut.owner = mappedFile;
+	RecordRead(entryInfo->size);
+
+	return true;
 }
 
-std::vector<Hash> PacketCondensedModeFileLoader::GetFileHashesThatNeedUpdate(std::string _packetManifestDirectory)
+PacketFileLoaderStats PacketCondensedModeFileLoader::GetStats() const
 {
-	// The output vector
-	std::vector<Hash> out;
+	PacketFileLoaderStats stats;
+	stats.totalReads = m_TotalReads;
+	stats.totalReadBytes = m_TotalReadBytes;
+	stats.totalVerifications = m_TotalVerifications;
+	stats.totalVerifiedBytes = m_TotalVerifiedBytes;
+	stats.totalVerificationTime = m_TotalVerificationTime / 1000;
+	stats.totalVerificationFailures = m_TotalVerificationFailures;
+	stats.totalCoalescedReads = m_TotalCoalescedReads;
+	stats.totalDirectIoReads = m_TotalDirectIoReads;
+	stats.totalBounceBufferBytes = m_AsyncReader.GetTotalBounceBufferBytes();
+	stats.totalPrefetchedBytes = m_TotalPrefetchedBytes;
+	stats.totalEvictedBytes = m_TotalEvictedBytes;
 
-	// Check if our packet data was loaded
-	if (!m_PackedDataLoaded)
+	return stats;
+}
+
+bool PacketCondensedModeFileLoader::UsesDirectIo(const CondensedFileReader& _reader, uint64_t _size) const
+{
+	return _reader.directFileIndex != std::numeric_limits<uint32_t>::max() && _size >= m_DirectReadMinimumSize;
+}
+
+bool PacketCondensedModeFileLoader::NeedsVerification(const std::atomic<bool>& _verified) const
+{
+	return m_VerifyMode == CondensedVerifyMode::EveryRead || (m_VerifyMode == CondensedVerifyMode::FirstRead && !_verified.load(std::memory_order_acquire));
+}
+
+bool PacketCondensedModeFileLoader::VerifyStoredData(const uint8_t* _data, uint64_t _size, uint32_t _checksum, std::atomic<bool>& _verified, Hash _fileHash) const
+{
+	// Check if this data must be verified
+	if (!NeedsVerification(_verified))
+	{
+		return true;
+	}
+
+	// Compute its checksum
+	auto beginTime = std::chrono::steady_clock::now();
+	uint32_t computedChecksum = PacketChecksum::Compute(_data, _size);
+	uint64_t elapsedTime = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - beginTime).count());
+
+	return FinishVerification(computedChecksum, _size, elapsedTime, _checksum, _verified, _fileHash);
+}
+
+bool PacketCondensedModeFileLoader::FinishVerification(uint32_t _computedChecksum, uint64_t _size, uint64_t _elapsedTime, uint32_t _checksum, std::atomic<bool>& _verified, Hash _fileHash) const
+{
+	m_TotalVerificationTime += _elapsedTime;
+	m_TotalVerifications++;
+	m_TotalVerifiedBytes += _size;
+
+	if (_computedChecksum != _checksum)
+	{
+		m_TotalVerificationFailures++;
+
+		// The data is corrupted
+		m_Logger->LogError(std::string("Error reading the file: ")
+			.append(_fileHash.GetPath())
+			.append(", its checksum doesn't match, the condensed data is corrupted!")
+			.c_str());
+
+		return false;
+	}
+
+	_verified.store(true, std::memory_order_release);
+
+	return true;
+}
+
+bool PacketCondensedModeFileLoader::VerifyStoredRange(const CondensedFileReader& _reader, uint64_t _location, uint64_t _size, uint32_t _checksum, std::atomic<bool>& _verified, Hash _fileHash) const
+{
+	// Check if this data must be verified
+	if (!NeedsVerification(_verified))
+	{
+		return true;
+	}
+
+	// Ranges big enough to use direct I/O are read in chunks through it and their checksum is computed as they are read,
+	// so verifying them doesn't fill the page cache (or need a buffer as big as them)
+	if (UsesDirectIo(_reader, _size))
+	{
+		auto beginTime = std::chrono::steady_clock::now();
+		uint32_t computedChecksum = 0;
+		bool readSucceeded = m_AsyncReader.ReadInChunks(_reader.directFileIndex, _location, _size, [&](const uint8_t* _data, uint64_t _chunkSize)
+		{
+			computedChecksum = PacketChecksum::Compute(_data, _chunkSize, computedChecksum);
+		});
+		uint64_t elapsedTime = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - beginTime).count());
+
+		if (!readSucceeded)
+		{
+			// Error reading the file
+			m_Logger->LogError(std::string("Error reading the file: ")
+				.append(_fileHash.GetPath())
+				.append(", its data couldn't be read using direct I/O!")
+				.c_str());
+
+			return false;
+		}
+
+		return FinishVerification(computedChecksum, _size, elapsedTime, _checksum, _verified, _fileHash);
+	}
+
+	// Read the stored data
+	std::vector<uint8_t> storedBuffer;
+	const uint8_t* storedData = ReadStoredData(_reader, _location, _size, storedBuffer);
+	if (storedData == nullptr)
 	{
-		// We need to load the packet data first
-		return out;
+		// Error reading the file
+		m_Logger->LogError(std::string("Error reading the file: ")
+			.append(_fileHash.GetPath())
+			.append(", its location is outside the condensed file bounds!")
+			.c_str());
+
+		return false;
 	}
 
-	// Get the root folder name
-	auto rootFolderName = GetRootFolder(_packetManifestDirectory);
+	return VerifyStoredData(storedData, _size, _checksum, _verified, _fileHash);
+}
+
+std::atomic<bool>& PacketCondensedModeFileLoader::GetEntryVerifiedState(const CondensedEntryInfo& _entryInfo, const CondensedLayer& _layer) const
+{
+	return m_VerifiedEntries[_layer.firstEntryIndex + (&_entryInfo - _layer.manifest.GetEntries())];
+}
+
+void PacketCondensedModeFileLoader::RecordRead(uint64_t _size) const
+{
+	m_TotalReads++;
+	m_TotalReadBytes += _size;
+}
+
+void PacketCondensedModeFileLoader::Prefetch(const std::vector<Hash>& _fileHashes) const
+{
+	AdviseEntries(_fileHashes, true);
+}
 
-	// Setup the condensed info file name
-	std::string condensedInfoName = rootFolderName;
-	condensedInfoName.append(CondensedInfoName);
-	condensedInfoName.append(CondensedInfoExtension);
+void PacketCondensedModeFileLoader::Evict(const std::vector<Hash>& _fileHashes) const
+{
+	AdviseEntries(_fileHashes, false);
+}
 
-	// Open the file and check if we are ok to proceed
-	std::ifstream file(condensedInfoName, std::ios::binary);
-	if (!file.is_open())
+void PacketCondensedModeFileLoader::AdviseEntries(const std::vector<Hash>& _fileHashes, bool _willBeNeeded) const
+{
+	// A stored range inside one of our condensed files
+	struct StoredRange
 	{
-		// Error openning the file!
-		m_Logger->LogError(std::string("Error trying to open the packed data on: ").append(_packetManifestDirectory).c_str());
+		const CondensedFileReader* reader;
+		uint64_t location;
+		uint64_t size;
+	};
+
+	// Get the stored range of each file, entries inside a solid block need the whole block
+	std::vector<StoredRange> storedRanges;
+	std::vector<uint32_t> solidBlocks;
+	for (auto& fileHash : _fileHashes)
+	{
+		const CondensedLayer* layer = nullptr;
+		const CondensedEntryInfo* entryInfo = FindEntry(fileHash, layer);
+		if (entryInfo == nullptr)
+		{
+			continue;
+		}
+
+		if ((entryInfo->flags & CondensedEntrySolidFlag) != 0)
+		{
+			const CondensedBlockInfo* blockInfo = GetSolidBlockInfo(*entryInfo, *layer);
+			if (blockInfo != nullptr)
+			{
+				storedRanges.push_back({ GetFileReader(*layer, blockInfo->packIndex), blockInfo->location, blockInfo->storedSize });
+				solidBlocks.push_back(layer->firstBlockIndex + entryInfo->blockIndex);
+			}
+		}
+		else if (GetFileReader(*layer, entryInfo->packIndex) != nullptr)
+		{
+			storedRanges.push_back({ GetFileReader(*layer, entryInfo->packIndex), entryInfo->location, entryInfo->storedSize });
+		}
+	}
+
+	// Sort the ranges so the ones that touch each other (files stored together, entries sharing a block or the same 
+	// deduplicated data) are advised using a single call
+	std::sort(storedRanges.begin(), storedRanges.end(), [](const StoredRange& _a, const StoredRange& _b)
+	{
+		return _a.reader != _b.reader ? _a.reader < _b.reader : _a.location < _b.location;
+	});
+
+	for (size_t first = 0; first < storedRanges.size();)
+	{
+		const CondensedFileReader* reader = storedRanges[first].reader;
+		uint64_t begin = storedRanges[first].location;
+		uint64_t end = begin + storedRanges[first].size;
+		size_t last = first + 1;
+		while (last < storedRanges.size() && storedRanges[last].reader == reader && storedRanges[last].location <= end)
+		{
+			end = std::max(end, storedRanges[last].location + storedRanges[last].size);
+			last++;
+		}
+
+		// Mapped files are advised through their mapping, on stream mode the file opened for the direct reads is used
+		if (reader->mappedFile != nullptr && _willBeNeeded)
+		{
+			reader->mappedFile->Prefetch(begin, end - begin);
+		}
+		else if (reader->mappedFile != nullptr)
+		{
+			reader->mappedFile->Evict(begin, end - begin);
+		}
+		else
+		{
+			m_AsyncReader.AdviseFileRange(reader->asyncFileIndex, begin, end - begin, _willBeNeeded);
+		}
+
+		if (_willBeNeeded)
+		{
+			m_TotalPrefetchedBytes += end - begin;
+		}
+		else
+		{
+			m_TotalEvictedBytes += end - begin;
+		}
+
+		first = last;
+	}
 
-		return out;
+	// Evicted solid blocks leave the block cache too
+	if (!_willBeNeeded && !solidBlocks.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_SolidBlockCacheMutex);
+		for (uint32_t blockIndex : solidBlocks)
+		{
+			auto iter = m_SolidBlockCacheMap.find(blockIndex);
+			if (iter != m_SolidBlockCacheMap.end())
+			{
+				m_SolidBlockCacheSize -= iter->second->data->size();
+				m_SolidBlockCache.erase(iter->second);
+				m_SolidBlockCacheMap.erase(iter);
+			}
+		}
 	}
+}
+
+bool PacketCondensedModeFileLoader::ConstructPacket(PacketCondenseSettings /*_settings*/)
+{
+	// We can't construct the packet structure on this mode!
+	m_Logger->LogError(std::string("We can't construct the packet structure on this mode!").c_str());
+
+	return false;
+}
 
-	// The data header info
-	CondensedHeaderInfo headerInfo;
+bool PacketCondensedModeFileLoader::ReadPacketData(std::string _packetManifestDirectory, const std::vector<std::string>& _overlayDirectories)
+{
+	// The condensed files are the lowest layer and each overlay is mounted over them
+	std::vector<std::string> layerDirectories = { _packetManifestDirectory };
+	layerDirectories.insert(layerDirectories.end(), _overlayDirectories.begin(), _overlayDirectories.end());
+	m_Layers = std::vector<CondensedLayer>(layerDirectories.size());
 
-	// Read the condensed header
-	file.read((char*)&headerInfo, sizeof(CondensedHeaderInfo));
+	// For each layer
+	bool result = true;
+	uint32_t totalReaders = 0;
+	uint32_t totalEntries = 0;
+	uint32_t totalBlocks = 0;
+	for (uint32_t i = 0; i < layerDirectories.size(); i++)
+	{
+		auto& layer = m_Layers[i];
+		layer.firstReaderIndex = totalReaders;
+		layer.firstEntryIndex = totalEntries;
+		layer.firstBlockIndex = totalBlocks;
 
-	// The condensed file infos
-	std::vector<CondensedFileInfo> condensedFileInfos;
+		// Setup the condensed info file name
+		std::string condensedInfoName = GetRootFolder(layerDirectories[i]);
+		condensedInfoName.append(CondensedInfoName);
+		condensedInfoName.append(CondensedInfoExtension);
 
-	// Allocate memory for all file infos
-	condensedFileInfos.resize(headerInfo.totalInfos);
+		// Open the manifest, its tables will be used directly so there is nothing else to read
+		if (!layer.manifest.Open(condensedInfoName, m_Logger))
+		{
+			// Error openning the file!
+			m_Logger->LogError(std::string("Error trying to open the packed data on: ").append(layerDirectories[i]).c_str());
+			result = false;
 
-	// Read the condensed file infos
-	file.read((char*)condensedFileInfos.data(), sizeof(CondensedFileInfo) * headerInfo.totalInfos);
+			continue;
+		}
 
-	// Close the file
-	file.close();
+		totalReaders += layer.manifest.GetTotalPacks();
+		totalEntries += layer.manifest.GetTotalEntries();
+		totalBlocks += layer.manifest.GetTotalBlocks();
+	}
 
-	// Check if the read header is newer the our current one
-	if(m_CondensedFileHeader.saveTime >= headerInfo.saveTime 
-		|| m_CondensedFileHeader.majorVersion > headerInfo.majorVersion
-		|| (m_CondensedFileHeader.majorVersion == headerInfo.majorVersion && m_CondensedFileHeader.minorVersion > headerInfo.minorVersion))
+	// Nothing was verified yet
+	m_VerifiedEntries = std::make_unique<std::atomic<bool>[]>(totalEntries);
+	m_VerifiedBlocks = std::make_unique<std::atomic<bool>[]>(totalBlocks);
+
+	// Merge the layers
+	BuildMergedIndex();
+
+	return result;
+}
+
+void PacketCondensedModeFileLoader::BuildMergedIndex()
+{
+	// Without overlays there is nothing to merge
+	if (m_Layers.size() <= 1)
 	{
-		// Our current header is newer or equal to the given one
-		return out;
+		return;
 	}
 
-	// Ok the new header is newer then ours, lets update //
+	// Walk the layers from the highest to the lowest, the first entry found for each hash is the visible one (if it's
+	// a tombstone the file was removed and it's left out)
+	std::unordered_set<uint64_t> foundHashes;
+	std::vector<MergedEntry> visibleEntries;
+	for (uint32_t layerIndex = uint32_t(m_Layers.size()); layerIndex-- > 0;)
+	{
+		auto& manifest = m_Layers[layerIndex].manifest;
+		for (uint32_t i = 0; i < manifest.GetTotalEntries(); i++)
+		{
+			const CondensedEntryInfo* entryInfo = &manifest.GetEntries()[i];
+			if (foundHashes.insert(entryInfo->hash).second && (entryInfo->flags & CondensedEntryTombstoneFlag) == 0)
+			{
+				visibleEntries.push_back({ entryInfo, layerIndex });
+			}
+		}
+	}
+
+	// Sort the visible entries by their hashes and place them using the same layout as the manifest index
+	std::sort(visibleEntries.begin(), visibleEntries.end(), [](const MergedEntry& _a, const MergedEntry& _b)
+	{
+		return _a.entryInfo->hash < _b.entryInfo->hash;
+	});
 
-	// Now for each condensed file info
-	for (auto& condensedFileInfo : condensedFileInfos)
+	std::vector<uint32_t> eytzingerOrder = PacketCondensedManifest::ComputeEytzingerOrder(uint32_t(visibleEntries.size()));
+	m_MergedEntries.resize(visibleEntries.size());
+	m_MergedIndex.assign(visibleEntries.size() + 1, 0);
+	for (size_t i = 0; i < eytzingerOrder.size(); i++)
+	{
+		m_MergedEntries[i] = visibleEntries[eytzingerOrder[i]];
+		m_MergedIndex[i + 1] = m_MergedEntries[i].entryInfo->hash;
+	}
+}
+
+void PacketCondensedModeFileLoader::ProcessPacketData()
+{
+	// For each layer and each condensed file inside it
+	for (auto& layer : m_Layers)
 	{
-		// For each internal file inside this condensed info
-		for (unsigned int i = 0; i < condensedFileInfo.totalNumberFiles; i++)
+		for (uint32_t i = 0; i < layer.manifest.GetTotalPacks(); i++)
 		{
-			// Get the internal file info
-			auto& internalFileInfo = condensedFileInfo.fileInfos[i];
+			// Get the condensed file info
+			const CondensedPackInfo& packInfo = layer.manifest.GetPack(i);
 
-			// Check if we have this file info
-			auto iter = m_MappedInternalFileInfos.find(internalFileInfo.hash);
-			if (iter == m_MappedInternalFileInfos.end())
+			// The condensed file header we will be using
+			CondensedFileReader fileReader = {};
+			fileReader.filePath = layer.manifest.GetPackPath(packInfo);
+			fileReader.totalNumberFiles = packInfo.totalEntries;
+
+			// Check if we should map the file
+			if (m_ReaderMode == CondensedReaderMode::Mapped)
 			{
-				// We don't have this file, add its hash into the output vector
-				out.push_back(internalFileInfo.hash);
+				// Map the file
+				fileReader.mappedFile = std::make_shared<PacketMappedFile>();
+				if (!fileReader.mappedFile->Open(fileReader.filePath))
+				{
+					// Error mapping the file!
+					m_Logger->LogError(std::string("Error mapping a packet info data! File: ").append(fileReader.filePath).c_str());
+					m_PackedDataLoaded = false;
+
+					return;
+				}
 			}
-			// We have the file
+			// Stream
 			else
 			{
-				// Get the file info
-				auto& currentInternalFileInfo = iter->second.info;
-
-				// Compare the written date
-				if (currentInternalFileInfo.time < internalFileInfo.time)
+				// Open the file
+				fileReader.file = new std::ifstream(fileReader.filePath, std::ios::binary);
+				fileReader.fileMutex = std::make_unique<std::mutex>();
+				if (!fileReader.file->is_open())
 				{
-					// The newer file has a newert written date, insert its hash into the output vector
-					out.push_back(internalFileInfo.hash);
+					// Error openning the file!
+					m_Logger->LogError(std::string("Error reading a packet info data! File: ").append(fileReader.filePath).c_str());
+					m_PackedDataLoaded = false;
+					delete fileReader.file;
+
+					return;
 				}
 			}
+
+			// Insert the file reader into our vector
+			m_FileReaders.push_back(std::move(fileReader));
 		}
 	}
 
-	return out;
-}
\ No newline at end of file
+	// Log info
+	m_Logger->LogInfo(std::string("Found a total of ")
+		.append(std::to_string(m_Layers.size() == 1 ? m_Layers[0].manifest.GetTotalEntries() : uint32_t(m_MergedEntries.size())))
+		.append(" file infos when reading the packet object!")
+		.c_str());
+}
@@ -7,11 +7,19 @@
 // INCLUDES //
 //////////////
 #include "PacketConfig.h"
+#include "PacketMappedFile.h"
+#include "PacketCondensedManifest.h"
+#include "PacketAsyncReader.h"
 
 #include <string>
 #include <vector>
-#include <map>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <atomic>
+#include <limits>
 
 ///////////////
 // NAMESPACE //
@@ -50,24 +58,64 @@ private:
 	// The condensed file reader type
 	struct CondensedFileReader
 	{
-		// The input file object
+		// The input file object (stream mode) and the mutex that serializes its seek + read operations
 		std::ifstream* file = nullptr;
+		std::unique_ptr<std::mutex> fileMutex;
+
+		// The mapped file (mapped mode), shared with any data view that references its memory
+		std::shared_ptr<PacketMappedFile> mappedFile;
 
 		// The file path
-		Path filePath;
+		std::string filePath;
+
+		// The file index inside the asynchronous reader (only when it uses io_uring)
+		uint32_t asyncFileIndex = std::numeric_limits<uint32_t>::max();
+
+		// The file index inside the asynchronous reader for direct I/O reads (only when direct I/O is enabled, supported
+		// and the file is big enough to contain a read that uses it)
+		uint32_t directFileIndex = std::numeric_limits<uint32_t>::max();
 
 		// The total number of files inside
 		uint32_t totalNumberFiles;
 	};
 
-	// The mapped internal file info type
-	struct MappedInternalFileInfo
+	// A decompressed solid block inside the block cache
+	struct CachedSolidBlock
+	{
+		// The block index (considering all layers) and its decompressed data
+		uint32_t blockIndex;
+		std::shared_ptr<const std::vector<uint8_t>> data;
+	};
+
+	// A mounted layer, the first one contains the condensed files and the others are overlays mounted over it
+	struct CondensedLayer
 	{
-		// The internal file info
-		CondensedFileInfo::InternalFileInfo info;
+		// The layer manifest, its tables are used in place
+		PacketCondensedManifest manifest;
+
+		// The index of this layer first file reader, its first entry and its first block (considering all layers), the
+		// pack, entry and block indices inside the manifest are relative to those
+		uint32_t firstReaderIndex = 0;
+		uint32_t firstEntryIndex = 0;
+		uint32_t firstBlockIndex = 0;
+	};
+
+	// An asynchronous read that goes directly to a condensed file (raw entries only)
+	struct DirectRead
+	{
+		PacketReadRequest request;
+		const CondensedEntryInfo* entryInfo;
+		std::atomic<bool>* verified;
+		uint32_t fileIndex;
+		uint64_t location;
+		bool isWholeEntry;
+	};
 
-		// The reader index that we should used to read the data from this file
-		uint16_t readerIndex;
+	// An entry inside the merged index and the layer that contains it
+	struct MergedEntry
+	{
+		const CondensedEntryInfo* entryInfo;
+		uint32_t layerIndex;
 	};
 
 //////////////////
@@ -75,7 +123,17 @@ private:
 public: //////////
 
 	// Constructor / destructor
-	PacketCondensedModeFileLoader(std::string _packetManifestDirectory, PacketLogger* _logger);
+	PacketCondensedModeFileLoader(std::string _packetManifestDirectory, 
+                                  PacketLogger* _logger, 
+                                  CondensedReaderMode _readerMode = CondensedReaderMode::Mapped, 
+                                  uint64_t _solidBlockCacheSize = DefaultSolidBlockCacheSize, 
+                                  CondensedVerifyMode _verifyMode = CondensedVerifyMode::FirstRead, 
+                                  std::vector<std::string> _overlayDirectories = {}, 
+                                  AsyncReadMode _asyncReadMode = AsyncReadMode::Automatic, 
+                                  uint32_t _asyncReadQueueDepth = DefaultAsyncReadQueueDepth, 
+                                  uint32_t _asyncReadThreads = DefaultAsyncReadThreads, 
+                                  uint64_t _readCoalesceGap = DefaultReadCoalesceGap, 
+                                  uint64_t _directReadMinimumSize = DefaultDirectReadMinimumSize);
 	~PacketCondensedModeFileLoader();
 
 //////////////////
@@ -91,22 +149,116 @@ public: //////////
 	// Get the file data
 	bool GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const override;
 
+	// Read a range of the file data, compressed entries only decompress the chunks that intersect the range
+	bool ReadRange(Hash _fileHash, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const override;
+
+	// Return the buffer alignment needed for a read to go directly into its buffer when it uses direct I/O
+	uint32_t GetReadAlignment(Hash _fileHash, uint64_t _offset, uint64_t _size) const override;
+
+	// Read a file using a single lookup on the manifest index
+	bool ReadFile(Hash _fileHash, const std::function<uint8_t*(uint64_t)>& _allocator) const override;
+
+	// Get a read-only view into the file data directly from the mapped condensed file (only on mapped mode)
+	bool GetFileDataView(PacketFileDataView& _viewOut, Hash _fileHash) const override;
+
+	// Submit a batch of asynchronous reads, raw entries are read directly from their condensed files (using io_uring when
+	// available) sorted by location and merged with their neighbours, everything else is read by the worker threads
+	void SubmitReads(const std::vector<PacketReadRequest>& _requests) const override;
+
+	// Append the completions of the asynchronous reads that finished since the last call
+	uint32_t DrainReadCompletions(std::vector<PacketReadCompletion>& _completionsOut) const override;
+
+	// Set the callback that is called each time an asynchronous read completes
+	void SetReadCompletionCallback(std::function<void()> _callback) const override;
+
+	// Advise the system to read ahead the stored data of the given files (madvise on mapped mode, fadvise on stream mode)
+	void Prefetch(const std::vector<Hash>& _fileHashes) const override;
+
+	// Drop the stored data of the given files from memory and the page cache, including their cached solid blocks
+	void Evict(const std::vector<Hash>& _fileHashes) const override;
+
 	// Pack all files
-	bool ConstructPacket() override;
+	bool ConstructPacket(PacketCondenseSettings _settings) override;
+
+	// Return the loader statistics
+	PacketFileLoaderStats GetStats() const override;
 
 private:
 
-	// Read the packet data
-	bool ReadPacketData(std::string _packetManifestDirectory);
+	// Find the entry with the given hash on the highest layer that contains it, returns nullptr if there is no entry
+	// with it or if it was removed by an overlay
+	const CondensedEntryInfo* FindEntry(Hash _fileHash, const CondensedLayer*& _layerOut) const;
+
+	// Return the reader for a condensed file inside the given layer, returns nullptr if it's invalid
+	const CondensedFileReader* GetFileReader(const CondensedLayer& _layer, uint32_t _packIndex) const;
+
+	// Read an entry data (starting at the given offset) from its condensed file
+	bool ReadEntryData(
+        uint8_t* _dataOut, 
+        uint64_t _offset, 
+        uint64_t _bufferSize, 
+        const CondensedEntryInfo& _entryInfo, 
+        const CondensedLayer& _layer, 
+        Hash _fileHash) const;
+
+	// Read and decompress a compressed entry data (starting at the given offset) from its condensed file
+	bool ReadCompressedEntryData(
+        uint8_t* _dataOut, 
+        uint64_t _offset, 
+        uint64_t _bufferSize, 
+        const CondensedEntryInfo& _entryInfo, 
+        const CondensedLayer& _layer, 
+        CondensedCompression _compression, 
+        Hash _fileHash) const;
+
+	// Return a pointer to the data stored at the given location, on mapped mode this points directly to the mapped 
+	// memory, else the data is read into the given buffer. Returns nullptr if the data can't be read
+	const uint8_t* ReadStoredData(const CondensedFileReader& _reader, uint64_t _location, uint64_t _size, std::vector<uint8_t>& _buffer) const;
+
+	// Return if a read of the given size from a raw entry inside the given condensed file uses direct I/O
+	bool UsesDirectIo(const CondensedFileReader& _reader, uint64_t _size) const;
+
+	// Return if data with the given verified state must be verified before being used
+	bool NeedsVerification(const std::atomic<bool>& _verified) const;
+
+	// Verify the given stored data checksum (if needed), returns false if the checksum doesn't match
+	bool VerifyStoredData(const uint8_t* _data, uint64_t _size, uint32_t _checksum, std::atomic<bool>& _verified, Hash _fileHash) const;
+
+	// Record the verification of stored data given its computed checksum (and the time it took to compute it in
+	// nanoseconds), returns false if the checksum doesn't match
+	bool FinishVerification(uint32_t _computedChecksum, uint64_t _size, uint64_t _elapsedTime, uint32_t _checksum, std::atomic<bool>& _verified, Hash _fileHash) const;
+
+	// Read the data stored at the given location and verify its checksum (if needed), ranges that are read using direct
+	// I/O are streamed through the direct I/O file in bounce buffer sized chunks (not going through the page cache)
+	bool VerifyStoredRange(const CondensedFileReader& _reader, uint64_t _location, uint64_t _size, uint32_t _checksum, std::atomic<bool>& _verified, Hash _fileHash) const;
+
+	// Return the verified state for an entry
+	std::atomic<bool>& GetEntryVerifiedState(const CondensedEntryInfo& _entryInfo, const CondensedLayer& _layer) const;
+
+	// Update the read statistics
+	void RecordRead(uint64_t _size) const;
+
+	// Advise the system about the stored ranges of the given files (the ranges that touch are advised together)
+	void AdviseEntries(const std::vector<Hash>& _fileHashes, bool _willBeNeeded) const;
+
+	// Verify (if needed) the data read directly for an entry and update the read statistics
+	bool FinishDirectRead(const DirectRead& _directRead) const;
+
+	// Return the info for the solid block that contains the given entry, returns nullptr if the block is invalid
+	const CondensedBlockInfo* GetSolidBlockInfo(const CondensedEntryInfo& _entryInfo, const CondensedLayer& _layer) const;
+
+	// Return a decompressed solid block, from the block cache if possible
+	std::shared_ptr<const std::vector<uint8_t>> GetSolidBlockData(uint32_t _blockIndex, const CondensedLayer& _layer, Hash _fileHash) const;
+
+	// Read the packet data, opening the manifest of each layer
+	bool ReadPacketData(std::string _packetManifestDirectory, const std::vector<std::string>& _overlayDirectories);
+
+	// Build the merged index with the visible entries from all layers
+	void BuildMergedIndex();
 
 	// Process the packet data
 	void ProcessPacketData();
 
-	// This method will return the hashes of the files that needs to be updated or doesn't exist for the input packed path, the 
-	// date created, version and file write dates will be considered when generating this list, this is a costly method and should 
-	// be used with caution
-	std::vector<Hash> GetFileHashesThatNeedUpdate(std::string _packetManifestDirectory);
-
 ///////////////
 // VARIABLES //
 private: //////
@@ -114,17 +266,50 @@ private: //////
 	// If the packed data was loaded successfully
 	bool m_PackedDataLoaded;
 
-	// The condensed header
-	CondensedHeaderInfo m_CondensedFileHeader;
+	// How our condensed files are read and when their checksums are verified
+	CondensedReaderMode m_ReaderMode;
+	CondensedVerifyMode m_VerifyMode;
+
+	// The mounted layers, from the lowest to the highest
+	std::vector<CondensedLayer> m_Layers;
 
-	// All the condensed file infos
-	std::vector<CondensedFileInfo> m_CondensedFileInfos;
+	// When overlays are mounted, the merged index (using an Eytzinger layout, 1-based) contains the hash of each visible
+	// entry (shadowed and removed entries are left out) and the merged entries are in the same order, so a lookup is 
+	// still a single walk. Without overlays the manifest index is used directly
+	std::vector<uint64_t> m_MergedIndex;
+	std::vector<MergedEntry> m_MergedEntries;
 
-	// Our condensed file readers
+	// Our condensed file readers (one for each condensed file inside each layer)
 	std::vector<CondensedFileReader> m_FileReaders;
 
-	// Our internal file info map
-	std::map<HashPrimitive, MappedInternalFileInfo> m_MappedInternalFileInfos;
+	// The asynchronous reader, the maximum gap between two direct reads that are merged and the minimum size of a read
+	// that uses direct I/O
+	mutable PacketAsyncReader m_AsyncReader;
+	uint64_t m_ReadCoalesceGap;
+	uint64_t m_DirectReadMinimumSize;
+
+	// The solid block cache, the most recently used blocks are kept at the front of the list
+	mutable std::mutex m_SolidBlockCacheMutex;
+	mutable std::list<CachedSolidBlock> m_SolidBlockCache;
+	mutable std::unordered_map<uint32_t, std::list<CachedSolidBlock>::iterator> m_SolidBlockCacheMap;
+	mutable uint64_t m_SolidBlockCacheSize = 0;
+	uint64_t m_SolidBlockCacheMaximumSize;
+
+	// If each entry and each solid block (considering all layers) was already verified
+	std::unique_ptr<std::atomic<bool>[]> m_VerifiedEntries;
+	std::unique_ptr<std::atomic<bool>[]> m_VerifiedBlocks;
+
+	// The loader statistics (the verification time is in nanoseconds)
+	mutable std::atomic<uint64_t> m_TotalReads = 0;
+	mutable std::atomic<uint64_t> m_TotalReadBytes = 0;
+	mutable std::atomic<uint64_t> m_TotalVerifications = 0;
+	mutable std::atomic<uint64_t> m_TotalVerifiedBytes = 0;
+	mutable std::atomic<uint64_t> m_TotalVerificationTime = 0;
+	mutable std::atomic<uint64_t> m_TotalVerificationFailures = 0;
+	mutable std::atomic<uint64_t> m_TotalCoalescedReads = 0;
+	mutable std::atomic<uint64_t> m_TotalDirectIoReads = 0;
+	mutable std::atomic<uint64_t> m_TotalPrefetchedBytes = 0;
+	mutable std::atomic<uint64_t> m_TotalEvictedBytes = 0;
 };
 
 // Packet data explorer
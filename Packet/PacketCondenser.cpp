@@ -2,14 +2,31 @@
 // Filename: FluxMyWrapper.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "PacketCondenser.h"
+#include "PacketCompression.h"
+#include "PacketContentHash.h"
+#include "PacketChecksum.h"
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <unordered_map>
 
 ///////////////
 // NAMESPACE //
 ///////////////
 PacketUsingDevelopmentNamespace(Packet)
 
+// The maximum amount of sample data used to train a dictionary, relative to the dictionary size
+static const uint64_t DictionaryMaximumSampleRatio = 100;
+
+// How many work items each condense thread can process ahead of the writer
+static const size_t CondenseItemsInFlightPerThread = 4;
+
 PacketCondenser::PacketCondenser()
 {
 	// Set the initial data
@@ -20,116 +37,622 @@ PacketCondenser::~PacketCondenser()
 {
 }
 
-std::vector<CondensedFileInfo> PacketCondenser::CondenseFolder(std::string _rootPath, uint32_t _currentCondenseFileCount, std::vector<std::pair<Hash, std::string>>& _fileInfos)
+bool PacketCondenser::CondenseFileTree(std::string _rootPath, 
+                                       const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+                                       PacketCondenseSettings _settings, 
+                                       const std::vector<uint8_t>& _dictionary, 
+                                       std::vector<CondensedFileInfo>& _condensedFileInfosOut, 
+                                       PacketLogger* _logger)
 {
-	// Out output vector
-	std::vector<CondensedFileInfo> output;
-
-	// Check if we have at last one file
-	if (_fileInfos.size() == 0)
-	{
-		// There is nothing to be done
-		return output;
-	}
+	// Out output vector, new condensed files are numbered after the ones already inside it
+	std::vector<CondensedFileInfo>& output = _condensedFileInfosOut;
+	size_t initialOutputSize = output.size();
 
 	// Get the root folder name
 	auto rootFolderName = GetRootFolder(_rootPath);
 
+	// Create the work items, the solid block groups only depend on the file sizes so the output doesn't depend on the
+	// order the items are processed
+	std::vector<CondenseWorkItem> workItems = CreateWorkItems(_fileTree, _settings);
+
+	// Get the number of threads we will use
+	uint32_t totalThreads = _settings.threadCount != 0 ? _settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	size_t maximumItemsInFlight = size_t(totalThreads) * CondenseItemsInFlightPerThread;
+
+	// The synchronization between the workers and the writer, workers can't be too far ahead of the writer so the
+	// memory used by the processed items is bounded
+	std::mutex workMutex;
+	std::condition_variable workCondition;
+	size_t nextWorkItem = 0;
+	size_t totalWrittenItems = 0;
+	bool aborted = false;
+	bool failed = false;
+
+	// The stage statistics
+	std::atomic<uint64_t> totalReadBytes = 0;
+	std::atomic<uint64_t> totalReadTime = 0;
+	std::atomic<uint64_t> totalCompressionTime = 0;
+	uint64_t totalWrittenBytes = 0;
+	uint64_t totalWriteTime = 0;
+	auto beginTime = std::chrono::steady_clock::now();
+
+	// The first file read with each content hash
+	ContentSources contentSources;
+
+	// Start the workers, each one will read and compress the next available item
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < totalThreads; i++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			while (true)
+			{
+				// Get the next work item
+				size_t workItemIndex;
+				{
+					std::unique_lock<std::mutex> lock(workMutex);
+					workCondition.wait(lock, [&]() { return aborted || nextWorkItem >= workItems.size() || nextWorkItem < totalWrittenItems + maximumItemsInFlight; });
+					if (aborted || nextWorkItem >= workItems.size())
+					{
+						return;
+					}
+
+					workItemIndex = nextWorkItem++;
+				}
+
+				// Process it
+				auto& workItem = workItems[workItemIndex];
+				ProcessWorkItem(workItem, _fileTree, _settings, _dictionary, totalReadBytes, totalReadTime, totalCompressionTime, contentSources);
+
+				// Let the writer know this item is ready
+				{
+					std::lock_guard<std::mutex> lock(workMutex);
+					workItem.isReady = true;
+				}
+				workCondition.notify_all();
+			}
+		}));
+	}
+
 	// Return a valid name for the condensed file
 	auto GetCondensedFilename = [&]()
 	{
 		std::string temp = CondensedName;
-		return rootFolderName.append(temp.append(std::to_string(_currentCondenseFileCount + output.size()).append(CondensedExtension)));
+		return std::string(rootFolderName).append(temp.append(std::to_string(output.size()).append(CondensedExtension)));
 	};
 
-	// The current condensed file info
+	// The current condensed file info, its size and the current output write file
 	CondensedFileInfo currentCondensedFileInfo = {};
-	currentCondensedFileInfo.filePath = GetCondensedFilename();
-
-	// The current condensed file size and the current output write file
 	uint64_t currentCondensedFileSize = 0;
-	std::ofstream writeFile(currentCondensedFileInfo.filePath, std::ios::out);
-	if (!writeFile.is_open())
+	std::ofstream writeFile;
+
+	// Finish the current condensed file (if any) and create a new one
+	auto BeginCondensedFile = [&]()
+	{
+		// Close the current file, set its size and insert it into the output vector
+		if (writeFile.is_open())
+		{
+			writeFile.close();
+			currentCondensedFileInfo.fileSize = currentCondensedFileSize;
+			output.push_back(currentCondensedFileInfo);
+		}
+
+		// Create another condensed file info
+		currentCondensedFileInfo = CondensedFileInfo();
+		currentCondensedFileInfo.filePath = GetCondensedFilename();
+		currentCondensedFileSize = 0;
+
+		// Open the new file
+		writeFile = std::ofstream(currentCondensedFileInfo.filePath, std::ios::out | std::ios::binary);
+		if (!writeFile.is_open())
+		{
+			// Error creating the file
+			_logger->LogError(std::string("Error trying to create the condensed file: ").append(currentCondensedFileInfo.filePath.String()).c_str());
+
+			return false;
+		}
+
+		return true;
+	};
+
+	// The location of each content written (by its content hash) and the deduplication statistics
+	std::unordered_map<uint64_t, WrittenContent> writtenContents;
+	uint64_t totalDeduplicatedFiles = 0;
+	uint64_t totalDeduplicatedBytes = 0;
+	uint64_t totalPaddingBytes = 0;
+
+	// Release a written item data and let the workers know they can continue
+	auto FinishWorkItem = [&](size_t _workItemIndex)
+	{
+		workItems[_workItemIndex].storedData = std::vector<uint8_t>();
+		workItems[_workItemIndex].fileInfos = std::vector<CondensedFileInfo::InternalFileInfo>();
+
+		{
+			std::lock_guard<std::mutex> lock(workMutex);
+			totalWrittenItems = _workItemIndex + 1;
+		}
+		workCondition.notify_all();
+	};
+
+	// Write each item in order, items from all folders share the same condensed file until it reaches the target size
+	for (size_t i = 0; i < workItems.size(); i++)
+	{
+		auto& workItem = workItems[i];
+
+		// Wait until this item is ready
+		{
+			std::unique_lock<std::mutex> lock(workMutex);
+			workCondition.wait(lock, [&]() { return workItem.isReady; });
+		}
+
+		// Check if the item was processed successfully
+		if (workItem.failed)
+		{
+			_logger->LogError(std::string("Error trying to read the file: ").append(workItem.failedPath).c_str());
+			failed = true;
+			break;
+		}
+
+		auto writeBeginTime = std::chrono::steady_clock::now();
+
+		// Check if a file with the same content was already written, in this case its entry will point to the same data
+		// (both were compared against the same content source by the workers)
+		uint64_t storedSize = uint64_t(workItem.storedData.size());
+		auto writtenContent = workItem.isSolid || !workItem.matchesContentSource ? writtenContents.end() : writtenContents.find(workItem.contentHash);
+		if (writtenContent != writtenContents.end() && writtenContent->second.size == workItem.fileInfos[0].size)
+		{
+			auto& internalFileInfo = workItem.fileInfos[0];
+			internalFileInfo.location = writtenContent->second.location;
+			internalFileInfo.storedSize = writtenContent->second.storedSize;
+			internalFileInfo.compression = writtenContent->second.compression;
+			internalFileInfo.checksum = writtenContent->second.checksum;
+
+			// Insert the file info on the condensed file that contains the data
+			auto& condensedFileInfo = writtenContent->second.condensedFileIndex == output.size() ? currentCondensedFileInfo : output[writtenContent->second.condensedFileIndex];
+			condensedFileInfo.fileInfos.push_back(internalFileInfo);
+
+			totalDeduplicatedFiles++;
+			totalDeduplicatedBytes += storedSize;
+			FinishWorkItem(i);
+
+			continue;
+		}
+
+		// Check if we need to generate another condensed file info
+		bool exceedsTargetSize = currentCondensedFileSize > 0 && currentCondensedFileSize + storedSize > _settings.packTargetSize;
+		if ((!writeFile.is_open() || exceedsTargetSize) && !BeginCondensedFile())
+		{
+			failed = true;
+			break;
+		}
+
+		// Align the item data (if needed)
+		if (_settings.alignment > 1 && storedSize >= _settings.alignmentMinimumSize)
+		{
+			uint64_t padding = (uint64_t(_settings.alignment) - (currentCondensedFileSize & (uint64_t(_settings.alignment) - 1))) & (uint64_t(_settings.alignment) - 1);
+			std::fill_n(std::ostreambuf_iterator<char>(writeFile), size_t(padding), '\0');
+			currentCondensedFileSize += padding;
+			totalPaddingBytes += padding;
+		}
+
+		// Write the item data
+		uint64_t location = currentCondensedFileSize;
+		writeFile.write(reinterpret_cast<const char*>(workItem.storedData.data()), storedSize);
+		currentCondensedFileSize += storedSize;
+
+		// Insert the block info (if this item is a solid block)
+		if (workItem.isSolid)
+		{
+			workItem.blockInfo.location = location;
+			currentCondensedFileInfo.blockInfos.push_back(workItem.blockInfo);
+		}
+
+		// Insert the file infos
+		for (auto& internalFileInfo : workItem.fileInfos)
+		{
+			internalFileInfo.location = location;
+			internalFileInfo.blockIndex = workItem.isSolid ? uint32_t(currentCondensedFileInfo.blockInfos.size() - 1) : 0;
+			currentCondensedFileInfo.fileInfos.push_back(internalFileInfo);
+		}
+
+		// Register the content written (solid blocks deduplicate their own files), only contents equal to their source
+		// can be shared
+		if (!workItem.isSolid && workItem.matchesContentSource)
+		{
+			auto& internalFileInfo = workItem.fileInfos[0];
+			writtenContents.insert({ workItem.contentHash, { uint32_t(output.size()), location, internalFileInfo.size, storedSize, internalFileInfo.compression, internalFileInfo.checksum } });
+		}
+
+		totalWrittenBytes += storedSize;
+		totalWriteTime += uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeBeginTime).count());
+		FinishWorkItem(i);
+	}
+
+	// Stop the workers (if we failed) and wait for them
+	{
+		std::lock_guard<std::mutex> lock(workMutex);
+		aborted = failed;
+	}
+	workCondition.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	// Finish the last condensed file
+	if (writeFile.is_open())
+	{
+		writeFile.close();
+		currentCondensedFileInfo.fileSize = currentCondensedFileSize;
+		output.push_back(currentCondensedFileInfo);
+	}
+
+	if (failed)
+	{
+		output.resize(initialOutputSize);
+		return false;
+	}
+
+	// Log the statistics for each stage
+	auto ToMegabytesPerSecond = [](uint64_t _bytes, uint64_t _microseconds)
+	{
+		return std::to_string(_microseconds != 0 ? (double(_bytes) / (1024.0 * 1024.0)) / (double(_microseconds) / 1000000.0) : 0.0);
+	};
+	uint64_t totalTime = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - beginTime).count());
+	_logger->LogInfo(std::string("Condensed ")
+		.append(std::to_string(totalReadBytes / (1024 * 1024)))
+		.append(" MB into ")
+		.append(std::to_string(totalWrittenBytes / (1024 * 1024)))
+		.append(" MB using ")
+		.append(std::to_string(totalThreads))
+		.append(" threads, read: ")
+		.append(ToMegabytesPerSecond(totalReadBytes, totalReadTime / totalThreads))
+		.append(" MB/s, compression: ")
+		.append(ToMegabytesPerSecond(totalReadBytes, totalCompressionTime / totalThreads))
+		.append(" MB/s, write: ")
+		.append(ToMegabytesPerSecond(totalWrittenBytes, totalWriteTime))
+		.append(" MB/s, total: ")
+		.append(ToMegabytesPerSecond(totalReadBytes, totalTime))
+		.append(" MB/s, deduplicated: ")
+		.append(std::to_string(totalDeduplicatedFiles))
+		.append(" files (")
+		.append(std::to_string(totalDeduplicatedBytes / 1024))
+		.append(" KB), alignment padding: ")
+		.append(std::to_string(totalPaddingBytes / 1024))
+		.append(" KB")
+		.c_str());
+
+	return true;
+}
+
+bool PacketCondenser::ReadAccessTrace(const std::string& _accessTracePath, std::vector<Hash>& _accessTraceOut, PacketLogger* _logger)
+{
+	// Open the trace file
+	std::ifstream file(_accessTracePath);
+	if (!file.is_open())
+	{
+		_logger->LogError(std::string("Error trying to open the access trace file: ").append(_accessTracePath).c_str());
+
+		return false;
+	}
+
+	// Each line contains a file path
+	std::string filePath;
+	while (std::getline(file, filePath))
 	{
-		// Error creating the file
-		return std::vector<CondensedFileInfo>();
+		if (!filePath.empty())
+		{
+			_accessTraceOut.push_back(Hash(filePath));
+		}
+	}
+
+	return true;
+}
+
+void PacketCondenser::OrderFileTreeByAccessTrace(std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+                                                 const std::vector<Hash>& _accessTrace)
+{
+	// Map each file hash to its location inside the file tree
+	std::unordered_map<HashPrimitive, std::pair<uint32_t, uint32_t>> fileLocations;
+	for (uint32_t folderIndex = 0; folderIndex < _fileTree.size(); folderIndex++)
+	{
+		for (uint32_t fileIndex = 0; fileIndex < _fileTree[folderIndex].second.size(); fileIndex++)
+		{
+			fileLocations.insert({ _fileTree[folderIndex].second[fileIndex].first.GetHashValue(), { folderIndex, fileIndex } });
+		}
+	}
+
+	// Move each traced file (on its first access) into the traced folder
+	std::vector<std::pair<Hash, std::string>> tracedFileInfos;
+	std::vector<std::vector<bool>> isTraced(_fileTree.size());
+	for (uint32_t folderIndex = 0; folderIndex < _fileTree.size(); folderIndex++)
+	{
+		isTraced[folderIndex].resize(_fileTree[folderIndex].second.size(), false);
+	}
+	for (auto& hash : _accessTrace)
+	{
+		auto fileLocation = fileLocations.find(hash.GetHashValue());
+		if (fileLocation == fileLocations.end() || isTraced[fileLocation->second.first][fileLocation->second.second])
+		{
+			continue;
+		}
+
+		isTraced[fileLocation->second.first][fileLocation->second.second] = true;
+		tracedFileInfos.push_back(_fileTree[fileLocation->second.first].second[fileLocation->second.second]);
+	}
+
+	// Rebuild the file tree, the traced folder comes first
+	std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>> fileTree;
+	fileTree.push_back({ std::string(), std::move(tracedFileInfos) });
+	for (uint32_t folderIndex = 0; folderIndex < _fileTree.size(); folderIndex++)
+	{
+		std::vector<std::pair<Hash, std::string>> fileInfos;
+		for (uint32_t fileIndex = 0; fileIndex < _fileTree[folderIndex].second.size(); fileIndex++)
+		{
+			if (!isTraced[folderIndex][fileIndex])
+			{
+				fileInfos.push_back(_fileTree[folderIndex].second[fileIndex]);
+			}
+		}
+
+		fileTree.push_back({ _fileTree[folderIndex].first, std::move(fileInfos) });
+	}
+
+	_fileTree = std::move(fileTree);
+}
+
+std::vector<PacketCondenser::CondenseWorkItem> PacketCondenser::CreateWorkItems(const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+                                                                                PacketCondenseSettings _settings)
+{
+	std::vector<CondenseWorkItem> workItems;
+
+	// For each folder
+	bool useSolidBlocks = _settings.compression != CondensedCompression::None && _settings.solidEntryMaximumSize > 0;
+	for (uint32_t folderIndex = 0; folderIndex < _fileTree.size(); folderIndex++)
+	{
+		// The solid block being filled
+		CondenseWorkItem solidWorkItem = {};
+		solidWorkItem.folderIndex = folderIndex;
+		solidWorkItem.isSolid = true;
+		uint64_t solidWorkItemSize = 0;
+
+		// For each file inside this folder
+		auto& fileInfos = _fileTree[folderIndex].second;
+		for (uint32_t fileIndex = 0; fileIndex < fileInfos.size(); fileIndex++)
+		{
+			// Small files are grouped into solid blocks, files whose size can't be read get their own work item so the
+			// error is reported when it's processed
+			std::error_code error;
+			uint64_t fileSize = uint64_t(std::filesystem::file_size(fileInfos[fileIndex].second, error));
+			if (!error && useSolidBlocks && fileSize <= _settings.solidEntryMaximumSize)
+			{
+				solidWorkItem.fileIndices.push_back(fileIndex);
+				solidWorkItemSize += fileSize;
+				if (solidWorkItemSize >= _settings.solidBlockSize)
+				{
+					workItems.push_back(solidWorkItem);
+					solidWorkItem.fileIndices.clear();
+					solidWorkItemSize = 0;
+				}
+
+				continue;
+			}
+
+			// Each other file is a work item
+			CondenseWorkItem workItem = {};
+			workItem.folderIndex = folderIndex;
+			workItem.isSolid = false;
+			workItem.fileIndices.push_back(fileIndex);
+			workItems.push_back(workItem);
+		}
+
+		// Insert the last solid block
+		if (solidWorkItem.fileIndices.size() > 0)
+		{
+			workItems.push_back(solidWorkItem);
+		}
 	}
 
-	// For each file inside the given folder
-	for (auto&[hash, filePath] : _fileInfos)
+	return workItems;
+}
+
+void PacketCondenser::ProcessWorkItem(CondenseWorkItem& _workItem, 
+                                      const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+                                      PacketCondenseSettings _settings, 
+                                      const std::vector<uint8_t>& _dictionary, 
+                                      std::atomic<uint64_t>& _totalReadBytes, 
+                                      std::atomic<uint64_t>& _totalReadTime, 
+                                      std::atomic<uint64_t>& _totalCompressionTime, 
+                                      ContentSources& _contentSources)
+{
+	auto readBeginTime = std::chrono::steady_clock::now();
+
+	// Read each file, solid blocks have their files concatenated (files with the same content are stored once)
+	std::vector<uint8_t> data;
+	std::unordered_map<uint64_t, uint32_t> solidBlockContents;
+	for (auto fileIndex : _workItem.fileIndices)
 	{
-		// Get the path to the file
-		auto path = std::filesystem::path(filePath);
+		auto&[hash, filePath] = _fileTree[_workItem.folderIndex].second[fileIndex];
+
+		// Get the file size and its last write time, the file could have been removed since the file tree was built
+		std::error_code sizeError, timeError;
+		auto fileSize = std::filesystem::file_size(filePath, sizeError);
+		auto fileTime = std::filesystem::last_write_time(filePath, timeError);
+		if (sizeError || timeError)
+		{
+			_workItem.failed = true;
+			_workItem.failedPath = filePath;
 
-		// Get the file size
-		auto fileSize = std::filesystem::file_size(path);
+			return;
+		}
 
 		// The condensed internal file info that we will use for this file
 		CondensedFileInfo::InternalFileInfo internalFileInfo = {};
 		internalFileInfo.hash = hash;
 		internalFileInfo.size = uint64_t(fileSize);
-		internalFileInfo.time = uint64_t(std::filesystem::last_write_time(filePath).time_since_epoch().count());
-		
-		// Check if we need to generate another condensed file info
-		if (currentCondensedFileSize + fileSize >= MaximumPackageSize)
+		internalFileInfo.time = uint64_t(fileTime.time_since_epoch().count());
+		internalFileInfo.isSolid = _workItem.isSolid;
+		internalFileInfo.blockOffset = uint32_t(data.size());
+
+		// Open the file and read its data
+		std::ifstream file(filePath, std::ios::binary);
+		data.resize(size_t(data.size() + fileSize));
+		file.read(reinterpret_cast<char*>(data.data() + internalFileInfo.blockOffset), fileSize);
+		if (!file)
 		{
-			// Insert it into the output vector
-			output.push_back(currentCondensedFileInfo);
+			// Error reading this file
+			_workItem.failed = true;
+			_workItem.failedPath = filePath;
 
-			// Create another condensed file info
-			currentCondensedFileInfo = CondensedFileInfo();
-			currentCondensedFileInfo.filePath = GetCondensedFilename();
+			return;
+		}
 
-			// Close the current file and write to a new one
-			writeFile.close();
-			writeFile = std::ofstream(currentCondensedFileInfo.filePath, std::ios::out);
-			if (!writeFile.is_open())
+		// Compute the content hash, if this file is inside a solid block that already contains the same content make 
+		// the entry point to it
+		uint64_t contentHash = PacketContentHash::Compute(data.data() + internalFileInfo.blockOffset, internalFileInfo.size);
+		if (_workItem.isSolid)
+		{
+			auto solidBlockContent = solidBlockContents.find(contentHash);
+			if (solidBlockContent != solidBlockContents.end() 
+				&& _workItem.fileInfos[solidBlockContent->second].size == internalFileInfo.size 
+				&& memcmp(data.data() + _workItem.fileInfos[solidBlockContent->second].blockOffset, data.data() + internalFileInfo.blockOffset, size_t(internalFileInfo.size)) == 0)
 			{
-				// Error creating the file
-				return std::vector<CondensedFileInfo>();
+				data.resize(internalFileInfo.blockOffset);
+				internalFileInfo.blockOffset = _workItem.fileInfos[solidBlockContent->second].blockOffset;
+			}
+			else
+			{
+				solidBlockContents.insert({ contentHash, uint32_t(_workItem.fileInfos.size()) });
 			}
-
-			// Zero the current condensed file size
-			currentCondensedFileSize = 0;
 		}
-
-		// Set the file location
-		internalFileInfo.location = currentCondensedFileSize;
-
-		// Open the target file and write it into the current condensed file
+		else
 		{
-			// Open the file
-			std::ifstream file(filePath, std::ios::binary);
-			if (!file.is_open())
+			// Compare this file with the first file read with the same content hash (if it isn't this one)
+			std::string contentSourcePath;
 			{
-				// Error openning this file
-				return std::vector<CondensedFileInfo>();
+				std::lock_guard<std::mutex> lock(_contentSources.mutex);
+				contentSourcePath = _contentSources.filePaths.insert({ contentHash, filePath }).first->second;
 			}
+			_workItem.matchesContentSource = contentSourcePath == filePath 
+				|| MatchesFileContent(contentSourcePath, data.data() + internalFileInfo.blockOffset, internalFileInfo.size);
+		}
+		_workItem.contentHash = contentHash;
+
+		_workItem.fileInfos.push_back(internalFileInfo);
+	}
+
+	auto compressionBeginTime = std::chrono::steady_clock::now();
+	uint64_t totalDataSize = uint64_t(data.size());
+
+	// Solid blocks are compressed as a whole using the shared dictionary
+	CondensedCompression compression = CondensedCompression::None;
+	if (_workItem.isSolid)
+	{
+		_workItem.storedData.resize(size_t(PacketCompression::GetMaximumCompressedSize(data.size())));
+		uint64_t compressedSize = PacketCompression::CompressBlock(data.data(), 
+		                                                            data.size(), 
+		                                                            _workItem.storedData.data(), 
+		                                                            _workItem.storedData.size(), 
+		                                                            _dictionary.data(), 
+		                                                            _dictionary.size());
+		if (compressedSize != 0 && compressedSize < data.size())
+		{
+			_workItem.storedData.resize(size_t(compressedSize));
+			compression = _settings.compression;
+		}
+
+		_workItem.blockInfo.size = uint32_t(data.size());
+	}
+	// Other files are compressed by chunks
+	else if (PacketCompression::CompressEntry(_settings.compression, data.data(), data.size(), _workItem.storedData))
+	{
+		compression = _settings.compression;
+	}
+
+	// If the data doesn't shrink it will be stored raw
+	if (compression == CondensedCompression::None)
+	{
+		_workItem.storedData = std::move(data);
+	}
 
-			// Get the file data and close the file
-			std::vector<char> buffer((unsigned int)fileSize);
-			file.read(buffer.data(), fileSize);
-			file.close();
+	// Set the compression, the stored size and the checksum for each file and the block, files inside the block are
+	// verified using the block checksum
+	uint32_t checksum = PacketChecksum::Compute(_workItem.storedData.data(), _workItem.storedData.size());
+	_workItem.blockInfo.compression = compression;
+	_workItem.blockInfo.storedSize = uint64_t(_workItem.storedData.size());
+	_workItem.blockInfo.checksum = checksum;
+	for (auto& internalFileInfo : _workItem.fileInfos)
+	{
+		internalFileInfo.compression = compression;
+		internalFileInfo.storedSize = uint64_t(_workItem.storedData.size());
+		internalFileInfo.checksum = _workItem.isSolid ? 0 : checksum;
+	}
 
-			// Write the file data
-			writeFile.write(buffer.data(), fileSize);
+	// Update the statistics
+	auto endTime = std::chrono::steady_clock::now();
+	_totalReadBytes += totalDataSize;
+	_totalReadTime += uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(compressionBeginTime - readBeginTime).count());
+	_totalCompressionTime += uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(endTime - compressionBeginTime).count());
+}
 
-			// Increment the current condensed file size
-			currentCondensedFileSize += fileSize;
+bool PacketCondenser::MatchesFileContent(const std::string& _filePath, const uint8_t* _data, uint64_t _size)
+{
+	// Compare the file one piece at a time
+	std::ifstream file(_filePath, std::ios::binary);
+	std::vector<char> buffer(size_t(std::min<uint64_t>(CompressionChunkSize, std::max<uint64_t>(_size, 1))));
+	uint64_t totalCompared = 0;
+	while (file && totalCompared < _size)
+	{
+		file.read(buffer.data(), std::streamsize(std::min<uint64_t>(buffer.size(), _size - totalCompared)));
+		uint64_t totalRead = uint64_t(file.gcount());
+		if (totalRead == 0 || memcmp(buffer.data(), _data + totalCompared, size_t(totalRead)) != 0)
+		{
+			return false;
 		}
+		totalCompared += totalRead;
+	}
+
+	// The file must end with the data
+	return totalCompared == _size && file.peek() == std::ifstream::traits_type::eof();
+}
 
-		// Set the file info
-		currentCondensedFileInfo.fileInfos[currentCondensedFileInfo.totalNumberFiles] = internalFileInfo;
+std::vector<uint8_t> PacketCondenser::TrainSolidBlockDictionary(const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, PacketCondenseSettings _settings)
+{
+	// Check if we are using solid blocks and a dictionary
+	if (_settings.compression == CondensedCompression::None || _settings.solidEntryMaximumSize == 0 || _settings.dictionarySize == 0)
+	{
+		return std::vector<uint8_t>();
+	}
 
-		// Increment the total number of files
-		currentCondensedFileInfo.totalNumberFiles++;
+	// Find all files that will be stored inside solid blocks
+	std::vector<std::string> solidFilePaths;
+	uint64_t totalSolidFilesSize = 0;
+	for (auto& folderInfo : _fileTree)
+	{
+		for (auto&[hash, filePath] : folderInfo.second)
+		{
+			// Files whose size can't be read are skipped, they will fail when their work item is processed
+			std::error_code error;
+			auto fileSize = std::filesystem::file_size(filePath, error);
+			if (!error && fileSize > 0 && fileSize <= _settings.solidEntryMaximumSize)
+			{
+				solidFilePaths.push_back(filePath);
+				totalSolidFilesSize += fileSize;
+			}
+		}
 	}
 
-	// Close the current condensed file
-	writeFile.close();
+	// Big trees can have way more data than needed to train the dictionary, in this case we evenly pick some files
+	uint64_t maximumSamplesSize = _settings.dictionarySize * DictionaryMaximumSampleRatio;
+	size_t sampleStep = size_t(std::max<uint64_t>(1, (totalSolidFilesSize + maximumSamplesSize - 1) / maximumSamplesSize));
 
-	// Insert the current condensed file into the output vector
-	output.push_back(currentCondensedFileInfo);
+	// Read the samples
+	std::vector<std::vector<uint8_t>> samples;
+	for (size_t i = 0; i < solidFilePaths.size(); i += sampleStep)
+	{
+		std::ifstream file(solidFilePaths[i], std::ios::binary);
+		samples.push_back(std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+	}
 
-	return output;
-}
\ No newline at end of file
+	return PacketCompression::TrainDictionary(samples, _settings.dictionarySize);
+}
@@ -9,6 +9,10 @@
 #include "PacketConfig.h"
 
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 ///////////////
 // NAMESPACE //
@@ -42,7 +46,52 @@ PacketDevelopmentNamespaceBegin(Packet)
 ////////////////////////////////////////////////////////////////////////////////
 class PacketCondenser
 {
-public:
+private:
+
+	// A file or a group of small files (a solid block) that is read and compressed by one of the condense threads
+	struct CondenseWorkItem
+	{
+		// The folder index and the indices of the files (inside this folder) that belong to this item
+		uint32_t folderIndex = 0;
+		std::vector<uint32_t> fileIndices;
+
+		// If this item is a solid block
+		bool isSolid = false;
+
+		// The content hash (for items with a single file) and if the content is equal to the first file read with the 
+		// same hash, only these items can share their data so a hash collision never makes an entry point to another 
+		// content
+		uint64_t contentHash = 0;
+		bool matchesContentSource = false;
+
+		// The processed data, ready to be written
+		std::vector<uint8_t> storedData;
+		std::vector<CondensedFileInfo::InternalFileInfo> fileInfos;
+		CondensedFileInfo::InternalBlockInfo blockInfo = {};
+
+		// If this item was processed and if it failed
+		bool isReady = false;
+		bool failed = false;
+		std::string failedPath;
+	};
+
+	// The first file read with each content hash, the other files with the same hash are compared against it
+	struct ContentSources
+	{
+		std::mutex mutex;
+		std::unordered_map<uint64_t, std::string> filePaths;
+	};
+
+	// The location of a content that was already written
+	struct WrittenContent
+	{
+		uint32_t condensedFileIndex;
+		uint64_t location;
+		uint64_t size;
+		uint64_t storedSize;
+		CondensedCompression compression;
+		uint32_t checksum;
+	};
 
 //////////////////
 // CONSTRUCTORS //
@@ -56,12 +105,53 @@ public: //////////
 // MAIN METHODS //
 public: //////////
 
-	// This method will receive a folder name and a vector vector of file hashes/paths and will package them all
-	// together, returning the correspondent number of condensed file infos
-    std::vector<CondensedFileInfo> CondenseFolder(
+	// This method will receive the file tree (folder names and their file hashes/paths) and will package them all
+	// together, appending the correspondent condensed file infos to the given vector (new condensed files are numbered
+	// after the ones already inside it). Files are read and compressed by multiple threads while the calling thread 
+	// writes them in order, so the output is the same for any number of threads. The dictionary is used when 
+	// compressing solid blocks
+    bool CondenseFileTree(
         std::string _rootPath,
-        uint32_t _currentCondenseFileCount,
-        std::vector<std::pair<Hash, std::string>>& _fileInfos);
+        const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        PacketCondenseSettings _settings, 
+        const std::vector<uint8_t>& _dictionary, 
+        std::vector<CondensedFileInfo>& _condensedFileInfosOut, 
+        PacketLogger* _logger);
+
+	// Train the dictionary used by the solid blocks, using the files that will be stored inside them as samples
+	std::vector<uint8_t> TrainSolidBlockDictionary(
+        const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        PacketCondenseSettings _settings);
+
+	// Read an access trace (one file path per line) recorded by PacketSystem::BeginAccessTrace()
+	bool ReadAccessTrace(const std::string& _accessTracePath, std::vector<Hash>& _accessTraceOut, PacketLogger* _logger);
+
+	// Move the files inside the access trace into a new folder (placed before the others) in the order they were first
+	// loaded, so they are condensed together and in load order
+	void OrderFileTreeByAccessTrace(
+        std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        const std::vector<Hash>& _accessTrace);
+
+private:
+
+	// Split the file tree into work items, small files are grouped into solid blocks based only on their sizes
+	std::vector<CondenseWorkItem> CreateWorkItems(
+        const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        PacketCondenseSettings _settings);
+
+	// Read and compress the files that belong to the given work item
+	void ProcessWorkItem(
+        CondenseWorkItem& _workItem, 
+        const std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        PacketCondenseSettings _settings, 
+        const std::vector<uint8_t>& _dictionary, 
+        std::atomic<uint64_t>& _totalReadBytes, 
+        std::atomic<uint64_t>& _totalReadTime, 
+        std::atomic<uint64_t>& _totalCompressionTime, 
+        ContentSources& _contentSources);
+
+	// Compare the content of a file with the given data
+	static bool MatchesFileContent(const std::string& _filePath, const uint8_t* _data, uint64_t _size);
 	
 ///////////////
 // VARIABLES //
@@ -11,6 +11,8 @@
 #include <filesystem>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 /////////////
 // DEFINES //
@@ -36,9 +38,8 @@ PacketDevelopmentNamespaceBegin(Packet)
 // The maximum file path name
 static const int FilePathSize					= 128;
 
-// The maximum package file size and the maximum number of files inside each package
-static const uint64_t MaximumPackageSize		= 536870912;
-static const uint32_t MaximumPackageFiles		= 2048;
+// The default target size of each condensed file
+static const uint64_t DefaultPackTargetSize		= 536870912;
 
 // The reference file extension and the condensed file name/extension
 static const std::string ReferenceExtension		= ".ref";
@@ -48,9 +49,57 @@ static const std::string CondensedInfoName		= "Data";
 static const std::string CondensedInfoExtension = ".manifest";
 static const std::string TemporaryFileExtension = ".temp";
 
-// The current condensed file minor and major versions
-static const uint16_t CondensedMinorVersion		= 1;
-static const uint16_t CondensedMajorVersion		= 0;
+// The current condensed file minor and major versions and the manifest identifier ("PKMF")
+static const uint16_t CondensedMinorVersion		= 0;
+static const uint16_t CondensedMajorVersion		= 6;
+static const uint32_t CondensedManifestMagic	= 0x464D4B50;
+
+// The size of each independently compressed chunk inside a compressed entry and the entry flags that store its compression
+static const uint64_t CompressionChunkSize			= 262144;
+static const uint32_t CondensedEntryCompressionMask	= 0x000000FF;
+
+// The entry flag used to indicate that an entry is stored inside a solid block and the default solid block cache size
+static const uint32_t CondensedEntrySolidFlag		= 0x00000100;
+static const uint64_t DefaultSolidBlockCacheSize	= 4194304;
+
+// The entry flag used by overlay layers to indicate that a file was removed, it hides the files with the same hash on
+// the lower layers (tombstone entries have no data)
+static const uint32_t CondensedEntryTombstoneFlag	= 0x00000200;
+
+// When condensing incrementally, the condensed files are rebuilt from scratch when more than this ratio of their data
+// is no longer used by any entry
+static const double IncrementalMaximumUnusedRatio	= 0.5;
+
+// The default number of reads the asynchronous reader keeps in flight and its default number of worker threads
+static const uint32_t DefaultAsyncReadQueueDepth	= 64;
+static const uint32_t DefaultAsyncReadThreads		= 4;
+
+// When submitting a batch of condensed reads, reads separated by at most the coalesce gap are merged into a single
+// read (the gap is read and discarded) until the merged read reaches the maximum size
+static const uint64_t DefaultReadCoalesceGap		= 65536;
+static const uint64_t ReadCoalesceMaximumSize		= 4194304;
+
+// Raw condensed reads of at least the minimum size bypass the page cache using direct I/O (0 disables it), their offset,
+// size and buffer must be aligned to the direct read alignment, unaligned heads and tails (and unaligned buffers) are
+// read through aligned bounce buffers
+static const uint64_t DefaultDirectReadMinimumSize	= 134217728;
+static const uint32_t DirectReadAlignment			= 4096;
+static const uint64_t DirectReadBounceBufferSize	= 1048576;
+
+// On edit mode the metadata of each file (if it exist and its size) is cached for this many milliseconds, so the checks
+// done while loading a resource only reach the file system once
+static const uint32_t EditMetadataCacheDuration		= 500;
+
+// The resource management thread sleeps until new work is signalled (requests, read completions, constructions and 
+// released references), waking up at most after the idle timeout (in milliseconds, 0 waits until signalled). On edit 
+// mode a 0 idle timeout uses the default since the file watcher must be polled
+static const uint32_t DefaultResourceThreadIdleTimeout	= 100;
+
+// The resource manager keeps at most this many loads in flight (being read or constructed), the other requests wait
+// and the highest priority ones are started first. Requests gain a priority level for each aging time (in milliseconds)
+// they wait, so low priority requests can't starve, and the requests whose deadline is reached go before any other
+static const uint32_t MaximumResourceLoadsInFlight	= 64;
+static const uint32_t ResourceRequestAgingTime		= 100;
 
 // The operation modes
 enum class OperationMode
@@ -59,6 +108,49 @@ enum class OperationMode
 	Condensed
 };
 
+// The condensed file reader modes
+enum class CondensedReaderMode
+{
+	// Each condensed file is read using a file stream, reads on the same file are serialized
+	Stream,
+
+	// Each condensed file is memory mapped, reads don't share any state and can happen from any thread
+	Mapped
+};
+
+// When the condensed data checksums are verified
+enum class CondensedVerifyMode
+{
+	// The checksums are never verified
+	Off,
+
+	// Each entry (or solid block) is verified the first time it's read
+	FirstRead,
+
+	// Each entry (or solid block) is verified every time it's read from its condensed file
+	EveryRead
+};
+
+// How the file loaders perform asynchronous reads
+enum class AsyncReadMode
+{
+	// Use io_uring when the kernel supports it, else use the thread pool
+	Automatic,
+
+	// Always use the thread pool, each worker performs blocking reads
+	ThreadPool
+};
+
+// The compression used by a condensed entry (the value is stored inside the manifest, don't change it)
+enum class CondensedCompression : uint8_t
+{
+	// The entry is stored raw
+	None = 0,
+
+	// The entry is split into chunks compressed using the LZ4 block format
+	LZ4 = 1
+};
+
 // The reference fixer types
 enum class ReferenceFixer
 {
@@ -236,6 +328,141 @@ struct PacketResourceBuildInfo
 	// If the Resource Object can be deleted synchronous (without being sure if that will happen inside the update 
 	// phase of the resource manager)
 	bool asyncResourceObjectDeletion = true;
+
+	// The request priority, higher priorities are loaded first (see ResourceRequestAgingTime), and the time (in 
+	// milliseconds after the request) the resource should be ready by, 0 means no deadline. Neither one makes resources
+	// different between each other
+	uint32_t priority = 0;
+	uint32_t deadline = 0;
+};
+
+// The packet system settings, used when initializing the packet system
+struct PacketSystemSettings
+{
+	// How the condensed files should be read when operating on condensed mode
+	CondensedReaderMode condensedReaderMode = CondensedReaderMode::Mapped;
+
+	// The maximum amount of memory used to keep decompressed solid blocks when operating on condensed mode
+	uint64_t solidBlockCacheSize = DefaultSolidBlockCacheSize;
+
+	// When the condensed data checksums are verified when operating on condensed mode
+	CondensedVerifyMode condensedVerifyMode = CondensedVerifyMode::FirstRead;
+
+	// The overlay directories mounted over the condensed files when operating on condensed mode (each one constructed
+	// using PacketCondenseSettings::overlayDirectory), from the lowest to the highest layer. Files on higher layers 
+	// shadow the ones with the same hash on the lower layers
+	std::vector<std::string> condensedOverlayDirectories;
+
+	// How the file loaders perform asynchronous reads, the maximum number of reads kept in flight and the number of 
+	// worker threads (used for reads that can't be submitted to io_uring and when it isn't available)
+	AsyncReadMode asyncReadMode = AsyncReadMode::Automatic;
+	uint32_t asyncReadQueueDepth = DefaultAsyncReadQueueDepth;
+	uint32_t asyncReadThreads = DefaultAsyncReadThreads;
+
+	// The maximum gap between two condensed reads submitted together that still allows them to be merged into a single 
+	// read when operating on condensed mode
+	uint64_t readCoalesceGap = DefaultReadCoalesceGap;
+
+	// The minimum size of a raw condensed read that bypasses the page cache using direct I/O when operating on condensed
+	// mode (0 disables direct I/O), resources can receive an aligned buffer using PacketResourceFactory::AllocateAlignedData()
+	uint64_t directReadMinimumSize = DefaultDirectReadMinimumSize;
+
+	// If the data tree is indexed in memory when operating on edit mode, the existence and size checks are answered by
+	// the index (kept current by a file watcher) instead of reaching the file system
+	bool editDirectoryIndex = false;
+
+	// The maximum time (in milliseconds) the resource management thread sleeps when there is no work to do, new requests
+	// wake it up immediately, 0 sleeps until a new request arrives (see DefaultResourceThreadIdleTimeout)
+	uint32_t resourceThreadIdleTimeout = DefaultResourceThreadIdleTimeout;
+
+	// The number of threads that construct the resources concurrently (running PacketResource::OnConstruct()), 0 
+	// constructs them one after the other on the resource management thread. Each resource is only constructed once
+	// (requests for a resource that is still being loaded wait for the same object), but the factories and resources 
+	// must support constructing different resources at the same time
+	uint32_t resourceLoadThreads = 0;
+};
+
+// The file loader statistics
+struct PacketFileLoaderStats
+{
+	// The total number of files read and the number of bytes returned
+	uint64_t totalReads = 0;
+	uint64_t totalReadBytes = 0;
+
+	// The total number of checksum verifications, the number of bytes verified, the time spent verifying them (in 
+	// microseconds) and how many verifications failed
+	uint64_t totalVerifications = 0;
+	uint64_t totalVerifiedBytes = 0;
+	uint64_t totalVerificationTime = 0;
+	uint64_t totalVerificationFailures = 0;
+
+	// The total number of asynchronous reads that were merged with their neighbours into a single bigger read
+	uint64_t totalCoalescedReads = 0;
+
+	// The total number of reads that bypassed the page cache using direct I/O and how many of their bytes were read 
+	// through bounce buffers (because their range or buffer wasn't aligned)
+	uint64_t totalDirectIoReads = 0;
+	uint64_t totalBounceBufferBytes = 0;
+
+	// The total number of stored bytes the system was asked to prefetch and to evict
+	uint64_t totalPrefetchedBytes = 0;
+	uint64_t totalEvictedBytes = 0;
+};
+
+// The resource manager statistics
+struct PacketResourceManagerStats
+{
+	// The total number of requests cancelled because their reference was released (or reset) before they were 
+	// processed, nothing was read or constructed for them
+	uint64_t totalCancelledRequests = 0;
+
+	// The total number of times the management thread processed its queues, it only wakes up to do it when signalled
+	// (or when its idle timeout elapses)
+	uint64_t totalManagementPasses = 0;
+};
+
+// The condense settings, used when constructing the condensed files
+struct PacketCondenseSettings
+{
+	// The compression used on each entry, entries that don't shrink are always stored raw
+	CondensedCompression compression = CondensedCompression::None;
+
+	// Entries with at most this size are grouped (by folder) into solid blocks that are compressed as a whole, this 
+	// requires a compression to be set, 0 disables solid blocks
+	uint64_t solidEntryMaximumSize = 0;
+
+	// The target uncompressed size of each solid block
+	uint64_t solidBlockSize = 65536;
+
+	// The maximum size of the dictionary trained using the solid entries and shared by all solid blocks (only the 
+	// last 64KB can be used), 0 disables the dictionary
+	uint64_t dictionarySize = 32768;
+
+	// Entries and solid blocks with at least alignmentMinimumSize stored bytes begin at a multiple of alignment inside
+	// their condensed file (the gap is filled with zeros), allowing direct I/O and page granular mapping. The alignment
+	// must be a power of two, 0 disables it
+	uint32_t alignment = 0;
+	uint64_t alignmentMinimumSize = 0;
+
+	// Entries from all folders are placed into condensed files (shards) of about this size, a new condensed file begins
+	// when the next entry would go beyond it (entries bigger than it get their own condensed file)
+	uint64_t packTargetSize = DefaultPackTargetSize;
+
+	// The number of threads used to read and compress the files, 0 uses one thread per hardware thread
+	uint32_t threadCount = 0;
+
+	// An access trace recorded by PacketSystem::BeginAccessTrace(), the files inside it are placed before the others
+	// in the order they were first loaded, so resources loaded together are read sequentially
+	std::string accessTracePath;
+
+	// Reuse the current condensed files, only new and modified files are condensed (into new condensed files) and the
+	// removed ones are dropped from the manifest. The current dictionary is kept
+	bool incremental = false;
+
+	// Construct an overlay layer on this directory instead of replacing the current condensed files, it contains only
+	// the files that are new or were modified since the current condensed files were constructed, plus a tombstone for
+	// each removed file. Each overlay contains every change, so a new overlay replaces the previous one
+	std::string overlayDirectory;
 };
 
 // The path type
@@ -345,21 +572,111 @@ private:
 	Path m_Path;
 };
 
-// The condensed header info
+// The condensed manifest header, the first 16 bytes keep the same layout on every version so older manifests can
+// always be identified (and rejected) by their major version
 struct CondensedHeaderInfo
 {
 	// The time this file was saved
 	uint64_t saveTime;
 
-	// The total number of file infos
-	uint32_t totalInfos;
+	// The manifest identifier
+	uint32_t magic;
 
 	// The minor and major version indexes
 	uint16_t minorVersion;
 	uint16_t majorVersion;
+
+	// The total number of condensed files, entries and solid blocks
+	uint32_t totalPacks;
+	uint32_t totalEntries;
+	uint32_t totalBlocks;
+
+	// The alignment (in bytes) used for the aligned entries and solid blocks, an entry is aligned if its location is a
+	// multiple of it, 0 if nothing is aligned
+	uint32_t alignment;
+
+	// The location of each table inside the manifest file, the string table size and the dictionary size
+	uint64_t packTableLocation;
+	uint64_t indexTableLocation;
+	uint64_t entryTableLocation;
+	uint64_t blockTableLocation;
+	uint64_t stringTableLocation;
+	uint64_t stringTableSize;
+	uint64_t dictionaryLocation;
+	uint64_t dictionarySize;
+};
+
+// A condensed file (pack) info as stored inside the manifest
+struct CondensedPackInfo
+{
+	// The condensed file size
+	uint64_t size;
+
+	// The condensed file path location inside the string table
+	uint32_t pathLocation;
+
+	// The total number of entries stored inside this condensed file
+	uint32_t totalEntries;
+};
+
+// A condensed entry info as stored inside the manifest, entries are stored in the same order as the index table
+struct CondensedEntryInfo
+{
+	// The entry hash
+	uint64_t hash;
+
+	// The entry location inside its condensed file, its size, its last write time and the number of bytes it uses
+	// inside the condensed file (equal to its size if the entry isn't compressed)
+	uint64_t location;
+	uint64_t size;
+	uint64_t time;
+	uint64_t storedSize;
+
+	// The condensed file index that contains this entry
+	uint32_t packIndex;
+
+	// The entry flags, the first 8 bits contain the entry compression
+	uint32_t flags;
+
+	// The entry directory and name locations inside the string table (the full path is the concatenation of both)
+	uint32_t directoryLocation;
+	uint32_t nameLocation;
+
+	// If the entry is stored inside a solid block, the block index and the entry location inside the decompressed block
+	uint32_t blockIndex;
+	uint32_t blockOffset;
+
+	// The CRC32C checksum of the stored data (entries inside solid blocks are verified using their block checksum)
+	uint32_t checksum;
+	uint32_t reserved;
+};
+
+// A solid block info as stored inside the manifest, a solid block contains multiple small entries compressed together
+struct CondensedBlockInfo
+{
+	// The block location inside its condensed file and the number of bytes it uses there
+	uint64_t location;
+	uint64_t storedSize;
+
+	// The decompressed block size
+	uint32_t size;
+
+	// The condensed file index that contains this block
+	uint32_t packIndex;
+
+	// The block flags, the first 8 bits contain the block compression (the shared dictionary is always used)
+	uint32_t flags;
+
+	// The CRC32C checksum of the stored data
+	uint32_t checksum;
 };
 
-// The packet condensed file info
+static_assert(sizeof(CondensedHeaderInfo) == 96, "The condensed header layout must not depend on the compiler");
+static_assert(sizeof(CondensedPackInfo) == 16, "The condensed pack info layout must not depend on the compiler");
+static_assert(sizeof(CondensedEntryInfo) == 72, "The condensed entry info layout must not depend on the compiler");
+static_assert(sizeof(CondensedBlockInfo) == 32, "The condensed block info layout must not depend on the compiler");
+
+// The packet condensed file info, used when constructing the condensed files
 struct CondensedFileInfo
 {
 	// A internal file info
@@ -370,16 +687,74 @@ struct CondensedFileInfo
 		uint64_t location;
 		uint64_t size;
 		uint64_t time;
+
+		// The number of bytes used inside the condensed file and the compression used
+		uint64_t storedSize;
+		CondensedCompression compression;
+
+		// If this entry is inside a solid block, the block index (inside this condensed file) and its location inside 
+		// the decompressed block
+		bool isSolid;
+		uint32_t blockIndex;
+		uint32_t blockOffset;
+
+		// The stored data checksum
+		uint32_t checksum;
+	};
+
+	// A internal solid block info
+	struct InternalBlockInfo
+	{
+		// The block location, the number of bytes it uses, its decompressed size and the compression used
+		uint64_t location;
+		uint64_t storedSize;
+		uint32_t size;
+		CondensedCompression compression;
+
+		// The stored data checksum
+		uint32_t checksum;
 	};
 
 	// The path to the condensed file
 	Path filePath;
 
-	// The total number of files inside
-	uint32_t totalNumberFiles = 0;
+	// The total condensed file size
+	uint64_t fileSize = 0;
 
 	// All the internal file infos
-	InternalFileInfo fileInfos[MaximumPackageFiles];
+	std::vector<InternalFileInfo> fileInfos;
+
+	// All the internal solid block infos
+	std::vector<InternalBlockInfo> blockInfos;
+};
+
+// A read-only view into a file data that lives inside memory owned by the file loader
+struct PacketFileDataView
+{
+	// The viewed data and its size
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+
+	// Keeps the memory that holds the data alive while this view (or any copy of it) exists
+	std::shared_ptr<const void> owner;
+};
+
+// An asynchronous read request, _size bytes starting at the given offset are read into the output buffer (that must stay
+// alive until the read completes), the user data identifies the read on its completion
+struct PacketReadRequest
+{
+	Hash hash;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	uint8_t* dataOut = nullptr;
+	uint64_t userData = 0;
+};
+
+// An asynchronous read completion
+struct PacketReadCompletion
+{
+	uint64_t userData = 0;
+	bool succeeded = false;
 };
 
 // PacketFileLoader interface
@@ -389,6 +764,7 @@ public:
 
 	// Constructor
 	PacketFileLoader(std::string _packetManifestDirectory, PacketLogger* _logger) : m_PacketFolderPath(_packetManifestDirectory), m_Logger(_logger) {}
+	virtual ~PacketFileLoader() {}
 
 //////////////////
 // MAIN METHODS //
@@ -403,8 +779,57 @@ public: //////////
 	// Get the file data
 	virtual bool GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const = 0;
 
+	// Get a read-only view into the file data without copying it, this is only supported by loaders that keep 
+	// the file data in memory, returning false means the data must be read using GetFileData()
+	virtual bool GetFileDataView(PacketFileDataView& /*_viewOut*/, Hash /*_fileHash*/) const { return false; }
+
+	// Read _size bytes of the file data starting at the given offset, fails if the range goes past the end of the file
+	virtual bool ReadRange(Hash _fileHash, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const = 0;
+
+	// Forget any cached metadata for the given file, called when the file is known to have changed
+	virtual void InvalidateFileMetadata(Hash /*_fileHash*/) const {}
+
+	// Process the pending background work (like file watcher events), called periodically by the resource management
+	// thread (always from the same thread) so the file queries don't need to do it
+	virtual void Update() const {}
+
+	// Return the buffer alignment that lets a read of the given file range land directly in its output buffer, 0 means
+	// any buffer is fine (unaligned buffers still work but they may need an extra copy)
+	virtual uint32_t GetReadAlignment(Hash /*_fileHash*/, uint64_t /*_offset*/, uint64_t /*_size*/) const { return 0; }
+
+	// Read a file finding it only once, the allocator is called with the file size and must return the buffer that 
+	// will receive the data (returning nullptr for a non empty file aborts the read), loaders that can find a file faster than calling GetFileSize() and
+	// GetFileData() in sequence should override this
+	virtual bool ReadFile(Hash _fileHash, const std::function<uint8_t*(uint64_t)>& _allocator) const
+	{
+		uint64_t fileSize = GetFileSize(_fileHash);
+		uint8_t* dataOut = _allocator(fileSize);
+		return (dataOut != nullptr || fileSize == 0) && GetFileData(dataOut, fileSize, _fileHash);
+	}
+
+	// Submit a batch of asynchronous reads, each read completes on its own and its completion is returned by 
+	// DrainReadCompletions() (failed reads are completed too), the output buffers must stay alive until then
+	virtual void SubmitReads(const std::vector<PacketReadRequest>& _requests) const = 0;
+
+	// Append the completions of the reads that finished since the last call, returns how many were appended
+	virtual uint32_t DrainReadCompletions(std::vector<PacketReadCompletion>& _completionsOut) const = 0;
+
+	// Set the callback that is called (from any thread) each time an asynchronous read completes, so the thread that
+	// drains the completions doesn't need to poll for them
+	virtual void SetReadCompletionCallback(std::function<void()> _callback) const = 0;
+
+	// Start reading the given files data into memory in the background without constructing anything, so they can be
+	// loaded faster later, loaders that can't do it ignore this
+	virtual void Prefetch(const std::vector<Hash>& /*_fileHashes*/) const {}
+
+	// Release the memory used to cache the given files data, used when they are known to be cold
+	virtual void Evict(const std::vector<Hash>& /*_fileHashes*/) const {}
+
 	// Pack all files
-	virtual bool ConstructPacket() = 0;
+	virtual bool ConstructPacket(PacketCondenseSettings _settings) = 0;
+
+	// Return the loader statistics
+	virtual PacketFileLoaderStats GetStats() const { return PacketFileLoaderStats(); }
 
 ///////////////
 // VARIABLES //
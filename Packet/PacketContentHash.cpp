@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketContentHash.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketContentHash.h"
+#include <cstring>
+
+///////////////
+// NAMESPACE //
+///////////////
+PacketUsingDevelopmentNamespace(Packet)
+
+// The XXH64 primes
+static const uint64_t Prime1 = 11400714785074694791ULL;
+static const uint64_t Prime2 = 14029467366897019727ULL;
+static const uint64_t Prime3 = 1609587929392839161ULL;
+static const uint64_t Prime4 = 9650029242287828579ULL;
+static const uint64_t Prime5 = 2870177450012600261ULL;
+
+static uint64_t RotateLeft(uint64_t _value, uint32_t _bits)
+{
+	return (_value << _bits) | (_value >> (64 - _bits));
+}
+
+static uint64_t ReadLittleEndian64(const uint8_t* _data)
+{
+	uint64_t value;
+	memcpy(&value, _data, sizeof(uint64_t));
+	return value;
+}
+
+static uint32_t ReadLittleEndian32(const uint8_t* _data)
+{
+	uint32_t value;
+	memcpy(&value, _data, sizeof(uint32_t));
+	return value;
+}
+
+static uint64_t Round(uint64_t _accumulator, uint64_t _input)
+{
+	_accumulator += _input * Prime2;
+	_accumulator = RotateLeft(_accumulator, 31);
+	return _accumulator * Prime1;
+}
+
+static uint64_t MergeRound(uint64_t _accumulator, uint64_t _value)
+{
+	_accumulator ^= Round(0, _value);
+	return _accumulator * Prime1 + Prime4;
+}
+
+uint64_t PacketContentHash::Compute(const uint8_t* _data, uint64_t _size, uint64_t _seed)
+{
+	const uint8_t* current = _data;
+	const uint8_t* end = _data + _size;
+	uint64_t hash;
+
+	// Process the data in 32 byte stripes using 4 independent accumulators
+	if (_size >= 32)
+	{
+		uint64_t accumulators[4] = { _seed + Prime1 + Prime2, _seed + Prime2, _seed, _seed - Prime1 };
+		while (current + 32 <= end)
+		{
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				accumulators[i] = Round(accumulators[i], ReadLittleEndian64(current));
+				current += 8;
+			}
+		}
+
+		hash = RotateLeft(accumulators[0], 1) + RotateLeft(accumulators[1], 7) + RotateLeft(accumulators[2], 12) + RotateLeft(accumulators[3], 18);
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			hash = MergeRound(hash, accumulators[i]);
+		}
+	}
+	else
+	{
+		hash = _seed + Prime5;
+	}
+
+	hash += _size;
+
+	// Process the remaining bytes
+	while (current + 8 <= end)
+	{
+		hash ^= Round(0, ReadLittleEndian64(current));
+		hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+		current += 8;
+	}
+
+	if (current + 4 <= end)
+	{
+		hash ^= uint64_t(ReadLittleEndian32(current)) * Prime1;
+		hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+		current += 4;
+	}
+
+	while (current < end)
+	{
+		hash ^= uint64_t(*current) * Prime5;
+		hash = RotateLeft(hash, 11) * Prime1;
+		current++;
+	}
+
+	// Final avalanche
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
@@ -0,0 +1,52 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketContentHash.h
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//////////////
+// INCLUDES //
+//////////////
+#include "PacketConfig.h"
+
+///////////////
+// NAMESPACE //
+///////////////
+
+/////////////
+// DEFINES //
+/////////////
+
+////////////
+// GLOBAL //
+////////////
+
+///////////////
+// NAMESPACE //
+///////////////
+
+// Packet data explorer
+PacketDevelopmentNamespaceBegin(Packet)
+
+////////////////
+// FORWARDING //
+////////////////
+
+////////////////
+// STRUCTURES //
+////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PacketContentHash
+////////////////////////////////////////////////////////////////////////////////
+class PacketContentHash
+{
+//////////////////
+// MAIN METHODS //
+public: //////////
+
+	// Compute the 64 bit hash of the given data (using the XXH64 algorithm), used to find files with the same content
+	static uint64_t Compute(const uint8_t* _data, uint64_t _size, uint64_t _seed = 0);
+};
+
+// Packet data explorer
+PacketDevelopmentNamespaceEnd(Packet)
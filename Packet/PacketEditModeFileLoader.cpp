@@ -2,81 +2,400 @@
 // Filename: FluxMyWrapper.cpp
 ////////////////////////////////////////////////////////////////////////////////
 #include "PacketEditModeFileLoader.h"
+#include "PacketCondensedManifest.h"
 #include <filesystem>
 #include <fstream>
+#include <set>
+#include <unordered_set>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
 
 ///////////////
 // NAMESPACE //
 ///////////////
 PacketUsingDevelopmentNamespace(Packet)
 
-PacketEditModeFileLoader::PacketEditModeFileLoader(std::string _packetManifestDirectory, PacketLogger* _logger) : PacketFileLoader(_packetManifestDirectory, _logger)
+PacketEditModeFileLoader::PacketEditModeFileLoader(std::string _packetManifestDirectory, 
+                                                   PacketLogger* _logger, 
+                                                   uint32_t _asyncReadThreads, 
+                                                   bool _useDirectoryIndex) : 
+	PacketFileLoader(_packetManifestDirectory, _logger), 
+	m_UseDirectoryIndex(_useDirectoryIndex), 
+	m_DirectoryIndexListener(this)
 {
+	// Setup the asynchronous reads, each file is opened by the read itself so io_uring isn't used
+	m_AsyncReader.Initialize(AsyncReadMode::ThreadPool, 0, _asyncReadThreads, m_Logger);
+
+	// Build the directory index, the data tree is scanned only once
+	if (m_UseDirectoryIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+		IndexFolder(_packetManifestDirectory);
+	}
 }
 
 PacketEditModeFileLoader::~PacketEditModeFileLoader()
 {
+	// Finish the queued asynchronous reads
+	m_AsyncReader.Release();
 }
 
 bool PacketEditModeFileLoader::FileExist(Hash _fileHash) const
 {
-	// Get the path
-	auto filePath = std::filesystem::path(_fileHash.GetPath().String());
+	uint64_t fileSize = 0;
+	return GetFileMetadata(_fileHash, fileSize);
+}
+
+uint64_t PacketEditModeFileLoader::GetFileSize(Hash _fileHash) const
+{
+	// Invalid files have size 0
+	uint64_t fileSize = 0;
+	GetFileMetadata(_fileHash, fileSize);
 
-	// Check if the file exist and is valid
-	if (std::filesystem::exists(filePath) && !std::filesystem::is_directory(filePath))
+	return fileSize;
+}
+
+bool PacketEditModeFileLoader::GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const
+{
+	return ReadFileData(_fileHash, 0, _bufferSize, false, [_dataOut](uint64_t) { return _dataOut; });
+}
+
+bool PacketEditModeFileLoader::ReadRange(Hash _fileHash, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const
+{
+	return ReadFileData(_fileHash, _offset, _size, false, [_dataOut](uint64_t) { return _dataOut; });
+}
+
+bool PacketEditModeFileLoader::ReadFile(Hash _fileHash, const std::function<uint8_t*(uint64_t)>& _allocator) const
+{
+	return ReadFileData(_fileHash, 0, 0, true, _allocator);
+}
+
+void PacketEditModeFileLoader::InvalidateFileMetadata(Hash _fileHash) const
+{
+	if (m_UseDirectoryIndex)
 	{
-		// Valid file
-		return true;
+		std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+		m_DirectoryIndex.erase(uint64_t(_fileHash.GetHashValue()));
 	}
-	else
+
+	std::lock_guard<std::mutex> lock(m_MetadataCacheMutex);
+	m_MetadataCache.erase(uint64_t(_fileHash.GetHashValue()));
+}
+
+void PacketEditModeFileLoader::Update() const
+{
+	// The events are handled by the watcher listener, each one only locks the directory index while changing it so 
+	// the file queries aren't blocked while the events are read
+	if (m_UseDirectoryIndex)
+	{
+		m_DirectoryWatcher.update();
+	}
+}
+
+bool PacketEditModeFileLoader::GetFileMetadata(Hash _fileHash, uint64_t& _sizeOut) const
+{
+	// Check the directory index (kept current by Update()), files that aren't there are checked on the file system below
+	if (m_UseDirectoryIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+
+		auto iter = m_DirectoryIndex.find(uint64_t(_fileHash.GetHashValue()));
+		if (iter != m_DirectoryIndex.end())
+		{
+			_sizeOut = iter->second;
+			return true;
+		}
+	}
+
+	// Check if the metadata is cached and still recent
 	{
-		// File doesn't exist or ir a path to a directory
+		std::lock_guard<std::mutex> lock(m_MetadataCacheMutex);
+		auto iter = m_MetadataCache.find(uint64_t(_fileHash.GetHashValue()));
+		if (iter != m_MetadataCache.end())
+		{
+			if (std::chrono::steady_clock::now() - iter->second.time < std::chrono::milliseconds(EditMetadataCacheDuration))
+			{
+				_sizeOut = iter->second.size;
+				return true;
+			}
+
+			m_MetadataCache.erase(iter);
+		}
+	}
+
+	// Get if the file exist, its type and size using a single call
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(_fileHash.GetPath().String(), GetFileExInfoStandard, &attributes) 
+		|| (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+	{
+		// File doesn't exist or is a path to a directory
 		return false;
 	}
+
+	uint64_t fileSize = (uint64_t(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+#else
+	struct stat fileStatus;
+	if (stat(_fileHash.GetPath().String(), &fileStatus) != 0 || S_ISDIR(fileStatus.st_mode))
+	{
+		// File doesn't exist or is a path to a directory
+		return false;
+	}
+
+	uint64_t fileSize = uint64_t(fileStatus.st_size);
+#endif
+
+	CacheFileMetadata(_fileHash, fileSize);
+	_sizeOut = fileSize;
+
+	return true;
 }
 
-uint64_t PacketEditModeFileLoader::GetFileSize(Hash _fileHash) const
+void PacketEditModeFileLoader::CacheFileMetadata(Hash _fileHash, uint64_t _size) const
 {
-	// Get the path
-	auto filePath = std::filesystem::path(_fileHash.GetPath().String());
+	if (m_UseDirectoryIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+		m_DirectoryIndex[uint64_t(_fileHash.GetHashValue())] = _size;
+	}
 
-	// Check if the file exist and is valid
-	if (std::filesystem::exists(filePath) && !std::filesystem::is_directory(filePath))
+	std::lock_guard<std::mutex> lock(m_MetadataCacheMutex);
+	m_MetadataCache[uint64_t(_fileHash.GetHashValue())] = { _size, std::chrono::steady_clock::now() };
+}
+
+void PacketEditModeFileLoader::IndexFolder(const std::string& _folderPath) const
+{
+	// Scan the folder, the file paths are the same ones used when condensing
+	PacketScanner scanner;
+	try
 	{
-		// Valid file
-		return uint64_t(std::filesystem::file_size(filePath));
+		scanner.Scan(_folderPath);
 	}
+	catch (const std::filesystem::filesystem_error& _error)
+	{
+		m_Logger->LogWarning(std::string("Error indexing the folder: ").append(_folderPath).append(", ").append(_error.what()).c_str());
 
-	// Invalid file
-	return 0;
+		return;
+	}
+
+	for (auto& [folderPath, fileInfos] : scanner.GetFileTreeHashInfos())
+	{
+		// Watch the folder, if it can't be watched its files are still indexed (their changes are only noticed when
+		// they are read again)
+		try
+		{
+			m_DirectoryWatcher.addWatch(folderPath, const_cast<DirectoryIndexListener*>(&m_DirectoryIndexListener));
+		}
+		catch (const FWPacket::Exception& _exception)
+		{
+			m_Logger->LogWarning(std::string("Error watching the folder: ").append(folderPath).append(", ").append(_exception.what()).c_str());
+		}
+
+		for (auto& [hash, filePath] : fileInfos)
+		{
+			std::error_code errorCode;
+			uint64_t fileSize = uint64_t(std::filesystem::file_size(filePath, errorCode));
+			if (!errorCode)
+			{
+				m_DirectoryIndex[uint64_t(hash.GetHashValue())] = fileSize;
+			}
+		}
+	}
 }
 
-bool PacketEditModeFileLoader::GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const
+void PacketEditModeFileLoader::HandleDirectoryAction(const std::string& _directory, const std::string& _filename, FWPacket::Action _action) const
 {
-	// Open the file and check if we are ok to proceed
-	std::ifstream file(_fileHash.GetPath().String(), std::ios::binary);
-	if (!file.is_open())
+	// Get the path the same way the scanner does
+	std::string filePath = (std::filesystem::path(_directory) / _filename).relative_path().string();
+	uint64_t hashValue = uint64_t(Hash(filePath).GetHashValue());
+
+	// The cached metadata for this file isn't valid anymore
 	{
-		// Error openning the file!
+		std::lock_guard<std::mutex> lock(m_MetadataCacheMutex);
+		m_MetadataCache.erase(hashValue);
+	}
+
+	// Removed files leave the index, new and modified files get their current size and new folders are indexed (the
+	// file system is checked before locking the index)
+	std::error_code errorCode;
+	auto fileStatus = std::filesystem::status(filePath, errorCode);
+	if (_action == FWPacket::Actions::Delete || errorCode || !std::filesystem::exists(fileStatus))
+	{
+		std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+		m_DirectoryIndex.erase(hashValue);
+	}
+	else if (std::filesystem::is_directory(fileStatus))
+	{
+		std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+		IndexFolder(filePath);
+	}
+	else
+	{
+		uint64_t fileSize = uint64_t(std::filesystem::file_size(filePath, errorCode));
+		if (!errorCode)
+		{
+			std::lock_guard<std::mutex> lock(m_DirectoryIndexMutex);
+			m_DirectoryIndex[hashValue] = fileSize;
+		}
+	}
+}
+
+bool PacketEditModeFileLoader::ReadFileData(Hash _fileHash, 
+                                            uint64_t _offset, 
+                                            uint64_t _size, 
+                                            bool _readWholeFile, 
+                                            const std::function<uint8_t*(uint64_t)>& _allocator) const
+{
+	// Open the file and get its size from the opened descriptor (directories can't be read)
+#ifdef _WIN32
+	HANDLE file = CreateFileA(_fileHash.GetPath().String(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		// Error openning the file, it may have been removed so its metadata isn't valid anymore
+		InvalidateFileMetadata(_fileHash);
 		return false;
 	}
 
-	// Read the file data
-	if (file.read((char*)_dataOut, _bufferSize))
+	LARGE_INTEGER fileSizeInfo;
+	if (!GetFileSizeEx(file, &fileSizeInfo))
 	{
-		return true;
+		CloseHandle(file);
+		return false;
 	}
 
-	return false;
+	uint64_t fileSize = uint64_t(fileSizeInfo.QuadPart);
+#else
+	int file = open(_fileHash.GetPath().String(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		// Error openning the file, it may have been removed so its metadata isn't valid anymore
+		InvalidateFileMetadata(_fileHash);
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(file, &fileStatus) != 0 || S_ISDIR(fileStatus.st_mode))
+	{
+		close(file);
+		return false;
+	}
+
+	uint64_t fileSize = uint64_t(fileStatus.st_size);
+#endif
+
+	// The size we just got is the most recent one
+	CacheFileMetadata(_fileHash, fileSize);
+
+	// Check if the range is inside the file
+	if (_readWholeFile)
+	{
+		_size = fileSize;
+	}
+	bool succeeded = true;
+	if (_offset > fileSize || _size > fileSize - _offset)
+	{
+		m_Logger->LogError(std::string("Error reading the file: ")
+			.append(_fileHash.GetPath())
+			.append(", trying to read ")
+			.append(std::to_string(_size))
+			.append(" bytes at offset ")
+			.append(std::to_string(_offset))
+			.append(" but the file only has ")
+			.append(std::to_string(fileSize))
+			.append(" bytes!")
+			.c_str());
+
+		succeeded = false;
+	}
+
+	// Get the output buffer and read the range
+	uint8_t* dataOut = succeeded ? _allocator(_size) : nullptr;
+	succeeded = succeeded && (dataOut != nullptr || _size == 0);
+	uint64_t totalRead = 0;
+	while (succeeded && totalRead < _size)
+	{
+		uint64_t chunkSize = std::min<uint64_t>(_size - totalRead, 0x40000000);
+#ifdef _WIN32
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = DWORD((_offset + totalRead) & 0xffffffff);
+		overlapped.OffsetHigh = DWORD((_offset + totalRead) >> 32);
+
+		DWORD bytesRead = 0;
+		succeeded = ::ReadFile(file, dataOut + totalRead, DWORD(chunkSize), &bytesRead, &overlapped) && bytesRead != 0;
+#else
+		ssize_t bytesRead = pread(file, dataOut + totalRead, size_t(chunkSize), off_t(_offset + totalRead));
+		if (bytesRead < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		succeeded = bytesRead > 0;
+#endif
+
+		totalRead += succeeded ? uint64_t(bytesRead) : 0;
+	}
+
+#ifdef _WIN32
+	CloseHandle(file);
+#else
+	close(file);
+#endif
+
+	return succeeded;
 }
 
-bool PacketEditModeFileLoader::ConstructPacket()
+void PacketEditModeFileLoader::SubmitReads(const std::vector<PacketReadRequest>& _requests) const
+{
+	for (const auto& request : _requests)
+	{
+		m_AsyncReader.SubmitTask([this, request]()
+		{
+			return ReadRange(request.hash, request.offset, request.size, request.dataOut);
+		}, request.userData);
+	}
+}
+
+uint32_t PacketEditModeFileLoader::DrainReadCompletions(std::vector<PacketReadCompletion>& _completionsOut) const
+{
+	return m_AsyncReader.DrainCompletions(_completionsOut);
+}
+
+void PacketEditModeFileLoader::SetReadCompletionCallback(std::function<void()> _callback) const
+{
+	m_AsyncReader.SetCompletionCallback(std::move(_callback));
+}
+
+bool PacketEditModeFileLoader::ConstructPacket(PacketCondenseSettings _settings)
 {
 	////////////////////
 	// INITIALIZATION //
 	////////////////////
 
+	// Check if the alignment is valid
+	if ((_settings.alignment & (_settings.alignment - 1)) != 0)
+	{
+		m_Logger->LogError(std::string("The condense alignment: ").append(std::to_string(_settings.alignment)).append(" must be a power of two!").c_str());
+
+		return false;
+	}
+
+	// Check if the condensed file target size is valid
+	if (_settings.packTargetSize == 0)
+	{
+		m_Logger->LogError("The condensed file target size must be greater than zero!");
+
+		return false;
+	}
+
 	// Scan the packet tree and file/folder info
 	m_Scanner.Scan(m_PacketFolderPath);
 
@@ -104,53 +423,306 @@ bool PacketEditModeFileLoader::ConstructPacket()
 	// CONDENSE //
 	//////////////
 
-	// For each folder info
+	// Get the root folder name
+	auto rootFolderName = GetRootFolder(m_PacketFolderPath);
+
+	// Setup the condensed info file name
+	std::string condensedInfoName = rootFolderName;
+	condensedInfoName.append(CondensedInfoName);
+	condensedInfoName.append(CondensedInfoExtension);
+
+	// When constructing an overlay, its condensed files and manifest are placed on the overlay directory
+	bool isOverlay = !_settings.overlayDirectory.empty();
+	std::string outputPath = isOverlay ? _settings.overlayDirectory : m_PacketFolderPath;
+	std::string outputInfoName = GetRootFolder(outputPath).append(CondensedInfoName).append(CondensedInfoExtension);
+
+	// Place the files inside the access trace (if any) before the others, in the order they were first loaded, and
+	// count how many seeks the traced loads need using the current condensed files
+	std::vector<Hash> accessTrace;
+	uint64_t totalSeeksBefore = 0;
+	if (!_settings.accessTracePath.empty())
+	{
+		if (!m_PacketCondenser.ReadAccessTrace(_settings.accessTracePath, accessTrace, m_Logger))
+		{
+			return false;
+		}
+
+		m_PacketCondenser.OrderFileTreeByAccessTrace(fileTree, accessTrace);
+
+		PacketCondensedManifest manifest;
+		if (std::filesystem::exists(condensedInfoName) && manifest.Open(condensedInfoName, m_Logger))
+		{
+			totalSeeksBefore = manifest.CountAccessSeeks(accessTrace);
+		}
+	}
+
+	// When condensing incrementally, reuse the unchanged entries from the current condensed files and condense only
+	// the files that changed
 	std::vector<CondensedFileInfo> condensedFileInfos;
-	for (auto& folderInfo : fileTree)
+	std::vector<Hash> removedFiles;
+	std::vector<uint8_t> dictionary;
+	if (isOverlay)
+	{
+		// An overlay contains only the new and modified files, condensed with its own dictionary
+		if (!CollectOverlayChanges(condensedInfoName, fileTree, removedFiles))
+		{
+			return false;
+		}
+
+		dictionary = m_PacketCondenser.TrainSolidBlockDictionary(fileTree, _settings);
+		std::filesystem::create_directories(_settings.overlayDirectory);
+	}
+	else if (!_settings.incremental || !CollectUnchangedEntries(condensedInfoName, _settings, fileTree, condensedFileInfos, dictionary))
 	{
-		// Process this folder info
-		auto condensedFiles = m_PacketCondenser.CondenseFolder(m_PacketFolderPath, uint32_t(condensedFileInfos.size()), folderInfo.second);
+		// Train the dictionary used by the solid blocks (if they are enabled)
+		dictionary = m_PacketCondenser.TrainSolidBlockDictionary(fileTree, _settings);
+	}
 
-		// Merge the vectors
-		condensedFileInfos.insert(condensedFileInfos.end(), condensedFiles.begin(), condensedFiles.end());
+	// Condense all folders
+	if (!m_PacketCondenser.CondenseFileTree(outputPath, fileTree, _settings, dictionary, condensedFileInfos, m_Logger))
+	{
+		return false;
 	}
 
 	//////////////////////
 	// CREATE INFO FILE //
 	//////////////////////
 	{
-		// Get the root folder name
-		auto rootFolderName = GetRootFolder(m_PacketFolderPath);
+		// Write the manifest file
+		if (!PacketCondensedManifest::Write(outputInfoName, condensedFileInfos, removedFiles, dictionary, _settings.alignment, m_Logger))
+		{
+			return false;
+		}
+	}
+
+	// Report how many seeks the traced loads need now
+	if (!accessTrace.empty())
+	{
+		PacketCondensedManifest manifest;
+		if (manifest.Open(outputInfoName, m_Logger))
+		{
+			m_Logger->LogInfo(std::string("The access trace with ")
+				.append(std::to_string(accessTrace.size()))
+				.append(" loads needed ")
+				.append(std::to_string(totalSeeksBefore))
+				.append(" seeks before condensing and needs ")
+				.append(std::to_string(manifest.CountAccessSeeks(accessTrace)))
+				.append(" seeks now")
+				.c_str());
+		}
+	}
+
+	return true;
+}
+
+bool PacketEditModeFileLoader::CollectUnchangedEntries(const std::string& _manifestPath, 
+                                                       PacketCondenseSettings _settings, 
+                                                       std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+                                                       std::vector<CondensedFileInfo>& _condensedFileInfosOut, 
+                                                       std::vector<uint8_t>& _dictionaryOut)
+{
+	// Check if there is a manifest to be reused
+	if (!std::filesystem::exists(_manifestPath))
+	{
+		return false;
+	}
+
+	// Open the current manifest, it will be closed (before being replaced) when we return
+	PacketCondensedManifest manifest;
+	if (!manifest.Open(_manifestPath, m_Logger))
+	{
+		return false;
+	}
+
+	// The alignment recorded on the manifest must be valid for every condensed file
+	if (manifest.GetAlignment() != _settings.alignment)
+	{
+		m_Logger->LogInfo("The condense alignment changed, the packet will be constructed again");
 
-		// Setup the condensed info file name
-		std::string condensedInfoName = rootFolderName;
-		condensedInfoName.append(CondensedInfoName);
-		condensedInfoName.append(CondensedInfoExtension);
+		return false;
+	}
 
-		// Create the file and check if we are ok to proceed
-		std::ofstream file(condensedInfoName, std::ios::binary);
-		if (!file.is_open())
+	// Setup one condensed file info for each current condensed file, all of them are kept (even if none of their
+	// entries are used anymore) so the new condensed files can be numbered after them
+	std::vector<CondensedFileInfo> condensedFileInfos(manifest.GetTotalPacks());
+	std::vector<uint32_t> firstBlockIndices(manifest.GetTotalPacks(), manifest.GetTotalBlocks());
+	uint64_t totalDataSize = 0;
+	for (uint32_t i = 0; i < manifest.GetTotalPacks(); i++)
+	{
+		const CondensedPackInfo& packInfo = manifest.GetPack(i);
+		condensedFileInfos[i].filePath = manifest.GetPackPath(packInfo);
+		condensedFileInfos[i].fileSize = packInfo.size;
+		totalDataSize += packInfo.size;
+
+		// The condensed file must still be there
+		std::error_code errorCode;
+		if (std::filesystem::file_size(condensedFileInfos[i].filePath.String(), errorCode) != packInfo.size || errorCode)
 		{
-			// Error openning the file!
+			m_Logger->LogWarning(std::string("The condensed file: ").append(condensedFileInfos[i].filePath.String()).append(" changed, the packet will be constructed again").c_str());
+
 			return false;
 		}
+	}
 
-		// Setup the condensed header info
-		CondensedHeaderInfo condensedHeader;
-		condensedHeader.totalInfos = uint32_t(condensedFileInfos.size());
-		condensedHeader.saveTime = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
-		condensedHeader.majorVersion = CondensedMajorVersion;
-		condensedHeader.minorVersion = CondensedMinorVersion;
+	// Keep every solid block (the ones without used entries are small), the block indices on each condensed file
+	// info are relative to it
+	for (uint32_t i = 0; i < manifest.GetTotalBlocks(); i++)
+	{
+		const CondensedBlockInfo& blockInfo = manifest.GetBlock(i);
+		firstBlockIndices[blockInfo.packIndex] = std::min(firstBlockIndices[blockInfo.packIndex], i);
 
-		// Save the header info
-		file.write((char*)&condensedHeader, sizeof(CondensedHeaderInfo));
+		CondensedFileInfo::InternalBlockInfo internalBlockInfo = {};
+		internalBlockInfo.location = blockInfo.location;
+		internalBlockInfo.storedSize = blockInfo.storedSize;
+		internalBlockInfo.size = blockInfo.size;
+		internalBlockInfo.compression = CondensedCompression(blockInfo.flags & CondensedEntryCompressionMask);
+		internalBlockInfo.checksum = blockInfo.checksum;
+		condensedFileInfos[blockInfo.packIndex].blockInfos.push_back(internalBlockInfo);
+	}
 
-		// Save the file infos
-		file.write((char*)condensedFileInfos.data(), sizeof(CondensedFileInfo) * condensedFileInfos.size());
+	// For each file inside the file tree, reuse its entry if it wasn't modified, else keep it on the file tree so it
+	// will be condensed again. Removed files are not on the file tree so their entries are dropped
+	std::set<std::pair<uint32_t, uint64_t>> usedLocations;
+	uint64_t usedDataSize = 0;
+	uint32_t totalUnchangedEntries = 0;
+	uint32_t totalChangedEntries = 0;
+	std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>> changedFileTree;
+	for (auto& folderInfo : _fileTree)
+	{
+		std::vector<std::pair<Hash, std::string>> changedFileInfos;
+		for (auto& fileInfo : folderInfo.second)
+		{
+			// Check if the entry exist and if it has the same path, size and write time
+			auto&[hash, filePath] = fileInfo;
+			const CondensedEntryInfo* entryInfo = manifest.FindEntry(hash.GetHashValue());
+			if (!IsEntryUnchanged(manifest, entryInfo, filePath))
+			{
+				changedFileInfos.push_back(fileInfo);
+				totalChangedEntries++;
+
+				continue;
+			}
+
+			// Reuse the entry
+			CondensedFileInfo::InternalFileInfo internalFileInfo = {};
+			internalFileInfo.hash = hash;
+			internalFileInfo.location = entryInfo->location;
+			internalFileInfo.size = entryInfo->size;
+			internalFileInfo.time = entryInfo->time;
+			internalFileInfo.storedSize = entryInfo->storedSize;
+			internalFileInfo.compression = CondensedCompression(entryInfo->flags & CondensedEntryCompressionMask);
+			internalFileInfo.isSolid = (entryInfo->flags & CondensedEntrySolidFlag) != 0;
+			internalFileInfo.checksum = entryInfo->checksum;
+			if (internalFileInfo.isSolid)
+			{
+				internalFileInfo.blockIndex = entryInfo->blockIndex - firstBlockIndices[entryInfo->packIndex];
+				internalFileInfo.blockOffset = entryInfo->blockOffset;
+			}
+
+			// The same data can be shared by many entries (solid blocks and deduplicated files)
+			if (usedLocations.insert({ entryInfo->packIndex, entryInfo->location }).second)
+			{
+				usedDataSize += entryInfo->storedSize;
+			}
+			condensedFileInfos[entryInfo->packIndex].fileInfos.push_back(internalFileInfo);
+			totalUnchangedEntries++;
+		}
+
+		changedFileTree.push_back({ folderInfo.first, std::move(changedFileInfos) });
+	}
 
-		// Close the file
-		file.close();
+	// Check if too much data inside the current condensed files is unused, in this case it's better to construct the
+	// packet again
+	if (double(totalDataSize - usedDataSize) > double(totalDataSize) * IncrementalMaximumUnusedRatio)
+	{
+		m_Logger->LogInfo("Most of the condensed data is no longer used, the packet will be constructed again");
+
+		return false;
 	}
 
+	// Only the changed files will be condensed
+	_fileTree = std::move(changedFileTree);
+
+	// Keep the current dictionary, the reused solid blocks were compressed with it
+	_dictionaryOut.assign(manifest.GetDictionary(), manifest.GetDictionary() + manifest.GetDictionarySize());
+	_condensedFileInfosOut = std::move(condensedFileInfos);
+
+	m_Logger->LogInfo(std::string("Condensing incrementally, ")
+		.append(std::to_string(totalUnchangedEntries))
+		.append(" unchanged entries were kept and ")
+		.append(std::to_string(totalChangedEntries))
+		.append(" entries will be condensed")
+		.c_str());
+
 	return true;
-}
\ No newline at end of file
+}
+
+bool PacketEditModeFileLoader::CollectOverlayChanges(const std::string& _manifestPath, 
+                                                     std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+                                                     std::vector<Hash>& _removedFilesOut)
+{
+	// The overlay is constructed over the current condensed files
+	PacketCondensedManifest manifest;
+	if (!std::filesystem::exists(_manifestPath) || !manifest.Open(_manifestPath, m_Logger))
+	{
+		m_Logger->LogError(std::string("An overlay must be constructed over the current condensed files, none were found on: ")
+			.append(m_PacketFolderPath)
+			.c_str());
+
+		return false;
+	}
+
+	// Keep only the new and modified files on the file tree
+	std::unordered_set<uint64_t> currentFiles;
+	uint32_t totalChangedFiles = 0;
+	for (auto& folderInfo : _fileTree)
+	{
+		auto& fileInfos = folderInfo.second;
+		fileInfos.erase(std::remove_if(fileInfos.begin(), fileInfos.end(), [&](const std::pair<Hash, std::string>& _fileInfo)
+		{
+			currentFiles.insert(uint64_t(_fileInfo.first.GetHashValue()));
+			return IsEntryUnchanged(manifest, manifest.FindEntry(_fileInfo.first.GetHashValue()), _fileInfo.second);
+		}), fileInfos.end());
+
+		totalChangedFiles += uint32_t(fileInfos.size());
+	}
+
+	// Each condensed entry that isn't on the file tree anymore was removed
+	for (uint32_t i = 0; i < manifest.GetTotalEntries(); i++)
+	{
+		const CondensedEntryInfo& entryInfo = manifest.GetEntries()[i];
+		if ((entryInfo.flags & CondensedEntryTombstoneFlag) == 0 && currentFiles.find(entryInfo.hash) == currentFiles.end())
+		{
+			_removedFilesOut.push_back(Hash(manifest.GetEntryPath(entryInfo)));
+		}
+	}
+
+	m_Logger->LogInfo(std::string("Constructing an overlay with ")
+		.append(std::to_string(totalChangedFiles))
+		.append(" new or modified files and ")
+		.append(std::to_string(_removedFilesOut.size()))
+		.append(" removed files")
+		.c_str());
+
+	return true;
+}
+
+bool PacketEditModeFileLoader::IsEntryUnchanged(const PacketCondensedManifest& _manifest, const CondensedEntryInfo* _entryInfo, const std::string& _filePath) const
+{
+	if (_entryInfo == nullptr || (_entryInfo->flags & CondensedEntryTombstoneFlag) != 0)
+	{
+		return false;
+	}
+
+	// A file that can't be accessed anymore (it could have been removed after the scan) is considered changed, it
+	// will fail when it's condensed
+	std::error_code sizeError, timeError;
+	auto fileSize = std::filesystem::file_size(_filePath, sizeError);
+	auto fileTime = std::filesystem::last_write_time(_filePath, timeError);
+
+	return !sizeError 
+		&& !timeError 
+		&& _entryInfo->size == uint64_t(fileSize)
+		&& _entryInfo->time == uint64_t(fileTime.time_since_epoch().count())
+		&& _manifest.GetEntryPath(*_entryInfo) == _filePath;
+}
@@ -9,8 +9,13 @@
 #include "PacketConfig.h"
 #include "PacketScanner.h"
 #include "PacketCondenser.h"
+#include "PacketAsyncReader.h"
+#include "ThirdParty/FileWatcher/FileWatcher.h"
 
 #include <string>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
 
 ///////////////
 // NAMESPACE //
@@ -35,6 +40,8 @@ PacketDevelopmentNamespaceBegin(Packet)
 // FORWARDING //
 ////////////////
 
+class PacketCondensedManifest;
+
 ////////////////
 // STRUCTURES //
 ////////////////
@@ -44,31 +51,125 @@ PacketDevelopmentNamespaceBegin(Packet)
 ////////////////////////////////////////////////////////////////////////////////
 class PacketEditModeFileLoader : public PacketFileLoader
 {
-public:
+private:
+
+	// The cached metadata for an existing file and when it was cached
+	struct FileMetadata
+	{
+		uint64_t size;
+		std::chrono::steady_clock::time_point time;
+	};
+
+	// The directory index watch listener type
+	struct DirectoryIndexListener : public FWPacket::FileWatchListener
+	{
+		// Create passing a reference to the file loader
+		DirectoryIndexListener(const PacketEditModeFileLoader* _fileLoader) : m_FileLoaderPtr(_fileLoader) {}
+
+		// Forward the file action to the file loader
+		void handleFileAction(FWPacket::WatchID, const FWPacket::String& _dir, const FWPacket::String& _filename, FWPacket::Action _action) override
+		{
+			m_FileLoaderPtr->HandleDirectoryAction(_dir, _filename, _action);
+		}
+
+	private:
+
+		// A pointer to the file loader
+		const PacketEditModeFileLoader* m_FileLoaderPtr;
+	};
 
 //////////////////
 // CONSTRUCTORS //
 public: //////////
 
 	// Constructor / destructor
-	PacketEditModeFileLoader(std::string _packetManifestDirectory, PacketLogger* _logger);
+	PacketEditModeFileLoader(std::string _packetManifestDirectory, 
+                             PacketLogger* _logger, 
+                             uint32_t _asyncReadThreads = DefaultAsyncReadThreads, 
+                             bool _useDirectoryIndex = false);
 	~PacketEditModeFileLoader();
 
 //////////////////
 // MAIN METHODS //
 public: //////////
 
-	// Check if a given file exist
+	// Check if a given file exist (using the directory index or the metadata cache)
 	bool FileExist(Hash _fileHash) const override;
 
-	// Return a file size
+	// Return a file size (using the directory index or the metadata cache)
 	uint64_t GetFileSize(Hash _fileHash) const override;
 
 	// Get the file data
 	bool GetFileData(uint8_t* _dataOut, uint64_t _bufferSize, Hash _fileHash) const override;
 
+	// Read a range of the file data
+	bool ReadRange(Hash _fileHash, uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const override;
+
+	// Read a file getting its size from the opened file, so it's opened and its path resolved only once
+	bool ReadFile(Hash _fileHash, const std::function<uint8_t*(uint64_t)>& _allocator) const override;
+
+	// Forget the cached metadata for the given file
+	void InvalidateFileMetadata(Hash _fileHash) const override;
+
+	// Process the pending directory index file watcher events
+	void Update() const override;
+
+	// Submit a batch of asynchronous reads, each file must be opened before its data can be read so they are always 
+	// read by the worker threads
+	void SubmitReads(const std::vector<PacketReadRequest>& _requests) const override;
+
+	// Append the completions of the asynchronous reads that finished since the last call
+	uint32_t DrainReadCompletions(std::vector<PacketReadCompletion>& _completionsOut) const override;
+
+	// Set the callback that is called each time an asynchronous read completes
+	void SetReadCompletionCallback(std::function<void()> _callback) const override;
+
 	// Pack all files
-	bool ConstructPacket() override;
+	bool ConstructPacket(PacketCondenseSettings _settings) override;
+
+private:
+
+	// Reuse the unchanged entries from the given manifest, setting up one condensed file info for each current condensed
+	// file and removing the unchanged files from the file tree. Returns false (and keeps the file tree untouched) if the 
+	// current condensed files can't be reused
+	bool CollectUnchangedEntries(
+        const std::string& _manifestPath, 
+        PacketCondenseSettings _settings, 
+        std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        std::vector<CondensedFileInfo>& _condensedFileInfosOut, 
+        std::vector<uint8_t>& _dictionaryOut);
+
+	// Remove the files that didn't change since the given manifest was constructed from the file tree (leaving only the
+	// new and modified ones) and return the files that were removed, used when constructing an overlay layer
+	bool CollectOverlayChanges(
+        const std::string& _manifestPath, 
+        std::vector<std::pair<std::string, std::vector<std::pair<Hash, std::string>>>>& _fileTree, 
+        std::vector<Hash>& _removedFilesOut);
+
+	// Return if the given file exist (and isn't a directory) and its size, the metadata cache is used when it's recent
+	bool GetFileMetadata(Hash _fileHash, uint64_t& _sizeOut) const;
+
+	// Store the metadata for an existing file on the cache (and on the directory index)
+	void CacheFileMetadata(Hash _fileHash, uint64_t _size) const;
+
+	// Scan the given folder adding its files to the directory index and watching it (and its sub folders) for changes,
+	// the directory index mutex must be held
+	void IndexFolder(const std::string& _folderPath) const;
+
+	// Update the directory index after a file inside a watched folder changed
+	void HandleDirectoryAction(const std::string& _directory, const std::string& _filename, FWPacket::Action _action) const;
+
+	// Open a file, get its size from the opened descriptor and read the given range of it (the whole file when 
+	// _readWholeFile is set), the output buffer is returned by the allocator once the read size is known
+	bool ReadFileData(
+        Hash _fileHash, 
+        uint64_t _offset, 
+        uint64_t _size, 
+        bool _readWholeFile, 
+        const std::function<uint8_t*(uint64_t)>& _allocator) const;
+
+	// Return if the given manifest entry still represents the given file (same path, size and write time)
+	bool IsEntryUnchanged(const PacketCondensedManifest& _manifest, const CondensedEntryInfo* _entryInfo, const std::string& _filePath) const;
 
 ///////////////
 // VARIABLES //
@@ -77,6 +178,23 @@ private: //////
 	// The helper objects
 	PacketScanner m_Scanner;
 	PacketCondenser m_PacketCondenser;
+
+	// The asynchronous reader
+	mutable PacketAsyncReader m_AsyncReader;
+
+	// The metadata cache (keyed by the file hash value), only existing files are cached
+	mutable std::unordered_map<uint64_t, FileMetadata> m_MetadataCache;
+	mutable std::mutex m_MetadataCacheMutex;
+
+	// The directory index (if enabled) with the size of each file inside the data tree (keyed by the file hash value),
+	// the watcher that keeps it current (its events are processed by Update()) and the mutex that protects the index.
+	// Files missing from the index are checked on the file system, so a file created before its event is processed is
+	// still found
+	bool m_UseDirectoryIndex;
+	mutable std::unordered_map<uint64_t, uint64_t> m_DirectoryIndex;
+	mutable FWPacket::FileWatcher m_DirectoryWatcher;
+	DirectoryIndexListener m_DirectoryIndexListener;
+	mutable std::mutex m_DirectoryIndexMutex;
 };
 
 // Packet data explorer
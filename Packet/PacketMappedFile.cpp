@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketMappedFile.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "PacketMappedFile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+///////////////
+// NAMESPACE //
+///////////////
+PacketUsingDevelopmentNamespace(Packet)
+
+PacketMappedFile::PacketMappedFile()
+{
+	// Set the initial data
+	// ...
+}
+
+PacketMappedFile::~PacketMappedFile()
+{
+	Close();
+}
+
+bool PacketMappedFile::Open(const std::string& _filePath)
+{
+	// Close any previous file
+	Close();
+
+#ifdef _WIN32
+
+	// Open the file
+	HANDLE fileHandle = CreateFileA(_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	// Get the file size
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	m_FileHandle = fileHandle;
+	m_Size = uint64_t(fileSize.QuadPart);
+	m_IsOpen = true;
+
+	// Empty files can't be mapped, they are still valid files
+	if (m_Size == 0)
+	{
+		return true;
+	}
+
+	// Create the file mapping and map the whole file
+	m_MappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_MappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (m_Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+#else
+
+	// Open the file
+	int fileDescriptor = open(_filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	// Get the file size
+	struct stat fileStatus = {};
+	if (fstat(fileDescriptor, &fileStatus) != 0)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	m_FileDescriptor = fileDescriptor;
+	m_Size = uint64_t(fileStatus.st_size);
+	m_IsOpen = true;
+
+	// Empty files can't be mapped, they are still valid files
+	if (m_Size == 0)
+	{
+		return true;
+	}
+
+	// Map the whole file
+	void* mappedData = mmap(nullptr, size_t(m_Size), PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	if (mappedData == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	m_Data = static_cast<const uint8_t*>(mappedData);
+
+#endif
+
+	return true;
+}
+
+void PacketMappedFile::Close()
+{
+#ifdef _WIN32
+
+	if (m_Data != nullptr)
+	{
+		UnmapViewOfFile(m_Data);
+	}
+
+	if (m_MappingHandle != nullptr)
+	{
+		CloseHandle(m_MappingHandle);
+		m_MappingHandle = nullptr;
+	}
+
+	if (m_FileHandle != nullptr)
+	{
+		CloseHandle(m_FileHandle);
+		m_FileHandle = nullptr;
+	}
+
+#else
+
+	if (m_Data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(m_Data), size_t(m_Size));
+	}
+
+	if (m_FileDescriptor >= 0)
+	{
+		close(m_FileDescriptor);
+		m_FileDescriptor = -1;
+	}
+
+#endif
+
+	m_Data = nullptr;
+	m_Size = 0;
+	m_IsOpen = false;
+}
+
+bool PacketMappedFile::Read(uint8_t* _dataOut, uint64_t _offset, uint64_t _size) const
+{
+	// Get the mapped range, this will validate the bounds
+	const uint8_t* data = GetData(_offset, _size);
+	if (data == nullptr)
+	{
+		return _size == 0 && _offset <= m_Size && m_IsOpen;
+	}
+
+	// Copy the data
+	memcpy(_dataOut, data, size_t(_size));
+
+	return true;
+}
+
+const uint8_t* PacketMappedFile::GetData(uint64_t _offset, uint64_t _size) const
+{
+	// Check if the range is inside the mapped memory (written this way to avoid overflows)
+	if (m_Data == nullptr || _offset > m_Size || _size > m_Size - _offset)
+	{
+		return nullptr;
+	}
+
+	return m_Data + _offset;
+}
+
+void PacketMappedFile::Prefetch(uint64_t _offset, uint64_t _size) const
+{
+	if (m_Data == nullptr || _offset >= m_Size)
+	{
+		return;
+	}
+	_size = std::min(_size, m_Size - _offset);
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t*>(m_Data + _offset), size_t(_size) };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// The advised range must begin on a page boundary
+	uint64_t pageOffset = _offset % uint64_t(sysconf(_SC_PAGESIZE));
+	madvise(const_cast<uint8_t*>(m_Data + _offset - pageOffset), size_t(_size + pageOffset), MADV_WILLNEED);
+#endif
+}
+
+void PacketMappedFile::Evict(uint64_t _offset, uint64_t _size) const
+{
+	if (m_Data == nullptr || _offset >= m_Size)
+	{
+		return;
+	}
+	_size = std::min(_size, m_Size - _offset);
+
+#ifdef _WIN32
+	// Windows trims the pages of a mapped file on its own, there is no way to drop them from the cache
+#else
+	// Only the pages that are entirely inside the range are released, the ones at the edges can hold other data
+	uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+	uint64_t begin = (_offset + pageSize - 1) / pageSize * pageSize;
+	uint64_t end = (_offset + _size == m_Size) ? m_Size : (_offset + _size) / pageSize * pageSize;
+	if (begin >= end)
+	{
+		return;
+	}
+
+	madvise(const_cast<uint8_t*>(m_Data + begin), size_t(end - begin), MADV_DONTNEED);
+#if defined(POSIX_FADV_DONTNEED)
+	posix_fadvise(m_FileDescriptor, off_t(begin), off_t(end - begin), POSIX_FADV_DONTNEED);
+#endif
+#endif
+}
+
+uint64_t PacketMappedFile::GetSize() const
+{
+	return m_Size;
+}
+
+bool PacketMappedFile::IsOpen() const
+{
+	return m_IsOpen;
+}
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: PacketMappedFile.h
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//////////////
+// INCLUDES //
+//////////////
+#include "PacketConfig.h"
+
+#include <string>
+
+///////////////
+// NAMESPACE //
+///////////////
+
+/////////////
+// DEFINES //
+/////////////
+
+////////////
+// GLOBAL //
+////////////
+
+///////////////
+// NAMESPACE //
+///////////////
+
+// Packet data explorer
+PacketDevelopmentNamespaceBegin(Packet)
+
+////////////////
+// FORWARDING //
+////////////////
+
+////////////////
+// STRUCTURES //
+////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: PacketMappedFile
+////////////////////////////////////////////////////////////////////////////////
+class PacketMappedFile
+{
+//////////////////
+// CONSTRUCTORS //
+public: //////////
+
+	// Constructor / destructor
+	PacketMappedFile();
+	~PacketMappedFile();
+
+	// This object owns the mapping, it can't be copied
+	PacketMappedFile(const PacketMappedFile&) = delete;
+	PacketMappedFile& operator=(const PacketMappedFile&) = delete;
+
+//////////////////
+// MAIN METHODS //
+public: //////////
+
+	// Open the given file and map its whole content as read only memory
+	bool Open(const std::string& _filePath);
+
+	// Unmap and close the current file (if any)
+	void Close();
+
+	// Copy a range of the mapped file into the output buffer, this method will fail if the range is out of bounds, it
+	// doesn't change any internal state so it can be called from any number of threads at the same time
+	bool Read(uint8_t* _dataOut, uint64_t _offset, uint64_t _size) const;
+
+	// Return a pointer to the mapped memory for the given range or nullptr if the range is out of bounds
+	const uint8_t* GetData(uint64_t _offset, uint64_t _size) const;
+
+	// Ask the system to start reading the given range into memory in the background (it's clamped to the file bounds)
+	void Prefetch(uint64_t _offset, uint64_t _size) const;
+
+	// Tell the system the given range won't be used soon, its pages are released from this mapping and dropped from the
+	// page cache when possible (the mapped memory stays valid, it's read again when accessed)
+	void Evict(uint64_t _offset, uint64_t _size) const;
+
+	// Return the mapped file size
+	uint64_t GetSize() const;
+
+	// Return if this file is currently open
+	bool IsOpen() const;
+
+///////////////
+// VARIABLES //
+private: //////
+
+	// The mapped memory and its size
+	const uint8_t* m_Data = nullptr;
+	uint64_t m_Size = 0;
+
+	// If we have an open file
+	bool m_IsOpen = false;
+
+	// The native file handles
+#ifdef _WIN32
+	void* m_FileHandle = nullptr;
+	void* m_MappingHandle = nullptr;
+#else
+	int m_FileDescriptor = -1;
+#endif
+};
+
+// Packet data explorer
+PacketDevelopmentNamespaceEnd(Packet)
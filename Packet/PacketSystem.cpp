@@ -33,10 +33,14 @@ PacketSystem::~PacketSystem()
     m_Logger.reset();
 }
 
-bool PacketSystem::Initialize(OperationMode _operationMode, std::string _packetManifestDirectory, std::unique_ptr<PacketLogger>&& _logger)
+bool PacketSystem::Initialize(OperationMode _operationMode, 
+                              std::string _packetManifestDirectory, 
+                              std::unique_ptr<PacketLogger>&& _logger, 
+                              PacketSystemSettings _settings)
 {
 	// Set the data
 	m_PacketFolderPath = _packetManifestDirectory;
+	m_Settings = _settings;
 	m_Logger = std::move(_logger);
 	m_OperationMode = std::move(_operationMode);
 
@@ -48,13 +52,26 @@ bool PacketSystem::Initialize(OperationMode _operationMode, std::string _packetM
 	if (_operationMode == OperationMode::Edit)
 	{
 		// Create the file loader
-		m_FileLoader = std::make_unique<PacketEditModeFileLoader>(_packetManifestDirectory, m_Logger.get());
+		m_FileLoader = std::make_unique<PacketEditModeFileLoader>(_packetManifestDirectory, 
+		                                                          m_Logger.get(), 
+		                                                          m_Settings.asyncReadThreads, 
+		                                                          m_Settings.editDirectoryIndex);
 	}
 	// Condensed
 	else
 	{
 		// Create the file loader
-		m_FileLoader = std::make_unique<PacketCondensedModeFileLoader>(_packetManifestDirectory, m_Logger.get());
+		m_FileLoader = std::make_unique<PacketCondensedModeFileLoader>(_packetManifestDirectory, 
+		                                                               m_Logger.get(), 
+		                                                               m_Settings.condensedReaderMode, 
+		                                                               m_Settings.solidBlockCacheSize, 
+		                                                               m_Settings.condensedVerifyMode, 
+		                                                               m_Settings.condensedOverlayDirectories, 
+		                                                               m_Settings.asyncReadMode, 
+		                                                               m_Settings.asyncReadQueueDepth, 
+		                                                               m_Settings.asyncReadThreads, 
+		                                                               m_Settings.readCoalesceGap, 
+		                                                               m_Settings.directReadMinimumSize);
 	}
 
 	// Create the resource storage
@@ -69,7 +86,9 @@ bool PacketSystem::Initialize(OperationMode _operationMode, std::string _packetM
 		m_FileLoader.get(), 
 		m_ReferenceManager.get(), 
 		m_ResourceWatcher.get(), 
-		m_Logger.get());
+		m_Logger.get(), 
+		m_Settings.resourceThreadIdleTimeout, 
+		m_Settings.resourceLoadThreads);
 
 	return true;
 }
@@ -90,7 +109,37 @@ bool PacketSystem::FileExist(Hash _fileHash) const
 	return m_FileLoader->FileExist(_fileHash);
 }
 
-bool PacketSystem::ConstructPacket()
+bool PacketSystem::ConstructPacket(PacketCondenseSettings _settings)
 {
-	return m_FileLoader->ConstructPacket();
+	return m_FileLoader->ConstructPacket(_settings);
+}
+
+PacketFileLoaderStats PacketSystem::GetFileLoaderStats() const
+{
+	return m_FileLoader->GetStats();
+}
+
+PacketResourceManagerStats PacketSystem::GetResourceManagerStats() const
+{
+	return m_ResourceManager->GetStats();
+}
+
+void PacketSystem::Prefetch(const std::vector<Hash>& _fileHashes) const
+{
+	m_FileLoader->Prefetch(_fileHashes);
+}
+
+void PacketSystem::Evict(const std::vector<Hash>& _fileHashes) const
+{
+	m_FileLoader->Evict(_fileHashes);
+}
+
+bool PacketSystem::BeginAccessTrace(std::string _traceFilePath)
+{
+	return m_ResourceManager->BeginAccessTrace(_traceFilePath);
+}
+
+void PacketSystem::EndAccessTrace()
+{
+	m_ResourceManager->EndAccessTrace();
 }
\ No newline at end of file
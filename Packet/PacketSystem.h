@@ -68,10 +68,33 @@ public: //////////
 public: //////////
 
 	// Initialize this object
-	bool Initialize(OperationMode _operationMode, std::string _packetManifestDirectory, std::unique_ptr<PacketLogger>&& _logger = std::make_unique<PacketLogger>());
+	bool Initialize(OperationMode _operationMode, 
+                    std::string _packetManifestDirectory, 
+                    std::unique_ptr<PacketLogger>&& _logger = std::make_unique<PacketLogger>(), 
+                    PacketSystemSettings _settings = PacketSystemSettings());
 
-	// Pack all files
-	bool ConstructPacket();
+	// Pack all files, the settings control how the condensed files are created
+	bool ConstructPacket(PacketCondenseSettings _settings = PacketCondenseSettings());
+
+	// Return the file loader statistics (reads and checksum verifications)
+	PacketFileLoaderStats GetFileLoaderStats() const;
+
+	// Return the resource manager statistics (cancelled requests)
+	PacketResourceManagerStats GetResourceManagerStats() const;
+
+	// Start reading the data of the given files into memory in the background without constructing anything, used when
+	// it's known they will be requested soon (only on condensed mode)
+	void Prefetch(const std::vector<Hash>& _fileHashes) const;
+
+	// Drop the data of the given files from memory when it's known they won't be requested soon (only on condensed mode)
+	void Evict(const std::vector<Hash>& _fileHashes) const;
+
+	// Begin recording the path of each resource file loaded (in load order) into the given trace file, the trace can
+	// be used when constructing the packet (see PacketCondenseSettings::accessTracePath)
+	bool BeginAccessTrace(std::string _traceFilePath);
+
+	// Finish recording the access trace
+	void EndAccessTrace();
 
 public:
 
@@ -126,6 +149,14 @@ public:
                                                   _resourceBuildInfo);
 	}
 
+    // Raise the priority of a request that is still waiting to be processed (the initial priority is given by the build
+    // info), returns false if the given reference has no pending request
+    template <typename ResourceClass>
+    bool RaiseResourcePriority(const PacketResourceReference<ResourceClass>& _resourceReference, uint32_t _priority)
+    {
+        return m_ResourceManager->RaiseResourcePriority(_resourceReference, _priority);
+    }
+
     // This method will wait until the given resource is ready to be used
     // Optionally you can pass a timeout parameter in milliseconds
     template <typename ResourceClass>
@@ -156,6 +187,9 @@ private: //////
 	// The packet folder path
 	std::string m_PacketFolderPath;
 
+	// The settings used to initialize this system
+	PacketSystemSettings m_Settings;
+
 private:
 
 	// Our packet file loader
@@ -8,6 +8,7 @@
 
 #include <cassert>
 #include <fstream>
+#include <new>
 
 // Using namespace Peasant
 PacketUsingDevelopmentNamespace(Packet)
@@ -53,6 +54,7 @@ PacketResourceData::PacketResourceData(PacketResourceData& _other)
 	m_Data = _other.m_Data;
 	m_Size = _other.m_Size;
     m_RuntimeData = _other.m_RuntimeData;
+    m_DataView = _other.m_DataView;
 }
 
 PacketResourceData::~PacketResourceData()
@@ -79,6 +81,7 @@ PacketResourceData& PacketResourceData::operator=(PacketResourceData&& _other)
         memcpy(m_Data, _other.m_Data, _other.m_Size);
 		m_Size = _other.m_Size;
         m_RuntimeData = _other.m_RuntimeData;
+        m_DataView = std::move(_other.m_DataView);
 	}
 
 	return *this;
@@ -90,8 +93,11 @@ PacketResourceData::PacketResourceData(PacketResourceData&& _other)
     m_Data = _other.m_Data;
     m_Size = _other.m_Size;
     m_RuntimeData = std::move(_other.m_RuntimeData);
+    m_DataView = std::move(_other.m_DataView);
+    m_Alignment = _other.m_Alignment;
     _other.m_Data = nullptr;
     _other.m_Size = 0;
+    _other.m_Alignment = 0;
 }
 
 const uint8_t* PacketResourceData::GetData() const
@@ -101,6 +107,11 @@ const uint8_t* PacketResourceData::GetData() const
         return static_cast<const uint8_t*>(m_RuntimeData.data());
     }
 
+    if (m_DataView.data != nullptr)
+    {
+        return m_DataView.data;
+    }
+
 	return m_Data;
 }
 
@@ -116,9 +127,29 @@ uint64_t PacketResourceData::GetSize() const
         return m_RuntimeData.size();
     }
 
+    if (m_DataView.data != nullptr)
+    {
+        return m_DataView.size;
+    }
+
 	return m_Size;
 }
 
+bool PacketResourceData::IsDataView() const
+{
+    return m_DataView.data != nullptr;
+}
+
+void PacketResourceData::SetDataView(PacketFileDataView _dataView)
+{
+    m_DataView = std::move(_dataView);
+}
+
+void PacketResourceData::ReleaseDataView()
+{
+    m_DataView = PacketFileDataView();
+}
+
 bool PacketResourceData::AllocateMemory(uint64_t _total)
 {
 	m_Data = new uint8_t[unsigned int(_total)];
@@ -128,17 +159,40 @@ bool PacketResourceData::AllocateMemory(uint64_t _total)
 	}
 
 	m_Size = _total;
+    m_Alignment = 0;
 
 	return true;
 }
 
+bool PacketResourceData::AllocateAlignedMemory(uint64_t _total, uint32_t _alignment)
+{
+    m_Data = new (std::align_val_t(_alignment), std::nothrow) uint8_t[size_t(_total)];
+    if (m_Data == nullptr)
+    {
+        return false;
+    }
+
+    m_Size = _total;
+    m_Alignment = _alignment;
+
+    return true;
+}
+
 void PacketResourceData::DeallocateMemory()
 {
     if (m_Data != nullptr)
     {
-        delete[] m_Data;
+        if (m_Alignment != 0)
+        {
+            ::operator delete[](m_Data, std::align_val_t(m_Alignment));
+        }
+        else
+        {
+            delete[] m_Data;
+        }
         m_Data = nullptr;
         m_Size = 0;
+        m_Alignment = 0;
     }
 }
 
@@ -166,15 +220,15 @@ bool PacketResource::BeginLoad(bool _isPersistent)
 	m_IsPermanentResource = _isPersistent;
 
 	// Set loaded to true
-    m_WasLoaded = true;
+    m_WasLoaded.store(true, std::memory_order_release);
 
 	return true;
 }
 
 bool PacketResource::BeginDelete()
 {
-	// Call the OnDelete() method
-	if (!OnDelete(m_Data))
+	// Call the OnDelete() method (resources that failed to load were never constructed, there is nothing to delete)
+	if (m_WasConstructed && !OnDelete(m_Data))
 	{
 		return false;
 	}
@@ -187,29 +241,36 @@ bool PacketResource::BeginDelete()
 	return true;
 }
 
-void PacketResource::BeginConstruct()
+bool PacketResource::BeginConstruct()
 {
     // If the data size is zero and this is not a runtime resource we should set that the construction
     // failed directly instead trying to construct it
     if (m_Data.GetSize() == 0 && !m_IsRuntimeResource)
     {
-        m_ConstructFailed = true;
-    }
-    else
-    {
-        bool result = OnConstruct(m_Data, m_BuildInfo.buildFlags, m_BuildInfo.flags);
-        m_ConstructFailed = !result;
+        m_ConstructFailed.store(true, std::memory_order_release);
 
-        m_WasConstructed = true;
+        return false;
     }
+
+    // A failed resource can be deleted as soon as it's set as failed, so that must be the last change
+    bool result = OnConstruct(m_Data, m_BuildInfo.buildFlags, m_BuildInfo.flags);
+    m_WasConstructed.store(true, std::memory_order_release);
+    m_ConstructFailed.store(!result, std::memory_order_release);
+
+    return result;
 }
 
 void PacketResource::BeginExternalConstruct(void* _data)
 {
     bool result = OnExternalConstruct(m_Data, m_BuildInfo.buildFlags, m_BuildInfo.flags, _data);
-    m_ConstructFailed = m_ConstructFailed && !result;
+    m_ConstructFailed.store(m_ConstructFailed.load(std::memory_order_relaxed) && !result, std::memory_order_release);
+
+    m_WasExternallyConstructed.store(true, std::memory_order_release);
+}
 
-    m_WasExternallyConstructed = true;
+void PacketResource::FailLoad()
+{
+    m_ConstructFailed.store(true, std::memory_order_release);
 }
 
 void PacketResource::BeginModifications()
@@ -227,12 +288,12 @@ void PacketResource::BeginModifications()
 
 bool PacketResource::IsValid() const
 {
-	return m_WasLoaded
-        && m_WasConstructed
-        && m_WasExternallyConstructed
+	return m_WasLoaded.load(std::memory_order_acquire)
+        && m_WasConstructed.load(std::memory_order_acquire)
+        && m_WasExternallyConstructed.load(std::memory_order_acquire)
         && !m_IsPendingModifications
         && !m_IsPendingDeletion
-        && !m_ConstructFailed;
+        && !m_ConstructFailed.load(std::memory_order_acquire);
 }
 
 bool PacketResource::IsPendingDeletion() const
@@ -337,7 +398,7 @@ bool PacketResource::IgnorePhysicalDataChanges() const
 
 bool PacketResource::ConstructionFailed() const
 {
-    return m_ConstructFailed;
+    return m_ConstructFailed.load(std::memory_order_acquire);
 }
 
 void PacketResource::IncrementNumberReferences()
@@ -348,13 +409,16 @@ void PacketResource::IncrementNumberReferences()
 void PacketResource::DecrementNumberReferences(bool _releaseEnable)
 {
     bool releaseResource = false;
+    bool lastReference = false;
+    PacketResourceManager* resourceManager = m_ResourceManagerPtr;
 
     {
         std::lock_guard<std::mutex> l(m_ResourceMutex);
 
         // Do not release the resource if it is being replaced by another, if that's the case this resource
         // is already in the deletion queue for the resource manager object
-        releaseResource = (m_TotalReferences == 1) && m_ReplacingResource == nullptr && _releaseEnable;
+        lastReference = m_TotalReferences == 1;
+        releaseResource = lastReference && m_ReplacingResource == nullptr && _releaseEnable;
 
         m_TotalReferences--;
     }
@@ -362,7 +426,13 @@ void PacketResource::DecrementNumberReferences(bool _releaseEnable)
     if (releaseResource)
     {
         // Use the resource manager to release this instance
-        m_ResourceManagerPtr->RegisterResourceForDeletion(this);
+        resourceManager->RegisterResourceForDeletion(this);
+    }
+    else if (lastReference && resourceManager != nullptr)
+    {
+        // The replaced resources and the ones pending modifications wait for their references to be released, this
+        // resource may be deleted from now on so only the manager is used
+        resourceManager->WakeAsynchronousThread();
     }
 }
 
@@ -371,6 +441,26 @@ uint32_t PacketResource::GetDataSize() const
 	return uint32_t(m_Data.GetSize());
 }
 
+uint64_t PacketResource::GetFileSize() const
+{
+    if (m_FileLoaderPtr == nullptr)
+    {
+        return 0;
+    }
+
+    return m_FileLoaderPtr->GetFileSize(m_Hash);
+}
+
+bool PacketResource::ReadFileRange(uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const
+{
+    if (m_FileLoaderPtr == nullptr)
+    {
+        return false;
+    }
+
+    return m_FileLoaderPtr->ReadRange(m_Hash, _offset, _size, _dataOut);
+}
+
 uint32_t PacketResource::GetTotalNumberReferences() const
 {
 	return m_TotalReferences;
@@ -575,7 +665,9 @@ void PacketResourceExternalConstructor::ConstructResource(void* _data)
 {
     if (m_Resource != nullptr)
     {
+        // The resources pending deletion or replacement may be waiting for this one to be valid
         m_Resource->BeginExternalConstruct(_data);
+        m_ResourceManager->WakeAsynchronousThread();
     }
 
     // The resource will be automatically ready, we don't need to do any other processing
@@ -14,6 +14,7 @@
 #include <atomic>
 #include <mutex>
 #include <optional>
+#include <algorithm>
 
 ///////////////
 // NAMESPACE //
@@ -59,11 +60,13 @@ template <typename ResourceClass>
 class PacketResourceReference;
 
 // The structure that will be used to store the resource data, it works like a vector of uint8_t and is allocation 
-// and deallocation must be managed by a factory class
+// and deallocation must be managed by a factory class, optionally it can be a read-only view into the condensed
+// file memory (if the factory supports it), in this case no allocation or deallocation is made
 struct PacketResourceData
 {
     // Friend classes
     friend PacketResourceLoader;
+    friend PacketResourceDeleter;
 
 	// Our constructors
 	PacketResourceData();
@@ -89,9 +92,16 @@ struct PacketResourceData
 	// Return the size
 	uint64_t GetSize() const;
 
+    // Return if this data is a read-only view into memory owned by the file loader
+    bool IsDataView() const;
+
 	// Allocates memory for this object
 	virtual bool AllocateMemory(uint64_t _total);
 
+    // Allocates memory for this object aligned to the given alignment (a power of two), the file loader can read into 
+    // aligned memory without an intermediate copy (see PacketResourceFactory::AllocateAlignedData())
+    bool AllocateAlignedMemory(uint64_t _total, uint32_t _alignment);
+
 	// Deallocate this object memory
 	virtual void DeallocateMemory();
 
@@ -100,6 +110,13 @@ protected:
     // Return a pointer to this memory enabling it to be written
     uint8_t* GetwritableData() const;
 
+    // Set this data to be a view into the given file data, the view owner will be kept alive until the view
+    // is released
+    void SetDataView(PacketFileDataView _dataView);
+
+    // Release the current data view (if any)
+    void ReleaseDataView();
+
 protected:
 
 	uint8_t* m_Data;
@@ -108,6 +125,12 @@ protected:
 private:
 
     std::vector<uint8_t> m_RuntimeData;
+
+    // The alignment used when the memory was allocated by AllocateAlignedMemory() (0 otherwise)
+    uint32_t m_Alignment = 0;
+
+    // The data view, if set
+    PacketFileDataView m_DataView;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -168,6 +191,14 @@ public: //////////
 	// Return the data size
 	uint32_t GetDataSize() const;
 
+    // Return the size of this resource file, it can be bigger than the data size when the factory only reads the
+    // beginning of the file (see PacketResourceFactory::GetInitialReadSize())
+    uint64_t GetFileSize() const;
+
+    // Read a range of this resource file into the given buffer, resources that only load part of their file can use
+    // this from OnConstruct() to fetch the other parts they need
+    bool ReadFileRange(uint64_t _offset, uint64_t _size, uint8_t* _dataOut) const;
+
 	// Return the total number of references
 	uint32_t GetTotalNumberReferences() const;
 
@@ -255,10 +286,13 @@ protected: // INTERNAL //
 	// Begin load, deletion, construct and external construct methods
 	bool BeginLoad(bool _isPersistent);
 	bool BeginDelete();
-    void BeginConstruct();
+    bool BeginConstruct();
     void BeginExternalConstruct(void* _data);
     void BeginModifications();
 
+    // Set that this resource failed to load (its file data couldn't be read), it won't be constructed
+    void FailLoad();
+
 	// Set the hash
 	void SetHash(Hash _hash);
 
@@ -300,16 +334,17 @@ protected: // INTERNAL //
 // VARIABLES //
 private: //////
 
-	// Status
-	bool m_IsPermanentResource       = false;
+	// Status, the load and construct status is set by the load threads while any thread can check it (the flags are
+	// stored with release ordering after each phase completes, so a valid resource is seen fully constructed)
 	bool m_IgnorePhysicalDataChanges = false;
-	bool m_IsPendingDeletion         = false;
-    bool m_WasLoaded                 = false;
-    bool m_WasConstructed            = false;
-    bool m_WasExternallyConstructed  = false;
     bool m_IsRuntimeResource         = false;
-    bool m_IsPendingModifications    = false;
-    bool m_ConstructFailed           = false;
+	std::atomic<bool> m_IsPermanentResource      = false;
+	std::atomic<bool> m_IsPendingDeletion        = false;
+    std::atomic<bool> m_WasLoaded                = false;
+    std::atomic<bool> m_WasConstructed           = false;
+    std::atomic<bool> m_WasExternallyConstructed = false;
+    std::atomic<bool> m_IsPendingModifications   = false;
+    std::atomic<bool> m_ConstructFailed          = false;
 
     // This is the index of the current construct phase
     uint32_t m_CurrentConstructPhaseIndex = 0;
@@ -362,11 +397,44 @@ public:
         m_ResourceReferenceVariable = _variablePtr;
     }
 
+    // Return if the given resource variable will be updated when the resource is ready, proxies are reused once their
+    // request is processed so this is the only way to tell if a request is still pending (the lock must be held)
+    bool IsLinkedTo(PacketResource** _variablePtr) const
+    {
+        return m_ResourceReferenceVariable != nullptr && m_ResourceReferenceVariable == _variablePtr;
+    }
+
+    // Return if the reference that made the request was released (or reset) before it was processed, there is no 
+    // need to load anything for it (the lock must be held)
+    bool IsAbandoned() const
+    {
+        return m_ResourceReferenceVariable == nullptr;
+    }
+
+    // Set the priority of the request, raising it only allows increasing it (the lock must be held)
+    void SetPriority(uint32_t _priority)
+    {
+        m_Priority = _priority;
+    }
+    void RaisePriority(uint32_t _priority)
+    {
+        m_Priority = std::max(m_Priority.load(), _priority);
+    }
+
+    // Return the priority of the request
+    uint32_t GetPriority() const
+    {
+        return m_Priority;
+    }
+
 private:
 
     // The resource variable that must be updated when the resource is ready
     PacketResource** m_ResourceReferenceVariable = nullptr;
 
+    // The request priority (read by the resource manager while scheduling the requests)
+    std::atomic<uint32_t> m_Priority = 0;
+
     // The mutex that will prevent concurrent access between the referenced reference and the resource
     // registration
     mutable std::mutex m_Mutex;
@@ -386,9 +454,13 @@ protected:
     // Register a creation proxy, only callable from the resource manager
     void RegisterCreationProxy(PacketResourceCreationProxy* _creationProxy)
     {
-        // Set our proxy variable
+        // Release whatever this reference was holding or waiting for
+        Reset();
+
+        // Set our proxy variable and make it target our resource variable
         m_CreationProxy = _creationProxy;
-        UpdateCreationProxy(&m_ResourceObject);
+        auto proxyLock = m_CreationProxy->AcquireLock();
+        m_CreationProxy->UpdateLinkedResourceVariable(&m_ResourceObject);
     }
 
 public:
@@ -482,6 +554,20 @@ public:
     // The get method
     ResourceClass* Get() const
     {
+        // While the request is pending our resource variable is set by the resource manager thread, check if it was
+        // already set under the proxy lock so the linked resource is seen as it was when it was linked
+        if (m_CreationProxy != nullptr)
+        {
+            auto proxyLock = m_CreationProxy->AcquireLock();
+            if (m_CreationProxy->IsLinkedTo(&m_ResourceObject))
+            {
+                return nullptr;
+            }
+
+            // The proxy is reused once it sets our resource, it must not be touched anymore
+            m_CreationProxy = nullptr;
+        }
+
         // If we are on edit mode, check if this resource should be replaced
         if (m_ResourceObject!= nullptr && m_ResourceObject->GetOperationMode() == OperationMode::Edit)
         {
@@ -536,13 +622,11 @@ private:
 
     // This method will update our creation proxy, if necessary, to point to
     // a new resource object variable, it can also be used to unlink from it 
-    // specifying a nullptr
+    // specifying a nullptr (the request is then cancelled by the resource manager)
     // A bool is returned indicating if the creation proxy was updated or not,
     // this can be used to determine if the current resource is still pending
     // to be set by the proxy or if it was already set
-    // Optionally pass a second resource variable that will be verified (use on
-    // move operations)
-    bool UpdateCreationProxy(PacketResource** _resourceVariable, PacketResource** _movingResourceVariable = nullptr)
+    bool UpdateCreationProxy(PacketResource** _resourceVariable)
     {
         if (m_CreationProxy)
         {
@@ -550,20 +634,19 @@ private:
             // same time we are releasing this reference
             auto proxyLock = m_CreationProxy->AcquireLock();
 
-            // Check if the proxy already updated our resource
-            if ((_resourceVariable == nullptr || *_resourceVariable == nullptr) && (_movingResourceVariable == nullptr || *_movingResourceVariable == nullptr))
-            {
-                // Unlink the proxy by setting the target resource variable to nullptr
-                m_CreationProxy->UpdateLinkedResourceVariable(_resourceVariable);
-            }
-            else
+            // Check if the proxy already updated our resource, proxies are reused after that so it must
+            // not be touched anymore
+            if (!m_CreationProxy->IsLinkedTo(&m_ResourceObject))
             {
                 m_CreationProxy = nullptr;
 
                 return false;
             }
 
-            if (_resourceVariable = nullptr)
+            // Make the proxy target the new resource variable (or unlink it)
+            m_CreationProxy->UpdateLinkedResourceVariable(_resourceVariable);
+
+            if (_resourceVariable == nullptr)
             {
                 m_CreationProxy = nullptr;
             }
@@ -580,7 +663,7 @@ protected:
     mutable PacketResource* m_ResourceObject = nullptr;
 
     // The creation proxy linked
-    PacketResourceCreationProxy* m_CreationProxy = nullptr;
+    mutable PacketResourceCreationProxy* m_CreationProxy = nullptr;
 };
 
 // The temporary editable resource reference type
@@ -27,8 +27,16 @@ bool PacketResourceDeleter::DeleteObject(std::unique_ptr<PacketResource> _object
     // Verify if this is a runtime object and doesn't needs to have its memory released by the factory
     if (!_object->IsRuntime())
     {
-        // Release the object data using its factory (this is safe because we are using the resource allocator)
-        _factoryPtr->DeallocateData(_object->GetDataRef());
+        // Data views aren't owned by the factory, just release the view (and the file memory it keeps alive)
+        if (_object->GetDataRef().IsDataView())
+        {
+            _object->GetDataRef().ReleaseDataView();
+        }
+        else
+        {
+            // Release the object data using its factory (this is safe because we are using the resource allocator)
+            _factoryPtr->DeallocateData(_object->GetDataRef());
+        }
     }
 
     // Call the release method for the factory asynchronous
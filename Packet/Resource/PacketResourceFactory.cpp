@@ -16,4 +16,19 @@ PacketResourceFactory::PacketResourceFactory()
 
 PacketResourceFactory::~PacketResourceFactory()
 {
+}
+
+bool PacketResourceFactory::AllocateAlignedData(PacketResourceData& _resourceDataRef, uint64_t _total, uint32_t /*_alignment*/)
+{
+	return AllocateData(_resourceDataRef, _total);
+}
+
+bool PacketResourceFactory::SupportsDataView() const
+{
+	return false;
+}
+
+uint64_t PacketResourceFactory::GetInitialReadSize() const
+{
+	return 0;
 }
\ No newline at end of file
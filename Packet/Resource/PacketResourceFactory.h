@@ -73,9 +73,25 @@ public: //////////
 	// Allocates the given amount of data for the resource creation
 	virtual bool AllocateData(PacketResourceData& _resourceDataRef, uint64_t _total) = 0;
 
+	// Allocates the given amount of data for a file read that only goes directly into the buffer when it's aligned to 
+	// the given alignment (big condensed reads that bypass the page cache), factories can use 
+	// PacketResourceData::AllocateAlignedMemory() for it. By default this calls AllocateData() and unaligned buffers are
+	// filled through an extra copy
+	virtual bool AllocateAlignedData(PacketResourceData& _resourceDataRef, uint64_t _total, uint32_t _alignment);
+
 	// Deallocates the given data from the resource
 	virtual void DeallocateData(PacketResourceData& _data) = 0;
 
+	// Return if resources created by this factory can receive a read-only view into the condensed file memory as their 
+	// data, when the file loader supports it no allocation or copy is made, AllocateData() and DeallocateData() won't be 
+	// called for these resources and OnConstruct() must not write into the data
+	virtual bool SupportsDataView() const;
+
+	// Return how many bytes from the beginning of the file are read before OnConstruct() is called, 0 means the whole 
+	// file is read. Resources that only need a header or a slice of a big file can read the rest on demand using
+	// PacketResource::ReadFileRange()
+	virtual uint64_t GetInitialReadSize() const;
+
 ///////////////
 // VARIABLES //
 private: //////
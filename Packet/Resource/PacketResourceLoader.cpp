@@ -9,6 +9,7 @@
 
 #include <cassert>
 #include <chrono>
+#include <algorithm>
 
 // Using namespace Peasant
 PacketUsingDevelopmentNamespace(Packet)
@@ -37,6 +38,33 @@ std::unique_ptr<PacketResource> PacketResourceLoader::LoadObject(PacketResourceF
                                                                  bool _isPermanent, 
                                                                  bool _isRuntimeResource,
                                                                  std::vector<uint8_t> _resourceData) const
+{
+    // Begin loading the object and read its data (if needed) right away
+    PacketReadRequest readRequest;
+    bool requiresRead = false;
+    std::unique_ptr<PacketResource> resource = BeginLoadObject(_resourceFactory, 
+                                                               _hash, 
+                                                               _buildInfo, 
+                                                               _isRuntimeResource, 
+                                                               std::move(_resourceData), 
+                                                               requiresRead, 
+                                                               readRequest);
+
+    bool readSucceeded = !requiresRead || m_FileLoaderPtr->ReadRange(readRequest.hash, readRequest.offset, readRequest.size, readRequest.dataOut);
+
+    // Finish loading and construct it
+    FinishLoadObject(resource.get(), _isPermanent, readSucceeded);
+
+    return resource;
+}
+
+std::unique_ptr<PacketResource> PacketResourceLoader::BeginLoadObject(PacketResourceFactory* _resourceFactory,
+                                                                      Hash _hash, 
+                                                                      PacketResourceBuildInfo _buildInfo,
+                                                                      bool _isRuntimeResource,
+                                                                      std::vector<uint8_t> _resourceData, 
+                                                                      bool& _requiresReadOut, 
+                                                                      PacketReadRequest& _readRequestOut) const
 {
     // Allocate the object using the factory
     std::unique_ptr<PacketResource> resource = _resourceFactory->RequestObject();
@@ -70,47 +98,90 @@ std::unique_ptr<PacketResource> PacketResourceLoader::LoadObject(PacketResourceF
         }
     }
 
+    // Get a reference to the object data vector directly
+    auto& dataVector = resource->GetDataRef();
+    _requiresReadOut = false;
+
     // Check if this is a runtime resource and the data shouldn't come from a file
     if (_isRuntimeResource)
     {
-        // Get a reference to the object data vector directly
-        auto& dataVector = resource->GetDataRef();
         dataVector = PacketResourceData(std::move(_resourceData));
 
-        // Call the BeginLoad() method for this object
-        bool result = resource->BeginLoad(_isPermanent);
-        assert(result);
+        return resource;
     }
-    else
+
+    // Check if the factory accepts a view into the file data and if the file loader can provide one, if
+    // that's the case the data will be used in place (no allocation or copy)
+    PacketFileDataView dataView;
+    if (resource->GetFactoryPtr()->SupportsDataView() && m_FileLoaderPtr->GetFileDataView(dataView, _hash))
     {
-        // Get the resource size
-        auto resourceSize = m_FileLoaderPtr->GetFileSize(_hash);
+        dataVector.SetDataView(std::move(dataView));
 
-        // Get a reference to the object data vector directly
-        auto& dataVector = resource->GetDataRef();
+        return resource;
+    }
 
-        // Using the object factory, allocate the necessary data
-        bool result = resource->GetFactoryPtr()->AllocateData(dataVector, resourceSize);
-        assert(result);
+    // Check if the factory only wants the beginning of the file, the resource will read the rest on demand
+    uint64_t readSize = m_FileLoaderPtr->GetFileSize(_hash);
+    uint64_t initialReadSize = resource->GetFactoryPtr()->GetInitialReadSize();
+    if (initialReadSize != 0)
+    {
+        readSize = std::min(initialReadSize, readSize);
+    }
 
-        // Read the file data
-        result = m_FileLoaderPtr->GetFileData(dataVector.GetwritableData(), resourceSize, _hash);
-        assert(result);
+    // Allocate the data using the object factory, the file data will be read into it (when the read needs an aligned
+    // buffer to avoid an extra copy the factory is asked for one)
+    uint32_t readAlignment = m_FileLoaderPtr->GetReadAlignment(_hash, 0, readSize);
+    bool result = readAlignment != 0 
+        ? resource->GetFactoryPtr()->AllocateAlignedData(dataVector, readSize, readAlignment) 
+        : resource->GetFactoryPtr()->AllocateData(dataVector, readSize);
+    assert(result);
+    if (result)
+    {
+        _readRequestOut.hash = _hash;
+        _readRequestOut.offset = 0;
+        _readRequestOut.size = readSize;
+        _readRequestOut.dataOut = dataVector.GetwritableData();
+        _requiresReadOut = true;
+    }
 
-        // Call the BeginLoad() method for this object
-        result = resource->BeginLoad(_isPermanent);
-        assert(result);
+    return resource;
+}
+
+bool PacketResourceLoader::FinishLoadObject(PacketResource* _resource, bool _isPermanent, bool _readSucceeded) const
+{
+    // Check if the file data was read
+    if (!_readSucceeded)
+    {
+        m_LoggerPtr->LogError(std::string("Error reading the resource file: \"")
+                              .append(_resource->GetHash().GetPath().String())
+                              .append("\"!")
+                              .c_str());
+
+        // The resource can't be constructed without its data, set that it failed so it can be released
+        _resource->FailLoad();
+
+        return false;
     }
 
+    // Check this before constructing, the resource can't be touched once its construction fails
+    bool requiresExternalConstructPhase = _resource->RequiresExternalConstructPhase();
+
+    // Call the BeginLoad() method for this object
+    bool result = _resource->BeginLoad(_isPermanent);
+    assert(result);
+
     // Begin the construction for this resource
-    resource->BeginConstruct();
+    if (!_resource->BeginConstruct())
+    {
+        return false;
+    }
 
     // If this resource doesn't need external construct, call it here to set the internal flags, else
     // the manager will make all necessary adjustments to externally synchronize it
-    if (!resource->RequiresExternalConstructPhase() && !resource->ConstructionFailed())
+    if (!requiresExternalConstructPhase)
     {
-        resource->BeginExternalConstruct(nullptr);
+        _resource->BeginExternalConstruct(nullptr);
     }
 
-    return resource;
-}
\ No newline at end of file
+    return true;
+}
@@ -65,7 +65,7 @@ public: //////////
 // MAIN METHODS //
 public: //////////
 
-	// Load a new object
+	// Load a new object, reading its data synchronously
     std::unique_ptr<PacketResource> LoadObject(PacketResourceFactory* _resourceFactory,
                                                Hash _hash, 
                                                PacketResourceBuildInfo _buildInfo,
@@ -73,6 +73,20 @@ public: //////////
                                                bool _isRuntimeResource, 
                                                std::vector<uint8_t> _resourceData) const;
 
+    // Begin loading a new object, when its data must be read from a file the data is allocated and the read request is
+    // returned instead of being performed, FinishLoadObject() must be called once the read completes
+    std::unique_ptr<PacketResource> BeginLoadObject(PacketResourceFactory* _resourceFactory,
+                                                    Hash _hash, 
+                                                    PacketResourceBuildInfo _buildInfo,
+                                                    bool _isRuntimeResource, 
+                                                    std::vector<uint8_t> _resourceData, 
+                                                    bool& _requiresReadOut, 
+                                                    PacketReadRequest& _readRequestOut) const;
+
+    // Finish loading an object and construct it, returns if it was constructed. Once it's valid or failed the object can
+    // be deleted at any time, it must not be used after this returns
+    bool FinishLoadObject(PacketResource* _resource, bool _isPermanent, bool _readSucceeded) const;
+
 ///////////////
 // VARIABLES //
 private: //////
@@ -6,6 +6,8 @@
 #include "PacketResourceWatcher.h"
 
 #include <cassert>
+#include <algorithm>
+#include <climits>
 
 // Using namespace Peasant
 PacketUsingDevelopmentNamespace(Packet)
@@ -15,7 +17,10 @@ PacketResourceManager::PacketResourceManager(OperationMode _operationMode,
                                              PacketFileLoader* _fileLoaderPtr,
                                              PacketReferenceManager* _referenceManagerPtr,
                                              PacketResourceWatcher* _resourceWatcherPtr,
-                                             PacketLogger* _loggerPtr) :
+                                             PacketLogger* _loggerPtr,
+                                             uint32_t _idleTimeout,
+                                             uint32_t _totalLoadThreads) :
+    m_IdleTimeout(_idleTimeout),
     m_OperationMode(_operationMode),
     m_ResourceStoragePtr(_storagePtr),
     m_FileLoaderPtr(_fileLoaderPtr),
@@ -30,6 +35,15 @@ PacketResourceManager::PacketResourceManager(OperationMode _operationMode,
         m_ResourceWatcherPtr->RegisterOnResourceDataChangedMethod(std::bind(&PacketResourceManager::OnResourceDataChanged, this, std::placeholders::_1));
     }
 
+    // The asynchronous thread sleeps until it's signalled, including when the reads it submitted complete
+    m_FileLoaderPtr->SetReadCompletionCallback([this]() { WakeAsynchronousThread(); });
+
+    // Create the load worker threads that will construct the resources
+    for (uint32_t i = 0; i < _totalLoadThreads; i++)
+    {
+        m_LoadWorkerThreads.push_back(std::thread(&PacketResourceManager::LoadWorkerThread, this));
+    }
+
     // Create the asynchronous thread that will process instances and resource objects
     m_AsynchronousManagementThread = std::thread([&]()
     {
@@ -37,7 +51,8 @@ PacketResourceManager::PacketResourceManager(OperationMode _operationMode,
         {
             AsynchronousResourceProcessment();
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(ThreadSleepTimeMS));
+            // Sleep until there is something new to process
+            WaitForWork();
         }
     });
 }
@@ -46,8 +61,28 @@ PacketResourceManager::~PacketResourceManager()
 {
     // Exit from the asynchronous thread
     m_AsynchronousManagementThreadShouldExit = true;
+    WakeAsynchronousThread();
     m_AsynchronousManagementThread.join();
 
+    // Wait for the reads in flight, their output buffers belong to resources that are about to be released
+    while (!m_ResourcesPendingRead.empty())
+    {
+        ProcessReadCompletions();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    m_FileLoaderPtr->SetReadCompletionCallback(nullptr);
+
+    // Let the load workers construct the resources they still have and exit
+    {
+        std::lock_guard<std::mutex> lock(m_LoadWorkerMutex);
+        m_LoadWorkersShouldExit = true;
+    }
+    m_LoadWorkerCondition.notify_all();
+    for (auto& loadWorkerThread : m_LoadWorkerThreads)
+    {
+        loadWorkerThread.join();
+    }
+
     // Resource create proxies that are pending evaluation
     {
         // Sorry but no proxy will be evaluated, just dequeue all of them
@@ -55,6 +90,8 @@ PacketResourceManager::~PacketResourceManager()
         while (m_ResourceCreateProxyQueue.try_dequeue(resourceCreationData))
         {
         }
+
+        m_ScheduledResourceCreations.clear();
     }
 
     // Permanent resources
@@ -223,12 +260,48 @@ std::vector<PacketResourceExternalConstructor> PacketResourceManager::GetResourc
     return std::move(outConstructors);
 }
 
+bool PacketResourceManager::BeginAccessTrace(std::string _traceFilePath)
+{
+    std::lock_guard<std::mutex> lock(m_AccessTraceMutex);
+
+    // Finish the current trace and create the new one
+    m_AccessTraceFile.close();
+    m_AccessTraceFile = std::ofstream(_traceFilePath, std::ios::out | std::ios::trunc);
+    if (!m_AccessTraceFile.is_open())
+    {
+        m_Logger->LogError(std::string("Error trying to create the access trace file: ").append(_traceFilePath).c_str());
+
+        return false;
+    }
+
+    return true;
+}
+
+void PacketResourceManager::EndAccessTrace()
+{
+    std::lock_guard<std::mutex> lock(m_AccessTraceMutex);
+
+    m_AccessTraceFile.close();
+}
+
+void PacketResourceManager::RecordAccess(Hash _hash)
+{
+    std::lock_guard<std::mutex> lock(m_AccessTraceMutex);
+
+    // One file path per line
+    if (m_AccessTraceFile.is_open())
+    {
+        m_AccessTraceFile << _hash.GetPath().String() << '\n';
+    }
+}
+
 void PacketResourceManager::RegisterResourceForDeletion(PacketResource * _resourcePtr)
 {
     // If this is a permanent resource, do not register it
     if (!_resourcePtr->IsPermanent())
     {
         m_ResourcesPendingDeletionEvaluation.enqueue(_resourcePtr);
+        WakeAsynchronousThread();
     }
 }
 
@@ -243,6 +316,15 @@ std::unique_ptr<PacketResourceCreationProxy> PacketResourceManager::GetResourceC
     return std::move(proxy);
 }
 
+PacketResourceManagerStats PacketResourceManager::GetStats() const
+{
+    PacketResourceManagerStats stats;
+    stats.totalCancelledRequests = m_TotalCancelledRequests;
+    stats.totalManagementPasses = m_TotalManagementPasses;
+
+    return stats;
+}
+
 uint32_t PacketResourceManager::GetApproximatedNumberResourcesPendingDeletion()
 {
     return static_cast<uint32_t>(m_ResourcesPendingDeletion.size());
@@ -250,62 +332,64 @@ uint32_t PacketResourceManager::GetApproximatedNumberResourcesPendingDeletion()
 
 void PacketResourceManager::AsynchronousResourceProcessment()
 {
-    // Call the update method for the resource watcher (disabled on non-edit builds)
+    m_TotalManagementPasses++;
+
+    // Call the update method for the resource watcher (disabled on non-edit builds) and let the file loader process
+    // its file watcher events
     if (m_OperationMode == OperationMode::Edit)
     {
         m_ResourceWatcherPtr->Update();
+        m_FileLoaderPtr->Update();
     }
 
     /////////////////////////////
     // EVALUATE CREATION DATAS //
     /////////////////////////////
-    while (true)
+
+    // Move the new requests into the scheduled ones
     {
-        // If we have pending instances
         ResourceCreationData resourceCreationData;
-        if (!m_ResourceCreateProxyQueue.try_dequeue(resourceCreationData))
+        while (m_ResourceCreateProxyQueue.try_dequeue(resourceCreationData))
         {
-            break;
+            m_ScheduledResourceCreations.push_back(std::move(resourceCreationData));
         }
+    }
 
-        // Get the info
-        auto& [creationProxy, factory, buildInfo, hash, isPermanent, isRuntime, resourceData] = resourceCreationData;
+    // Check how many loads can be started, if the requests don't fit they must be ordered so the most important ones
+    // are started first
+    uint32_t totalLoadsInFlight = uint32_t(m_ResourcesPendingRead.size()) + m_TotalConstructionsInFlight;
+    uint32_t totalFreeLoadSlots = totalLoadsInFlight < MaximumResourceLoadsInFlight ? MaximumResourceLoadsInFlight - totalLoadsInFlight : 0;
+    if (m_ScheduledResourceCreations.size() > totalFreeLoadSlots)
+    {
+        ScheduleResourceCreations();
+    }
 
-        // Check if we need to create and load this resource
-        PacketResource* resource = m_ResourceStoragePtr->FindObject(hash, buildInfo.buildFlags, isRuntime);
-        if (resource == nullptr)
+    // Process the requests in order until all load slots are used, requests for resources that are already loaded (or 
+    // being loaded) don't need a slot
+    size_t totalProcessedCreations = 0;
+    while (totalProcessedCreations < m_ScheduledResourceCreations.size() && totalFreeLoadSlots > 0)
+    {
+        if (ProcessResourceCreation(m_ScheduledResourceCreations[totalProcessedCreations++]))
         {
-            // Load this resource
-            auto resourceUniquePtr = m_ResourceLoader.LoadObject(
-                factory,
-                hash,
-                buildInfo,
-                isPermanent,
-                isRuntime,
-                std::move(resourceData));
-            resource = resourceUniquePtr.get();
-            assert(resource != nullptr);
-
-            // Watch this resource file object (not enabled on release and non-edit builds)
-            m_ResourceWatcherPtr->WatchResource(resource);
-
-            // Register this resource inside the storage
-            m_ResourceStoragePtr->InsertObject(std::move(resourceUniquePtr), hash, buildInfo.buildFlags);
-
-            // If this resource requires external construct, enqueue it on the correspondent queue
-            if (resource->RequiresExternalConstructPhase() && !resource->ConstructionFailed())
-            {
-                m_ResourcesPendingExternalConstruction.enqueue(resource);
-            }
+            totalFreeLoadSlots--;
         }
+    }
+    m_ScheduledResourceCreations.erase(m_ScheduledResourceCreations.begin(), m_ScheduledResourceCreations.begin() + totalProcessedCreations);
 
-        // Link the reference
-        creationProxy->ForwardResourceLink(resource);
+    ////////////////////////////
+    // RESOURCES PENDING READ //
+    ////////////////////////////
 
-        // Insert the proxy into the free queue to be reused
-        m_ResourceCreateProxyFreeQueue.enqueue(std::move(creationProxy));
+    // Submit all reads at once, so the file loader can keep them in flight together
+    if (!m_ReadRequests.empty())
+    {
+        m_FileLoaderPtr->SubmitReads(m_ReadRequests);
+        m_ReadRequests.clear();
     }
 
+    // Finish loading the resources whose reads completed
+    ProcessReadCompletions();
+
     ///////////////////////////////////
     // RESOURCES PENDING REPLACEMENT //
     ///////////////////////////////////
@@ -432,8 +516,9 @@ void PacketResourceManager::AsynchronousResourceProcessment()
         // Get the resource ptr
         std::unique_ptr<PacketResource>& resourceUniquePtr = m_ResourcesPendingDeletion[i];
 
-        // Verify is this resource is ready, if not we need to wait until it is totally evaluated
-        if (!resourceUniquePtr->IsValid())
+        // Verify is this resource is ready, if not we need to wait until it is totally evaluated (resources that failed
+        // to load or construct will never be valid, they are deleted right away)
+        if (!resourceUniquePtr->IsValid() && !resourceUniquePtr->ConstructionFailed())
         {
             continue;
         }
@@ -464,14 +549,268 @@ void PacketResourceManager::AsynchronousResourceProcessment()
         // Remove the resource from this queue
         m_ResourcesPendingDeletion.erase(m_ResourcesPendingDeletion.begin() + i);
     }
+}
+
+void PacketResourceManager::WakeAsynchronousThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WakeupMutex);
+        m_WakeupRequested = true;
+    }
+
+    m_WakeupCondition.notify_one();
+}
+
+void PacketResourceManager::WaitForWork()
+{
+    // Everything the pending resources wait for is signalled (read completions, constructions and references being 
+    // released) but the file watcher is polled by the asynchronous thread, on edit mode we can't wait without a timeout
+    uint32_t timeout = m_IdleTimeout;
+    if (timeout == 0 && m_OperationMode == OperationMode::Edit)
+    {
+        timeout = DefaultResourceThreadIdleTimeout;
+    }
+
+    std::unique_lock<std::mutex> lock(m_WakeupMutex);
+    auto isSignalled = [&]() { return m_WakeupRequested || m_AsynchronousManagementThreadShouldExit; };
+    if (timeout == 0)
+    {
+        m_WakeupCondition.wait(lock, isSignalled);
+    }
+    else
+    {
+        m_WakeupCondition.wait_for(lock, std::chrono::milliseconds(timeout), isSignalled);
+    }
+
+    m_WakeupRequested = false;
+}
+
+void PacketResourceManager::ScheduleResourceCreations()
+{
+    // Drop the requests that were abandoned while waiting, they don't need to be ordered
+    m_ScheduledResourceCreations.erase(std::remove_if(m_ScheduledResourceCreations.begin(), 
+                                                      m_ScheduledResourceCreations.end(), 
+                                                      [&](ResourceCreationData& _resourceCreationData)
+                                                      {
+                                                          return CancelAbandonedResourceCreation(_resourceCreationData);
+                                                      }), 
+                                       m_ScheduledResourceCreations.end());
+
+    // Compute the schedule key of each request, the priorities can be raised at any time so they are read only once
+    auto currentTime = std::chrono::steady_clock::now();
+    m_ScheduleKeys.clear();
+    for (size_t i = 0; i < m_ScheduledResourceCreations.size(); i++)
+    {
+        auto& [creationProxy, factory, buildInfo, hash, isPermanent, isRuntime, resourceData, requestTime] = m_ScheduledResourceCreations[i];
+        int64_t waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - requestTime).count();
+        int64_t timeToDeadline = buildInfo.deadline != 0 ? int64_t(buildInfo.deadline) - waitTime : INT64_MAX;
+        uint64_t agedPriority = uint64_t(creationProxy->GetPriority()) + uint64_t(waitTime) / ResourceRequestAgingTime;
+
+        m_ScheduleKeys.push_back({ timeToDeadline <= 0, agedPriority, timeToDeadline, requestTime, i });
+    }
+
+    // Order them, requests whose deadline was reached come first, then the highest priorities, the earliest deadlines
+    // and the oldest requests
+    std::sort(m_ScheduleKeys.begin(), m_ScheduleKeys.end(), [](const ResourceScheduleKey& _a, const ResourceScheduleKey& _b)
+    {
+        auto& [aDeadlineReached, aPriority, aTimeToDeadline, aRequestTime, aIndex] = _a;
+        auto& [bDeadlineReached, bPriority, bTimeToDeadline, bRequestTime, bIndex] = _b;
+        if (aDeadlineReached != bDeadlineReached)
+        {
+            return aDeadlineReached;
+        }
+        else if (aPriority != bPriority)
+        {
+            return aPriority > bPriority;
+        }
+        else if (aTimeToDeadline != bTimeToDeadline)
+        {
+            return aTimeToDeadline < bTimeToDeadline;
+        }
+        else if (aRequestTime != bRequestTime)
+        {
+            return aRequestTime < bRequestTime;
+        }
+
+        return aIndex < bIndex;
+    });
+
+    std::vector<ResourceCreationData> scheduledResourceCreations;
+    scheduledResourceCreations.reserve(m_ScheduledResourceCreations.size());
+    for (auto& scheduleKey : m_ScheduleKeys)
+    {
+        scheduledResourceCreations.push_back(std::move(m_ScheduledResourceCreations[std::get<4>(scheduleKey)]));
+    }
+    m_ScheduledResourceCreations = std::move(scheduledResourceCreations);
+}
+
+bool PacketResourceManager::ProcessResourceCreation(ResourceCreationData& _resourceCreationData)
+{
+    // Nothing needs to be done if the reference that requested it was released
+    if (CancelAbandonedResourceCreation(_resourceCreationData))
+    {
+        return false;
+    }
+
+    // Get the info
+    auto& [creationProxy, factory, buildInfo, hash, isPermanent, isRuntime, resourceData, requestTime] = _resourceCreationData;
+
+    // Check if we need to create and load this resource
+    bool loadStarted = false;
+    PacketResource* resource = m_ResourceStoragePtr->FindObject(hash, buildInfo.buildFlags, isRuntime);
+    if (resource == nullptr)
+    {
+        // Begin loading this resource, if its file data must be read the read is submitted with the others below
+        // and the resource is only constructed once it completes (until then it isn't valid)
+        PacketReadRequest readRequest;
+        bool requiresRead = false;
+        auto resourceUniquePtr = m_ResourceLoader.BeginLoadObject(
+            factory,
+            hash,
+            buildInfo,
+            isRuntime,
+            std::move(resourceData), 
+            requiresRead, 
+            readRequest);
+        resource = resourceUniquePtr.get();
+        assert(resource != nullptr);
+
+        // Record this load on the access trace
+        if (!isRuntime)
+        {
+            RecordAccess(hash);
+        }
+
+        // Watch this resource file object (not enabled on release and non-edit builds)
+        m_ResourceWatcherPtr->WatchResource(resource);
+
+        // Register this resource inside the storage
+        m_ResourceStoragePtr->InsertObject(std::move(resourceUniquePtr), hash, buildInfo.buildFlags);
+
+        // Queue its read or finish loading it right away
+        if (requiresRead)
+        {
+            readRequest.userData = m_NextReadIdentifier++;
+            m_ResourcesPendingRead.insert({ readRequest.userData, { resource, isPermanent } });
+            m_ReadRequests.push_back(readRequest);
+        }
+        else
+        {
+            FinishResourceLoad(resource, isPermanent, true);
+        }
+
+        loadStarted = true;
+    }
 
-    // Take a little nap
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Link the reference
+    creationProxy->ForwardResourceLink(resource);
+
+    // Insert the proxy into the free queue to be reused
+    m_ResourceCreateProxyFreeQueue.enqueue(std::move(creationProxy));
+
+    return loadStarted;
+}
+
+bool PacketResourceManager::CancelAbandonedResourceCreation(ResourceCreationData& _resourceCreationData)
+{
+    auto& creationProxy = std::get<0>(_resourceCreationData);
+    {
+        // Abandoned proxies aren't linked to any reference, nothing else can touch them
+        auto proxyLock = creationProxy->AcquireLock();
+        if (!creationProxy->IsAbandoned())
+        {
+            return false;
+        }
+    }
+
+    // Insert the proxy into the free queue to be reused
+    m_ResourceCreateProxyFreeQueue.enqueue(std::move(creationProxy));
+    m_TotalCancelledRequests++;
+
+    return true;
+}
+
+void PacketResourceManager::ProcessReadCompletions()
+{
+    m_ReadCompletions.clear();
+    m_FileLoaderPtr->DrainReadCompletions(m_ReadCompletions);
+    for (auto& completion : m_ReadCompletions)
+    {
+        auto iter = m_ResourcesPendingRead.find(completion.userData);
+        assert(iter != m_ResourcesPendingRead.end());
+
+        auto [resource, isPermanent] = iter->second;
+        m_ResourcesPendingRead.erase(iter);
+
+        FinishResourceLoad(resource, isPermanent, completion.succeeded);
+    }
+}
+
+void PacketResourceManager::FinishResourceLoad(PacketResource* _resource, bool _isPermanent, bool _readSucceeded)
+{
+    // Without load workers the resource is constructed right away
+    if (m_LoadWorkerThreads.empty())
+    {
+        ConstructResource(_resource, _isPermanent, _readSucceeded);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_LoadWorkerMutex);
+        m_ResourcesPendingConstruction.push_back({ _resource, _isPermanent, _readSucceeded });
+        m_TotalConstructionsInFlight++;
+    }
+    m_LoadWorkerCondition.notify_one();
+}
+
+void PacketResourceManager::ConstructResource(PacketResource* _resource, bool _isPermanent, bool _readSucceeded)
+{
+    // Check this before constructing, once a resource is valid it can be deleted at any time (resources that require
+    // external construct aren't valid until then)
+    bool requiresExternalConstructPhase = _resource->RequiresExternalConstructPhase();
+
+    // Construct the resource, if it failed it can be deleted at any time too
+    bool constructed = m_ResourceLoader.FinishLoadObject(_resource, _isPermanent, _readSucceeded);
+
+    // If this resource requires external construct, enqueue it on the correspondent queue
+    if (requiresExternalConstructPhase && constructed)
+    {
+        m_ResourcesPendingExternalConstruction.enqueue(_resource);
+    }
+}
+
+void PacketResourceManager::LoadWorkerThread()
+{
+    while (true)
+    {
+        ResourceLoadData resourceLoadData;
+        {
+            // Wait for a resource to construct, the queue is emptied before exiting
+            std::unique_lock<std::mutex> lock(m_LoadWorkerMutex);
+            m_LoadWorkerCondition.wait(lock, [&]() { return !m_ResourcesPendingConstruction.empty() || m_LoadWorkersShouldExit; });
+            if (m_ResourcesPendingConstruction.empty())
+            {
+                return;
+            }
+
+            resourceLoadData = m_ResourcesPendingConstruction.front();
+            m_ResourcesPendingConstruction.pop_front();
+        }
+
+        auto [resource, isPermanent, readSucceeded] = resourceLoadData;
+        ConstructResource(resource, isPermanent, readSucceeded);
+        m_TotalConstructionsInFlight--;
+
+        // The resources pending deletion or replacement (and the scheduled creations waiting for a free load slot) may be
+        // waiting for this one to be constructed
+        WakeAsynchronousThread();
+    }
 }
 
 void PacketResourceManager::RegisterResourceForModifications(PacketResource * _resource)
 {
     m_ResourcesPendingModificationEvaluation.enqueue(_resource);
+    WakeAsynchronousThread();
 }
 
 void PacketResourceManager::RegisterResourceForExternalConstruction(PacketResource * _resource)
@@ -567,6 +906,9 @@ void PacketResourceManager::OnResourceDataChanged(PacketResource * _resource)
         std::this_thread::sleep_for(std::chrono::milliseconds(3 * std::min(1, 10 - (int)maxAttempts)));
     }
 
+    // The file changed so its cached metadata can't be used
+    m_FileLoaderPtr->InvalidateFileMetadata(_resource->GetHash());
+
     // Load this resource
     auto resourceUniquePtr = m_ResourceLoader.LoadObject(_resource->GetFactoryPtr(),
                                                          _resource->GetHash(),
@@ -590,6 +932,8 @@ void PacketResourceManager::OnResourceDataChanged(PacketResource * _resource)
         resourceUniquePtr->BeginExternalConstruct(nullptr);
     }
 
-    // Move the resource into the replace queue
+    // Move the resource into the replace queue, the watcher events are handled while processing so make sure the 
+    // replacement is evaluated without waiting
     m_ResourcesPendingReplacement.push_back({ std::move(resourceUniquePtr), _resource });
+    WakeAsynchronousThread();
 }
\ No newline at end of file
@@ -19,6 +19,13 @@
 #include <cstdint>
 #include <vector>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
 
 ///////////////
 // NAMESPACE //
@@ -71,6 +78,25 @@ public:
     friend PacketResourceExternalConstructor;
 	friend PacketSystem;
 
+private:
+
+    // A resource creation request, its proxy, factory, build info, hash, if it's permanent, if it's a runtime resource,
+    // its runtime data and when it was requested
+    typedef std::tuple<
+        std::unique_ptr<PacketResourceCreationProxy>,
+        PacketResourceFactory*,
+        PacketResourceBuildInfo,
+        Hash,
+        bool,
+        bool,
+        std::vector<uint8_t>, 
+        std::chrono::steady_clock::time_point>
+        ResourceCreationData;
+
+    // The key used to schedule a resource creation, if its deadline was reached, its aged priority, the time left until
+    // its deadline, when it was requested and its index
+    typedef std::tuple<bool, uint64_t, int64_t, std::chrono::steady_clock::time_point, size_t> ResourceScheduleKey;
+
 //////////////////
 // CONSTRUCTORS //
 public: //////////
@@ -81,7 +107,9 @@ public: //////////
 		PacketFileLoader* _fileLoaderPtr, 
 		PacketReferenceManager* _referenceManager, 
 		PacketResourceWatcher* _resourceWatcherPtr, 
-		PacketLogger* _loggerPtr);
+		PacketLogger* _loggerPtr, 
+		uint32_t _idleTimeout = DefaultResourceThreadIdleTimeout, 
+		uint32_t _totalLoadThreads = 0);
 	~PacketResourceManager();
 	
 //////////////////
@@ -112,8 +140,9 @@ protected: ///////
         // Get a proxy for this resource reference
         auto resourceCreationProxy = GetResourceCreationProxy();
 
-        // Register the creation proxy
+        // Register the creation proxy and set the request priority
         _resourceReference.RegisterCreationProxy(resourceCreationProxy.get());
+        resourceCreationProxy->SetPriority(_resourceBuildInfo.priority);
 
         // Add this new creation data into our processing queue
         m_ResourceCreateProxyQueue.enqueue({ std::move(resourceCreationProxy),
@@ -122,7 +151,11 @@ protected: ///////
                                              _hash,
                                              _isPersistent,
                                              false, 
-                                             std::vector<uint8_t>() });
+                                             std::vector<uint8_t>(), 
+                                             std::chrono::steady_clock::now() });
+
+        // Wake up the asynchronous thread to process it
+        WakeAsynchronousThread();
 
         return true;
     }
@@ -136,8 +169,9 @@ protected: ///////
         // Get a proxy for this resource reference
         auto resourceCreationProxy = GetResourceCreationProxy();
 
-        // Register the creation proxy
+        // Register the creation proxy and set the request priority
         _resourceReference.RegisterCreationProxy(resourceCreationProxy.get());
+        resourceCreationProxy->SetPriority(_resourceBuildInfo.priority);
 
         // Add this new creation data into our processing queue
         m_ResourceCreateProxyQueue.enqueue({ std::move(resourceCreationProxy),
@@ -146,9 +180,41 @@ protected: ///////
                                              Hash(), 
                                              false, 
                                              true, 
-                                             std::move(_resourceData)});
+                                             std::move(_resourceData), 
+                                             std::chrono::steady_clock::now() });
+
+        // Wake up the asynchronous thread to process it
+        WakeAsynchronousThread();
     }
   
+    // Raise the priority of a request that is still waiting to be processed, returns false if the given reference has
+    // no pending request (a priority lower than the current one is ignored)
+    template <typename ResourceClass>
+    bool RaiseResourcePriority(const PacketResourceReference<ResourceClass>& _resourceReference, uint32_t _priority)
+    {
+        PacketResourceCreationProxy* creationProxy = _resourceReference.m_CreationProxy;
+        if (creationProxy == nullptr)
+        {
+            return false;
+        }
+
+        {
+            // Check if the proxy is still waiting to update this reference
+            auto proxyLock = creationProxy->AcquireLock();
+            if (!creationProxy->IsLinkedTo(&_resourceReference.m_ResourceObject))
+            {
+                return false;
+            }
+
+            creationProxy->RaisePriority(_priority);
+        }
+
+        // Wake up the asynchronous thread so the new priority is taken into account
+        WakeAsynchronousThread();
+
+        return true;
+    }
+
     // This method will wait until the given resource is ready to be used
     // Optionally you can pass a timeout parameter in milliseconds
     template <typename ResourceClass>
@@ -182,8 +248,21 @@ protected: ///////
     // by the user externally (since the resource requires it)
     std::vector<PacketResourceExternalConstructor> GetResourceExternalConstructors();
 
+    // Begin recording the path of each resource file loaded (in load order) into the given trace file, any trace
+    // being recorded is finished
+    bool BeginAccessTrace(std::string _traceFilePath);
+
+    // Finish recording the access trace
+    void EndAccessTrace();
+
+    // Return the resource manager statistics
+    PacketResourceManagerStats GetStats() const;
+
 protected:
 
+    // Record a resource file load on the access trace (if it's being recorded)
+    void RecordAccess(Hash _hash);
+
     // Return a valid usable resource creation proxy object
     std::unique_ptr<PacketResourceCreationProxy> GetResourceCreationProxy();
 
@@ -193,6 +272,35 @@ protected:
     // The asynchronous resource process method
     void AsynchronousResourceProcessment();
 
+    // Signal the asynchronous thread that there is new work to be processed
+    void WakeAsynchronousThread();
+
+    // Sleep the asynchronous thread until it's signalled or until the timeout (that depends on the pending work) elapses
+    void WaitForWork();
+
+    // Order the scheduled resource creations so the ones that must be started first come first
+    void ScheduleResourceCreations();
+
+    // Process a resource creation, linking it to an existing resource or beginning to load a new one (abandoned requests
+    // are cancelled), returns if a new load was started
+    bool ProcessResourceCreation(ResourceCreationData& _resourceCreationData);
+
+    // Cancel a resource creation if the reference that requested it was released, returns if it was cancelled
+    bool CancelAbandonedResourceCreation(ResourceCreationData& _resourceCreationData);
+
+    // Finish loading the resources whose file reads completed
+    void ProcessReadCompletions();
+
+    // Finish loading a resource whose data is ready, it's constructed by a load worker thread (or right away when there
+    // are no load workers)
+    void FinishResourceLoad(PacketResource* _resource, bool _isPermanent, bool _readSucceeded);
+
+    // Construct a resource whose data is ready
+    void ConstructResource(PacketResource* _resource, bool _isPermanent, bool _readSucceeded);
+
+    // The load worker thread loop
+    void LoadWorkerThread();
+
 	// This method is called when a resource file is modified, its execution will happen when inside the 
 	// update phase. This method won't be called when on release or non edit builds
 	void OnResourceDataChanged(PacketResource* _resource);
@@ -215,20 +323,19 @@ protected:
 // VARIABLES //
 private: //////
 
-    typedef std::tuple<
-        std::unique_ptr<PacketResourceCreationProxy>,
-        PacketResourceFactory*,
-        PacketResourceBuildInfo,
-        Hash,
-        bool,
-        bool,
-        std::vector<uint8_t>>
-        ResourceCreationData;
-
     // Proxy queues
     moodycamel::ConcurrentQueue<ResourceCreationData>                         m_ResourceCreateProxyQueue;
     moodycamel::ConcurrentQueue<std::unique_ptr<PacketResourceCreationProxy>> m_ResourceCreateProxyFreeQueue;
    
+    // The resource creations waiting for a free load slot (see MaximumResourceLoadsInFlight) and the buffer used to
+    // order them when scheduling
+    std::vector<ResourceCreationData> m_ScheduledResourceCreations;
+    std::vector<ResourceScheduleKey>  m_ScheduleKeys;
+
+    // The total number of cancelled requests and management passes
+    std::atomic<uint64_t> m_TotalCancelledRequests = 0;
+    std::atomic<uint64_t> m_TotalManagementPasses = 0;
+
     // Resource queues/vector
     moodycamel::ConcurrentQueue<PacketResource*>                             m_ResourcesPendingExternalConstruction;
     moodycamel::ConcurrentQueue<PacketResource*>                             m_ResourcesPendingDeletionEvaluation;
@@ -237,9 +344,38 @@ private: //////
     moodycamel::ConcurrentQueue<PacketResource*>                             m_ResourcesPendingModificationEvaluation;
     std::vector<PacketResource*>                                             m_ResourcesPendingModification;
 
+    // The resources waiting for their file data (and if they are permanent) by read identifier, the reads that will be
+    // submitted together and the buffer used to collect the completed ones
+    std::unordered_map<uint64_t, std::pair<PacketResource*, bool>> m_ResourcesPendingRead;
+    std::vector<PacketReadRequest>                                 m_ReadRequests;
+    std::vector<PacketReadCompletion>                              m_ReadCompletions;
+    uint64_t                                                       m_NextReadIdentifier = 0;
+
+    // The resources whose data is ready and that are waiting for a load worker thread to construct them (and if they
+    // are permanent and if their read succeeded), the load worker threads and their exit flag. Resources are inserted
+    // into the storage before being constructed, so requests for a resource that is still being loaded just link to it
+    typedef std::tuple<PacketResource*, bool, bool> ResourceLoadData;
+    std::deque<ResourceLoadData> m_ResourcesPendingConstruction;
+    std::mutex                   m_LoadWorkerMutex;
+    std::condition_variable      m_LoadWorkerCondition;
+    std::vector<std::thread>     m_LoadWorkerThreads;
+    bool                         m_LoadWorkersShouldExit = false;
+    std::atomic<uint32_t>        m_TotalConstructionsInFlight = 0;
+
+    // The access trace file (if one is being recorded) and the mutex that protects it
+    std::mutex    m_AccessTraceMutex;
+    std::ofstream m_AccessTraceFile;
+
     // The asynchronous management thread and the conditional to exit
-    std::thread m_AsynchronousManagementThread;
-    bool        m_AsynchronousManagementThreadShouldExit = false;
+    std::thread       m_AsynchronousManagementThread;
+    std::atomic<bool> m_AsynchronousManagementThreadShouldExit = false;
+
+    // The signal used to wake up the asynchronous thread, if a wake up was requested since it last woke up and the 
+    // maximum time it sleeps when idle (0 means until signalled)
+    std::mutex              m_WakeupMutex;
+    std::condition_variable m_WakeupCondition;
+    bool                    m_WakeupRequested = false;
+    uint32_t                m_IdleTimeout;
 
 	// The resource loader and deleter
 	PacketResourceLoader  m_ResourceLoader;
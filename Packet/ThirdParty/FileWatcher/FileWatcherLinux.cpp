@@ -150,8 +150,12 @@ namespace FWPacket
 			{
 				struct inotify_event *pevent = (struct inotify_event *)&buff[i];
 
-				WatchStruct* watch = mWatches[pevent->wd];
-				handleAction(watch, pevent->name, pevent->mask);
+				// Events can still arrive for a watch that was just removed (IN_IGNORED)
+				WatchMap::iterator iter = mWatches.find(pevent->wd);
+				if(iter != mWatches.end())
+				{
+					handleAction(iter->second, pevent->name, pevent->mask);
+				}
 				i += sizeof(struct inotify_event) + pevent->len;
 			}
 		}
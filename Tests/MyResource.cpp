@@ -1,5 +1,13 @@
 #include "MyResource.h"
 
+#include <thread>
+#include <chrono>
+
+std::atomic<uint32_t> MyResource::totalConstructions = 0;
+std::atomic<uint32_t> MyResource::totalConstructing = 0;
+std::atomic<uint32_t> MyResource::maximumConstructing = 0;
+std::atomic<uint32_t> MyResource::constructDelay = 0;
+
 MyResource::MyResource()
 {
 }
@@ -11,6 +19,17 @@ MyResource::~MyResource()
 
 bool MyResource::OnConstruct(Packet::ResourceData& _data, uint32_t _buildFlags, uint32_t _flags)
 {
+    uint32_t constructing = ++totalConstructing;
+    uint32_t maximum = maximumConstructing;
+    while (constructing > maximum && !maximumConstructing.compare_exchange_weak(maximum, constructing))
+    {
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(constructDelay));
+
+    totalConstructing--;
+    totalConstructions++;
+
     return true;
 }
 
@@ -2,6 +2,8 @@
 
 #include "..\Packet\Packet.h"
 
+#include <atomic>
+
 class MyResource : public Packet::Resource
 {
 public:
@@ -15,4 +17,11 @@ public:
     bool OnExternalConstruct(Packet::ResourceData& _data, uint32_t _buildFlags, uint32_t _flags, void* _customData) final;
 
     bool OnDelete(Packet::ResourceData& _data) final;
+
+    // How many resources were constructed, how many are being constructed right now and the maximum that were
+    // constructed at the same time, the construct delay (in milliseconds) simulates an expensive construction
+    static std::atomic<uint32_t> totalConstructions;
+    static std::atomic<uint32_t> totalConstructing;
+    static std::atomic<uint32_t> maximumConstructing;
+    static std::atomic<uint32_t> constructDelay;
 };
\ No newline at end of file
@@ -0,0 +1,2172 @@
+#include <catch2/catch.hpp>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <set>
+#include <algorithm>
+
+#include "..\Packet\Packet.h"
+#include "..\Packet\PacketEditModeFileLoader.h"
+#include "..\Packet\PacketCondensedModeFileLoader.h"
+#include "..\Packet\PacketCondensedManifest.h"
+#include "MyResource.h"
+#include "MyFactory.h"
+#include "HelperMethods.h"
+#include "HelperDefines.h"
+
+// The mode names used by the sections that run once for each mode, Catch2 only runs a section once per name
+static std::string GetModeName(Packet::CondensedReaderMode _readerMode)
+{
+    return _readerMode == Packet::CondensedReaderMode::Mapped ? "mapped reader" : "stream reader";
+}
+
+static std::string GetCompressionName(Packet::Compression _compression)
+{
+    return _compression == Packet::Compression::LZ4 ? "LZ4 compression" : "no compression";
+}
+
+static std::string GetAsyncReadModeName(Packet::AsyncReadMode _asyncReadMode)
+{
+    return _asyncReadMode == Packet::AsyncReadMode::ThreadPool ? "thread pool" : "automatic read mode";
+}
+
+SCENARIO("Condensed files can be read from multiple threads at the same time", "[condensed]")
+{
+    GIVEN("A data folder with a few resource files that was condensed using the edit mode loader")
+    {
+        std::vector<std::pair<std::string, uint32_t>> resourceFiles;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/condensed_" + std::to_string(i) + ".txt";
+            CreateResourceFile(resourcePath, 10 + i * 5);
+            resourceFiles.push_back({ resourcePath, 10 + i * 5 });
+        }
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        for (auto readerMode : { Packet::CondensedReaderMode::Mapped, Packet::CondensedReaderMode::Stream })
+        {
+            WHEN("The condensed files are read by multiple threads using the " + GetModeName(readerMode))
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger, readerMode);
+
+                std::atomic<uint32_t> totalValidReads = 0;
+                std::vector<std::thread> threads;
+                for (uint32_t t = 0; t < 4; t++)
+                {
+                    threads.push_back(std::thread([&]()
+                    {
+                        for (auto& [resourcePath, amountWritten] : resourceFiles)
+                        {
+                            Packet::Hash hash = Packet::Hash(resourcePath);
+                            std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                            if (!fileLoader.GetFileData(data.data(), data.size(), hash))
+                            {
+                                continue;
+                            }
+
+                            std::string expectedData;
+                            for (uint32_t i = 0; i < amountWritten; i++)
+                            {
+                                expectedData.append(std::to_string(amountWritten));
+                            }
+
+                            if (std::string(data.begin(), data.end()) == expectedData)
+                            {
+                                totalValidReads++;
+                            }
+                        }
+                    }));
+                }
+
+                for (auto& thread : threads)
+                {
+                    thread.join();
+                }
+
+                THEN("Every read must return the original file content")
+                {
+                    REQUIRE(totalValidReads == 4 * resourceFiles.size());
+                }
+            }
+        }
+    }
+}
+
+// A resource that records the data it was constructed with and a factory that accepts data views, counting how many
+// times its allocator and deallocator were called
+class MyViewResource : public Packet::Resource
+{
+public:
+
+    bool OnConstruct(Packet::ResourceData& _data, uint32_t, uint32_t) final
+    {
+        m_Data = _data.GetData();
+        m_Size = _data.GetSize();
+        m_WasDataView = _data.IsDataView();
+        return true;
+    }
+
+    bool OnExternalConstruct(Packet::ResourceData&, uint32_t, uint32_t, void*) final
+    {
+        return true;
+    }
+
+    bool OnDelete(Packet::ResourceData&) final
+    {
+        return true;
+    }
+
+    // Return the content the resource data points to right now
+    std::string GetContent() const
+    {
+        return std::string(reinterpret_cast<const char*>(m_Data), size_t(m_Size));
+    }
+
+    bool WasDataView() const
+    {
+        return m_WasDataView;
+    }
+
+private:
+
+    const uint8_t* m_Data = nullptr;
+    uint64_t m_Size = 0;
+    bool m_WasDataView = false;
+};
+
+class MyViewFactory : public Packet::ResourceFactory
+{
+public:
+
+    std::unique_ptr<Packet::Resource> RequestObject() final
+    {
+        return std::unique_ptr<Packet::Resource>(new MyViewResource());
+    }
+
+    void ReleaseObject(std::unique_ptr<Packet::Resource> _object) final
+    {
+        _object.reset();
+    }
+
+    bool AllocateData(Packet::ResourceData& _data, uint64_t _total) final
+    {
+        totalAllocations++;
+        _data.AllocateMemory(_total);
+
+        return true;
+    }
+
+    void DeallocateData(Packet::ResourceData& _data) final
+    {
+        totalDeallocations++;
+        _data.DeallocateMemory();
+    }
+
+    bool SupportsDataView() const final
+    {
+        return true;
+    }
+
+    static inline std::atomic<uint32_t> totalAllocations = 0;
+    static inline std::atomic<uint32_t> totalDeallocations = 0;
+};
+
+SCENARIO("Resources can use a view into the mapped condensed files instead of a copy", "[condensed]")
+{
+    GIVEN("A data folder with a few resource files that was condensed using the edit mode loader")
+    {
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/view_" + std::to_string(i) + ".txt";
+            CreateResourceFile(resourcePath, 20 + i * 7);
+
+            std::string resourceData;
+            for (uint32_t j = 0; j < 20 + i * 7; j++)
+            {
+                resourceData.append(std::to_string(20 + i * 7));
+            }
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+            REQUIRE(packetSystem.ConstructPacket() == true);
+        }
+
+        WHEN("A view is taken from a condensed loader that is destroyed right after")
+        {
+            __development__Packet::PacketFileDataView dataView;
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger);
+                fileLoader.GetFileDataView(dataView, Packet::Hash(resourceFiles[0].first));
+            }
+
+            THEN("The view keeps the mapped file alive and still holds the file content")
+            {
+                REQUIRE(dataView.data != nullptr);
+                REQUIRE(std::string(reinterpret_cast<const char*>(dataView.data), size_t(dataView.size)) == resourceFiles[0].second);
+            }
+        }
+
+        WHEN("The resources are loaded by a factory that accepts data views and released")
+        {
+            uint32_t initialAllocations = MyViewFactory::totalAllocations;
+            uint32_t initialDeallocations = MyViewFactory::totalDeallocations;
+
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory);
+            packetSystem.RegisterResourceFactory<MyViewFactory, MyViewResource>();
+
+            std::vector<Packet::ResourceReference<MyViewResource>> resourceReferences(resourceFiles.size());
+            for (uint32_t i = 0; i < resourceFiles.size(); i++)
+            {
+                packetSystem.RequestResource<MyViewResource>(resourceReferences[i], Packet::Hash(resourceFiles[i].first));
+            }
+
+            uint32_t totalValidViews = 0;
+            for (uint32_t i = 0; i < resourceFiles.size(); i++)
+            {
+                if (packetSystem.WaitForResource(resourceReferences[i], MaximumTimeoutWaitMS) 
+                    && resourceReferences[i]->WasDataView() 
+                    && resourceReferences[i]->GetContent() == resourceFiles[i].second)
+                {
+                    totalValidViews++;
+                }
+            }
+
+            resourceReferences.clear();
+            bool resourcesDeleted = MustChangeToTrueUntilTimeout([&]()
+            {
+                return packetSystem.GetAproximatedResourceAmount() == 0;
+            }, 5000);
+
+            THEN("Each resource data is a view with the file content and the factory never allocates or deallocates it")
+            {
+                REQUIRE(totalValidViews == resourceFiles.size());
+                REQUIRE(resourcesDeleted == true);
+                REQUIRE(MyViewFactory::totalAllocations == initialAllocations);
+                REQUIRE(MyViewFactory::totalDeallocations == initialDeallocations);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files support more entries than a single condensed file used to hold", "[condensed]")
+{
+    GIVEN("A data folder with more than 2048 resource files inside the same folder")
+    {
+        const uint32_t totalResourceFiles = 2100;
+        for (uint32_t i = 0; i < totalResourceFiles; i++)
+        {
+            CreateResourceFile(ResourceDirectory + "/manifest/entry_" + std::to_string(i) + ".txt", 1);
+        }
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        WHEN("The condensed files are loaded")
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger);
+
+            THEN("Every entry must be found")
+            {
+                uint32_t totalFound = 0;
+                for (uint32_t i = 0; i < totalResourceFiles; i++)
+                {
+                    Packet::Hash hash = Packet::Hash(ResourceDirectory + "/manifest/entry_" + std::to_string(i) + ".txt");
+                    totalFound += fileLoader.FileExist(hash) && fileLoader.GetFileSize(hash) == 1 ? 1 : 0;
+                }
+
+                REQUIRE(totalFound == totalResourceFiles);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files can be compressed", "[condensed]")
+{
+    GIVEN("A data folder with small resource files and a resource file with multiple compression chunks")
+    {
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/compressed/small_" + std::to_string(i) + ".txt";
+            CreateResourceFile(resourcePath, 20 + i * 30);
+
+            std::string expectedData;
+            for (uint32_t j = 0; j < 20 + i * 30; j++)
+            {
+                expectedData.append(std::to_string(20 + i * 30));
+            }
+            resourceFiles.push_back({ resourcePath, expectedData });
+        }
+
+        std::string largeResourceData;
+        for (uint32_t i = 0; largeResourceData.size() < 1000000; i++)
+        {
+            largeResourceData.append(i % 7 == 0 ? std::to_string(i * 2654435761u) : "resource");
+        }
+        std::string largeResourcePath = ResourceDirectory + "/compressed/large.txt";
+        std::ofstream(largeResourcePath, std::ios::binary) << largeResourceData;
+        resourceFiles.push_back({ largeResourcePath, largeResourceData });
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.compression = Packet::Compression::LZ4;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        for (auto readerMode : { Packet::CondensedReaderMode::Mapped, Packet::CondensedReaderMode::Stream })
+        {
+            WHEN("The compressed condensed files are read using the " + GetModeName(readerMode))
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger, readerMode);
+
+                uint32_t totalValidReads = 0;
+                for (auto& [resourcePath, expectedData] : resourceFiles)
+                {
+                    Packet::Hash hash = Packet::Hash(resourcePath);
+                    std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                    if (fileLoader.GetFileData(data.data(), data.size(), hash) && std::string(data.begin(), data.end()) == expectedData)
+                    {
+                        totalValidReads++;
+                    }
+                }
+
+                THEN("Every read must return the original file content")
+                {
+                    REQUIRE(totalValidReads == resourceFiles.size());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Small condensed files can be grouped into solid blocks", "[condensed]")
+{
+    GIVEN("A data folder with many small resource files that share most of their content")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/solid");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 200; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/solid/material_" + std::to_string(i) + ".json";
+            std::string resourceData = std::string("{ \"name\": \"material_") + std::to_string(i) 
+                + "\", \"shader\": \"default\", \"roughness\": " + std::to_string(i % 10) 
+                + ", \"metallic\": 0, \"textures\": [ \"albedo_" + std::to_string(i) + ".png\" ] }";
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.compression = Packet::Compression::LZ4;
+        condenseSettings.solidEntryMaximumSize = 1024;
+        condenseSettings.solidBlockSize = 4096;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        for (auto readerMode : { Packet::CondensedReaderMode::Mapped, Packet::CondensedReaderMode::Stream })
+        {
+            WHEN("The solid entries are read by the " + GetModeName(readerMode) + " using a block cache smaller than the total data")
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger, readerMode, 8192);
+
+                uint32_t totalValidReads = 0;
+                uint32_t totalValidViews = 0;
+                for (auto& [resourcePath, expectedData] : resourceFiles)
+                {
+                    Packet::Hash hash = Packet::Hash(resourcePath);
+                    std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                    if (fileLoader.GetFileData(data.data(), data.size(), hash) && std::string(data.begin(), data.end()) == expectedData)
+                    {
+                        totalValidReads++;
+                    }
+
+                    __development__Packet::PacketFileDataView dataView;
+                    if (fileLoader.GetFileDataView(dataView, hash) && std::string(dataView.data, dataView.data + dataView.size) == expectedData)
+                    {
+                        totalValidViews++;
+                    }
+                }
+
+                THEN("Every read and every view must return the original file content")
+                {
+                    REQUIRE(totalValidReads == resourceFiles.size());
+                    REQUIRE(totalValidViews == resourceFiles.size());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files are the same for any number of condense threads", "[condensed]")
+{
+    GIVEN("A data folder with small and large resource files")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/threads");
+
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            std::string resourceData;
+            for (uint32_t j = 0; j < (i % 4 == 0 ? 20000u : 20u); j++)
+            {
+                resourceData.append("vertex ").append(std::to_string(i * j)).append(";");
+            }
+            std::ofstream(ResourceDirectory + "/threads/mesh_" + std::to_string(i) + ".txt", std::ios::binary) << resourceData;
+        }
+
+        // Read the manifest (without its save time) and every condensed file it references
+        auto ReadCondensedData = [&]()
+        {
+            std::string manifestPath = __development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension);
+            std::ifstream manifestFile(manifestPath, std::ios::binary);
+            std::string condensedData((std::istreambuf_iterator<char>(manifestFile)), std::istreambuf_iterator<char>());
+            condensedData.erase(0, sizeof(uint64_t));
+
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedManifest manifest;
+            if (!manifest.Open(manifestPath, &logger))
+            {
+                return std::string();
+            }
+
+            for (uint32_t i = 0; i < manifest.GetTotalPacks(); i++)
+            {
+                std::ifstream packFile(manifest.GetPackPath(manifest.GetPack(i)), std::ios::binary);
+                condensedData.append((std::istreambuf_iterator<char>(packFile)), std::istreambuf_iterator<char>());
+            }
+
+            return condensedData;
+        };
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.compression = Packet::Compression::LZ4;
+        condenseSettings.solidEntryMaximumSize = 1024;
+        condenseSettings.solidBlockSize = 4096;
+
+        WHEN("The data folder is condensed using one thread and using multiple threads")
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+
+            condenseSettings.threadCount = 1;
+            REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+            std::string singleThreadData = ReadCondensedData();
+
+            condenseSettings.threadCount = 8;
+            REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+            std::string multipleThreadsData = ReadCondensedData();
+
+            THEN("The condensed files must be identical")
+            {
+                REQUIRE(singleThreadData.size() > 0);
+                REQUIRE(singleThreadData == multipleThreadsData);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files can be updated incrementally", "[condensed]")
+{
+    GIVEN("A data folder that was condensed and then had files modified, added and removed")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/incremental");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 32; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/incremental/level_" + std::to_string(i) + ".txt";
+            std::string resourceData = std::string("level ") + std::to_string(i) + std::string(i * 64, 'x');
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.compression = Packet::Compression::LZ4;
+        condenseSettings.solidEntryMaximumSize = 1024;
+        condenseSettings.solidBlockSize = 4096;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        __development__Packet::PacketLogger logger;
+        auto totalPacks = [&]()
+        {
+            __development__Packet::PacketCondensedManifest manifest;
+            manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger);
+            return manifest.GetTotalPacks();
+        };
+        uint32_t initialTotalPacks = totalPacks();
+
+        resourceFiles[3].second = "modified level";
+        std::ofstream(resourceFiles[3].first, std::ios::binary) << resourceFiles[3].second;
+        resourceFiles.push_back({ ResourceDirectory + "/incremental/level_new.txt", "new level" });
+        std::ofstream(resourceFiles.back().first, std::ios::binary) << resourceFiles.back().second;
+        std::string removedPath = resourceFiles[5].first;
+        std::filesystem::remove(removedPath);
+        resourceFiles.erase(resourceFiles.begin() + 5);
+
+        WHEN("The data folder is condensed incrementally")
+        {
+            condenseSettings.incremental = true;
+            REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger);
+
+            uint32_t totalValidReads = 0;
+            for (auto& [resourcePath, expectedData] : resourceFiles)
+            {
+                Packet::Hash hash = Packet::Hash(resourcePath);
+                std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                if (fileLoader.GetFileData(data.data(), data.size(), hash) && std::string(data.begin(), data.end()) == expectedData)
+                {
+                    totalValidReads++;
+                }
+            }
+
+            THEN("Only the changed files are condensed into a new condensed file and the removed files are dropped")
+            {
+                REQUIRE(totalPacks() == initialTotalPacks + 1);
+                REQUIRE(totalValidReads == resourceFiles.size());
+                REQUIRE(fileLoader.FileExist(Packet::Hash(removedPath)) == false);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files with the same content are stored once", "[condensed]")
+{
+    GIVEN("A data folder with the same resource files copied into multiple folders")
+    {
+        std::string sharedData;
+        for (uint32_t i = 0; sharedData.size() < 100000; i++)
+        {
+            sharedData.append(std::to_string(i * 7919)).append(",");
+        }
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (auto folder : { "/duplicated/a", "/duplicated/b", "/duplicated/c" })
+        {
+            std::filesystem::create_directories(ResourceDirectory + folder);
+
+            resourceFiles.push_back({ ResourceDirectory + folder + "/texture.txt", sharedData });
+            resourceFiles.push_back({ ResourceDirectory + folder + "/default_a.cfg", "default = true" });
+            resourceFiles.push_back({ ResourceDirectory + folder + "/default_b.cfg", "default = true" });
+            resourceFiles.push_back({ ResourceDirectory + folder + "/unique.cfg", std::string("folder = ") + folder });
+        }
+        for (auto& [resourcePath, resourceData] : resourceFiles)
+        {
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+        }
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.compression = Packet::Compression::LZ4;
+        condenseSettings.solidEntryMaximumSize = 1024;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        WHEN("The condensed files are loaded")
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger) == true);
+
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger);
+
+            uint32_t totalValidReads = 0;
+            for (auto& [resourcePath, expectedData] : resourceFiles)
+            {
+                Packet::Hash hash = Packet::Hash(resourcePath);
+                std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                if (fileLoader.GetFileData(data.data(), data.size(), hash) && std::string(data.begin(), data.end()) == expectedData)
+                {
+                    totalValidReads++;
+                }
+            }
+
+            auto* firstTexture = manifest.FindEntry(Packet::Hash(resourceFiles[0].first).GetHashValue());
+            auto* secondTexture = manifest.FindEntry(Packet::Hash(resourceFiles[4].first).GetHashValue());
+            auto* firstDefault = manifest.FindEntry(Packet::Hash(resourceFiles[1].first).GetHashValue());
+            auto* secondDefault = manifest.FindEntry(Packet::Hash(resourceFiles[2].first).GetHashValue());
+
+            THEN("Entries with the same content must point to the same data")
+            {
+                REQUIRE(totalValidReads == resourceFiles.size());
+                REQUIRE(firstTexture != nullptr);
+                REQUIRE(secondTexture != nullptr);
+                REQUIRE(firstTexture->packIndex == secondTexture->packIndex);
+                REQUIRE(firstTexture->location == secondTexture->location);
+                REQUIRE(firstDefault != nullptr);
+                REQUIRE(secondDefault != nullptr);
+                REQUIRE(firstDefault->blockIndex == secondDefault->blockIndex);
+                REQUIRE(firstDefault->blockOffset == secondDefault->blockOffset);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed entries can be aligned", "[condensed]")
+{
+    GIVEN("A data folder with resource files of many sizes that was condensed with a 4KB alignment")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/aligned");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/aligned/chunk_" + std::to_string(i) + ".bin";
+            std::string resourceData = std::string(i * 997 + 1, char('a' + i));
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.alignment = 4096;
+        condenseSettings.alignmentMinimumSize = 1024;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        WHEN("The condensed files are loaded")
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger) == true);
+
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger);
+
+            uint32_t totalValidReads = 0;
+            uint32_t totalAlignedEntries = 0;
+            uint32_t totalLargeEntries = 0;
+            for (auto& [resourcePath, expectedData] : resourceFiles)
+            {
+                Packet::Hash hash = Packet::Hash(resourcePath);
+                std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                if (fileLoader.GetFileData(data.data(), data.size(), hash) && std::string(data.begin(), data.end()) == expectedData)
+                {
+                    totalValidReads++;
+                }
+
+                auto* entryInfo = manifest.FindEntry(hash.GetHashValue());
+                if (entryInfo != nullptr && entryInfo->storedSize >= condenseSettings.alignmentMinimumSize)
+                {
+                    totalLargeEntries++;
+                    totalAlignedEntries += entryInfo->location % condenseSettings.alignment == 0 ? 1 : 0;
+                }
+            }
+
+            THEN("The alignment is recorded and every large entry begins at an aligned location")
+            {
+                REQUIRE(manifest.GetAlignment() == condenseSettings.alignment);
+                REQUIRE(totalValidReads == resourceFiles.size());
+                REQUIRE(totalLargeEntries > 0);
+                REQUIRE(totalAlignedEntries == totalLargeEntries);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files can be ordered using an access trace", "[condensed]")
+{
+    GIVEN("A condensed data folder and an access trace recorded while loading a file from each of its folders")
+    {
+        std::vector<std::string> loadedPaths;
+        for (auto folder : { "/trace/c", "/trace/a", "/trace/b" })
+        {
+            std::filesystem::create_directories(ResourceDirectory + folder);
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                CreateResourceFile(ResourceDirectory + folder + "/resource_" + std::to_string(i) + ".txt", 100 + i + 10 * uint32_t(loadedPaths.size()));
+            }
+            loadedPaths.push_back(ResourceDirectory + folder + "/resource_3.txt");
+        }
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        packetSystem.RegisterResourceFactory<MyFactory, MyResource>();
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        std::string accessTracePath = "access_trace.txt";
+        REQUIRE(packetSystem.BeginAccessTrace(accessTracePath) == true);
+        for (auto& loadedPath : loadedPaths)
+        {
+            Packet::ResourceReference<MyResource> resourceReference;
+            packetSystem.RequestResource<MyResource>(resourceReference, Packet::Hash(loadedPath));
+            REQUIRE(packetSystem.WaitForResource(resourceReference, MaximumTimeoutWaitMS) == true);
+        }
+        packetSystem.EndAccessTrace();
+
+        std::vector<Packet::Hash> accessTrace;
+        for (auto& loadedPath : loadedPaths)
+        {
+            accessTrace.push_back(Packet::Hash(loadedPath));
+        }
+
+        std::string manifestPath = __development__Packet::GetRootFolder(ResourceDirectory)
+            .append(__development__Packet::CondensedInfoName)
+            .append(__development__Packet::CondensedInfoExtension);
+        __development__Packet::PacketLogger logger;
+        uint64_t totalSeeksBefore = 0;
+        {
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(manifest.Open(manifestPath, &logger) == true);
+            totalSeeksBefore = manifest.CountAccessSeeks(accessTrace);
+        }
+
+        WHEN("The data folder is condensed using the access trace")
+        {
+            Packet::CondenseSettings condenseSettings;
+            condenseSettings.accessTracePath = accessTracePath;
+            REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(manifest.Open(manifestPath, &logger) == true);
+
+            THEN("The traced files are read sequentially")
+            {
+                REQUIRE(totalSeeksBefore == loadedPaths.size());
+                REQUIRE(manifest.CountAccessSeeks(accessTrace) == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Corrupted condensed data is detected when it's read", "[condensed]")
+{
+    GIVEN("A data folder with a few resource files that was condensed and then had one of its entries corrupted")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/verified");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/verified/entry_" + std::to_string(i) + ".bin";
+            std::string resourceData = std::string(100 + i * 31, char('a' + i));
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        std::string corruptedPath = resourceFiles[3].first;
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger) == true);
+
+            auto* entryInfo = manifest.FindEntry(Packet::Hash(corruptedPath).GetHashValue());
+            REQUIRE(entryInfo != nullptr);
+
+            std::fstream packFile(manifest.GetPackPath(manifest.GetPack(entryInfo->packIndex)), std::ios::binary | std::ios::in | std::ios::out);
+            packFile.seekp(entryInfo->location + 7);
+            packFile.put('#');
+        }
+
+        for (auto readerMode : { Packet::CondensedReaderMode::Mapped, Packet::CondensedReaderMode::Stream })
+        {
+            WHEN("The condensed files are read by the " + GetModeName(readerMode) + " while verifying them on their first read")
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger, readerMode);
+
+                uint32_t totalValidReads = 0;
+                bool corruptedRead = true;
+                for (uint32_t pass = 0; pass < 2; pass++)
+                {
+                    for (auto& [resourcePath, expectedData] : resourceFiles)
+                    {
+                        Packet::Hash hash = Packet::Hash(resourcePath);
+                        std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+                        bool result = fileLoader.GetFileData(data.data(), data.size(), hash);
+                        if (resourcePath == corruptedPath)
+                        {
+                            corruptedRead = corruptedRead && result;
+                        }
+                        else if (result && std::string(data.begin(), data.end()) == expectedData)
+                        {
+                            totalValidReads++;
+                        }
+                    }
+                }
+
+                Packet::FileLoaderStats stats = fileLoader.GetStats();
+
+                THEN("Only the corrupted file fails and each intact entry is verified once")
+                {
+                    REQUIRE(corruptedRead == false);
+                    REQUIRE(totalValidReads == (resourceFiles.size() - 1) * 2);
+                    REQUIRE(stats.totalVerificationFailures == 2);
+                    REQUIRE(stats.totalVerifications == resourceFiles.size() - 1 + 2);
+                    REQUIRE(stats.totalReads == totalValidReads);
+                }
+            }
+        }
+
+        WHEN("The corrupted file is read with the verification disabled")
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, 
+                                                                            &logger, 
+                                                                            Packet::CondensedReaderMode::Mapped, 
+                                                                            __development__Packet::DefaultSolidBlockCacheSize, 
+                                                                            Packet::CondensedVerifyMode::Off);
+
+            Packet::Hash hash = Packet::Hash(corruptedPath);
+            std::vector<uint8_t> data(fileLoader.GetFileSize(hash));
+            bool result = fileLoader.GetFileData(data.data(), data.size(), hash);
+
+            THEN("The read succeeds without verifying anything")
+            {
+                REQUIRE(result == true);
+                REQUIRE(data[7] == '#');
+                REQUIRE(fileLoader.GetStats().totalVerifications == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Resources whose condensed data is corrupted fail to load", "[condensed]")
+{
+    GIVEN("A condensed data folder with two resource files where one of them had its entry corrupted")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/corrupted");
+
+        std::string corruptedPath = ResourceDirectory + "/corrupted/corrupted.bin";
+        std::string intactPath = ResourceDirectory + "/corrupted/intact.bin";
+        std::ofstream(corruptedPath, std::ios::binary) << std::string(300, 'c');
+        std::ofstream(intactPath, std::ios::binary) << std::string(300, 'i');
+
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+            REQUIRE(packetSystem.ConstructPacket() == true);
+        }
+
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger) == true);
+
+            auto* entryInfo = manifest.FindEntry(Packet::Hash(corruptedPath).GetHashValue());
+            REQUIRE(entryInfo != nullptr);
+
+            std::fstream packFile(manifest.GetPackPath(manifest.GetPack(entryInfo->packIndex)), std::ios::binary | std::ios::in | std::ios::out);
+            packFile.seekp(entryInfo->location + 7);
+            packFile.put('#');
+        }
+
+        WHEN("Both resources are requested")
+        {
+            uint32_t initialConstructions = MyResource::totalConstructions;
+
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory);
+            packetSystem.RegisterResourceFactory<MyFactory, MyResource>();
+
+            Packet::ResourceReference<MyResource> corruptedReference;
+            Packet::ResourceReference<MyResource> intactReference;
+            packetSystem.RequestResource<MyResource>(corruptedReference, Packet::Hash(corruptedPath));
+            packetSystem.RequestResource<MyResource>(intactReference, Packet::Hash(intactPath));
+            bool intactLoaded = packetSystem.WaitForResource(intactReference, MaximumTimeoutWaitMS);
+
+            // The corrupted resource never becomes valid, wait until its load is reported as failed
+            auto waitStart = std::chrono::steady_clock::now();
+            while ((corruptedReference.Get() == nullptr || !corruptedReference.Get()->ConstructionFailed())
+                   && std::chrono::steady_clock::now() - waitStart < std::chrono::milliseconds(MaximumTimeoutWaitMS))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            THEN("The corrupted resource fails without being constructed and the intact one is loaded")
+            {
+                REQUIRE(intactLoaded == true);
+                REQUIRE(corruptedReference.Get() != nullptr);
+                REQUIRE(corruptedReference.Get()->ConstructionFailed() == true);
+                REQUIRE(corruptedReference.IsValid() == false);
+                REQUIRE(MyResource::totalConstructions - initialConstructions == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files can be patched using overlay layers", "[condensed]")
+{
+    GIVEN("A condensed data folder that had a file modified, a file removed and a file added after being condensed")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/overlay");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            std::string resourcePath = ResourceDirectory + "/overlay/original_" + std::to_string(i) + ".bin";
+            std::string resourceData = std::string(200 + i * 17, char('a' + i));
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        std::string addedPath = ResourceDirectory + "/overlay/added.bin";
+        std::filesystem::remove(addedPath);
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        std::string modifiedPath = resourceFiles[1].first;
+        std::string modifiedData = std::string(333, 'm');
+        std::ofstream(modifiedPath, std::ios::binary) << modifiedData;
+
+        std::string removedPath = resourceFiles[2].first;
+        std::filesystem::remove(removedPath);
+
+        std::string addedData = std::string(150, 'n');
+        std::ofstream(addedPath, std::ios::binary) << addedData;
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.overlayDirectory = "DataPatch";
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        WHEN("The overlay is mounted over the condensed files")
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedManifest overlayManifest;
+            REQUIRE(overlayManifest.Open(__development__Packet::GetRootFolder(condenseSettings.overlayDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger) == true);
+
+            __development__Packet::PacketCondensedModeFileLoader baseFileLoader(ResourceDirectory, &logger);
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, 
+                                                                            &logger, 
+                                                                            Packet::CondensedReaderMode::Mapped, 
+                                                                            __development__Packet::DefaultSolidBlockCacheSize, 
+                                                                            Packet::CondensedVerifyMode::FirstRead, 
+                                                                            { condenseSettings.overlayDirectory });
+
+            auto ReadFileData = [](const __development__Packet::PacketCondensedModeFileLoader& _fileLoader, const std::string& _path)
+            {
+                Packet::Hash hash = Packet::Hash(_path);
+                std::vector<uint8_t> data(_fileLoader.GetFileSize(hash));
+                if (!_fileLoader.GetFileData(data.data(), data.size(), hash))
+                {
+                    return std::string("<missing>");
+                }
+
+                return std::string(data.begin(), data.end());
+            };
+
+            uint32_t totalUnchangedReads = 0;
+            for (auto& [resourcePath, expectedData] : resourceFiles)
+            {
+                if (resourcePath != modifiedPath && resourcePath != removedPath && ReadFileData(fileLoader, resourcePath) == expectedData)
+                {
+                    totalUnchangedReads++;
+                }
+            }
+
+            THEN("The overlay contains only the changes and shadows the condensed files")
+            {
+                REQUIRE(overlayManifest.GetTotalEntries() == 3);
+                REQUIRE(totalUnchangedReads == resourceFiles.size() - 2);
+                REQUIRE(ReadFileData(fileLoader, modifiedPath) == modifiedData);
+                REQUIRE(ReadFileData(fileLoader, addedPath) == addedData);
+                REQUIRE(fileLoader.FileExist(Packet::Hash(removedPath)) == false);
+                REQUIRE(ReadFileData(baseFileLoader, modifiedPath) == resourceFiles[1].second);
+                REQUIRE(ReadFileData(baseFileLoader, removedPath) == resourceFiles[2].second);
+                REQUIRE(baseFileLoader.FileExist(Packet::Hash(addedPath)) == false);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files are sharded by size instead of by folder", "[condensed]")
+{
+    GIVEN("A data folder with many small folders")
+    {
+        const uint32_t totalFolders = 40;
+        for (uint32_t i = 0; i < totalFolders; i++)
+        {
+            std::filesystem::create_directories(ResourceDirectory + "/shards/folder_" + std::to_string(i));
+            std::ofstream(ResourceDirectory + "/shards/folder_" + std::to_string(i) + "/file.bin", std::ios::binary) << std::string(3000, char('a' + i % 26)) << i;
+        }
+
+        __development__Packet::PacketLogger logger;
+        auto openManifest = [&](__development__Packet::PacketCondensedManifest& _manifest)
+        {
+            return _manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+                .append(__development__Packet::CondensedInfoName)
+                .append(__development__Packet::CondensedInfoExtension), &logger);
+        };
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+
+        WHEN("It's condensed using the default target size")
+        {
+            REQUIRE(packetSystem.ConstructPacket() == true);
+
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(openManifest(manifest) == true);
+
+            THEN("All folders are placed inside a single condensed file")
+            {
+                REQUIRE(manifest.GetTotalPacks() == 1);
+            }
+        }
+
+        WHEN("It's condensed using a small target size")
+        {
+            Packet::CondenseSettings condenseSettings;
+            condenseSettings.packTargetSize = 16384;
+            REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+            __development__Packet::PacketCondensedManifest manifest;
+            REQUIRE(openManifest(manifest) == true);
+
+            std::set<uint32_t> folders;
+            std::set<uint32_t> folderPacks;
+            std::vector<std::set<uint64_t>> packLocations(manifest.GetTotalPacks());
+            for (uint32_t i = 0; i < manifest.GetTotalEntries(); i++)
+            {
+                const auto& entryInfo = manifest.GetEntries()[i];
+                bool isSolid = (entryInfo.flags & __development__Packet::CondensedEntrySolidFlag) != 0;
+                if (manifest.GetEntryPath(entryInfo).find("shards") != std::string::npos)
+                {
+                    folders.insert(entryInfo.directoryLocation);
+                    folderPacks.insert(entryInfo.packIndex);
+                }
+                packLocations[entryInfo.packIndex].insert(isSolid ? manifest.GetBlock(entryInfo.blockIndex).location : entryInfo.location);
+            }
+
+            uint64_t totalSize = 0;
+            uint32_t totalOversizedPacks = 0;
+            for (uint32_t i = 0; i < manifest.GetTotalPacks(); i++)
+            {
+                const auto& packInfo = manifest.GetPack(i);
+                totalSize += packInfo.size;
+                totalOversizedPacks += packInfo.size > condenseSettings.packTargetSize && packLocations[i].size() > 1 ? 1 : 0;
+            }
+
+            THEN("Each condensed file stays near the target size")
+            {
+                REQUIRE(manifest.GetTotalPacks() > 1);
+                REQUIRE(folderPacks.size() < folders.size());
+                REQUIRE(manifest.GetTotalPacks() <= 2 * totalSize / condenseSettings.packTargetSize + 1);
+                REQUIRE(totalOversizedPacks == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Ranges of a file can be read without reading the whole file", "[condensed]")
+{
+    GIVEN("A data folder with a large resource file and a small resource file")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/ranges");
+
+        std::string largeResourceData;
+        for (uint32_t i = 0; largeResourceData.size() < 700000; i++)
+        {
+            largeResourceData.append(i % 5 == 0 ? std::to_string(i * 2654435761u) : "bank");
+        }
+        std::string largeResourcePath = ResourceDirectory + "/ranges/bank.bin";
+        std::ofstream(largeResourcePath, std::ios::binary) << largeResourceData;
+
+        std::string smallResourceData = "{ \"name\": \"header\", \"entries\": [ 0, 1, 2, 3, 4, 5, 6, 7 ] }";
+        std::string smallResourcePath = ResourceDirectory + "/ranges/header.json";
+        std::ofstream(smallResourcePath, std::ios::binary) << smallResourceData;
+
+        // Ranges inside the first chunk, crossing a chunk boundary, at the end of the file and empty
+        std::vector<std::pair<uint64_t, uint64_t>> largeRanges = { { 0, 100 }, { 1000, 5000 }, { 262000, 300000 }, { 699000, largeResourceData.size() - 699000 }, { 500000, 0 } };
+        std::vector<std::pair<uint64_t, uint64_t>> smallRanges = { { 0, 10 }, { 20, smallResourceData.size() - 20 } };
+
+        auto CountValidRanges = [&](const __development__Packet::PacketFileLoader& _fileLoader)
+        {
+            uint32_t totalValidRanges = 0;
+            for (auto [resourcePath, resourceData, ranges] : { std::tie(largeResourcePath, largeResourceData, largeRanges), std::tie(smallResourcePath, smallResourceData, smallRanges) })
+            {
+                for (auto [offset, size] : ranges)
+                {
+                    std::vector<uint8_t> data(size_t(size) + 1);
+                    if (_fileLoader.ReadRange(Packet::Hash(resourcePath), offset, size, data.data()) 
+                        && std::string(data.begin(), data.begin() + size) == resourceData.substr(size_t(offset), size_t(size)))
+                    {
+                        totalValidRanges++;
+                    }
+                }
+            }
+            return totalValidRanges;
+        };
+
+        auto CountInvalidRanges = [&](const __development__Packet::PacketFileLoader& _fileLoader)
+        {
+            uint8_t data[16];
+            uint32_t totalRejectedRanges = 0;
+            totalRejectedRanges += _fileLoader.ReadRange(Packet::Hash(smallResourcePath), smallResourceData.size(), 1, data) ? 0 : 1;
+            totalRejectedRanges += _fileLoader.ReadRange(Packet::Hash(smallResourcePath), 10, smallResourceData.size(), data) ? 0 : 1;
+            return totalRejectedRanges;
+        };
+
+        WHEN("The ranges are read on edit mode")
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketEditModeFileLoader fileLoader(ResourceDirectory, &logger);
+
+            THEN("Every range must match the original file content and ranges outside the file must fail")
+            {
+                REQUIRE(CountValidRanges(fileLoader) == largeRanges.size() + smallRanges.size());
+                REQUIRE(CountInvalidRanges(fileLoader) == 2);
+            }
+        }
+
+        for (auto compression : { Packet::Compression::None, Packet::Compression::LZ4 })
+        {
+            WHEN("The ranges are read from condensed files using " + GetCompressionName(compression))
+            {
+                Packet::CondenseSettings condenseSettings;
+                condenseSettings.compression = compression;
+                condenseSettings.solidEntryMaximumSize = 1024;
+
+                Packet::System packetSystem;
+                packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+                REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+                uint32_t totalValidRanges = 0;
+                uint32_t totalRejectedRanges = 0;
+                for (auto readerMode : { Packet::CondensedReaderMode::Mapped, Packet::CondensedReaderMode::Stream })
+                {
+                    __development__Packet::PacketLogger logger;
+                    __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger, readerMode);
+                    totalValidRanges += CountValidRanges(fileLoader);
+                    totalRejectedRanges += CountInvalidRanges(fileLoader);
+                }
+
+                THEN("Every range must match the original file content and ranges outside the file must fail")
+                {
+                    REQUIRE(totalValidRanges == 2 * (largeRanges.size() + smallRanges.size()));
+                    REQUIRE(totalRejectedRanges == 4);
+                }
+            }
+        }
+    }
+}
+
+// A resource whose file begins with a header holding the offset and size of the slice it needs, the factory only reads
+// the header and the resource fetches the slice while being constructed
+class MyHeaderResource : public Packet::Resource
+{
+public:
+
+    bool OnConstruct(Packet::ResourceData& _data, uint32_t, uint32_t) final
+    {
+        if (_data.GetSize() != HeaderSize)
+        {
+            return false;
+        }
+
+        std::string header(reinterpret_cast<const char*>(_data.GetData()), HeaderSize);
+        uint64_t sliceOffset = std::stoull(header.substr(0, HeaderSize / 2));
+        uint64_t sliceSize = std::stoull(header.substr(HeaderSize / 2));
+
+        std::vector<uint8_t> slice(static_cast<size_t>(sliceSize));
+        if (!ReadFileRange(sliceOffset, sliceSize, slice.data()))
+        {
+            return false;
+        }
+        m_Slice = std::string(slice.begin(), slice.end());
+
+        return true;
+    }
+
+    bool OnExternalConstruct(Packet::ResourceData&, uint32_t, uint32_t, void*) final
+    {
+        return true;
+    }
+
+    bool OnDelete(Packet::ResourceData&) final
+    {
+        return true;
+    }
+
+    const std::string& GetSlice() const
+    {
+        return m_Slice;
+    }
+
+    static constexpr uint64_t HeaderSize = 16;
+
+private:
+
+    std::string m_Slice;
+};
+
+class MyHeaderFactory : public Packet::ResourceFactory
+{
+public:
+
+    std::unique_ptr<Packet::Resource> RequestObject() final
+    {
+        return std::unique_ptr<Packet::Resource>(new MyHeaderResource());
+    }
+
+    void ReleaseObject(std::unique_ptr<Packet::Resource> _object) final
+    {
+        _object.reset();
+    }
+
+    bool AllocateData(Packet::ResourceData& _data, uint64_t _total) final
+    {
+        _data.AllocateMemory(_total);
+
+        return true;
+    }
+
+    void DeallocateData(Packet::ResourceData& _data) final
+    {
+        _data.DeallocateMemory();
+    }
+
+    uint64_t GetInitialReadSize() const final
+    {
+        return MyHeaderResource::HeaderSize;
+    }
+};
+
+SCENARIO("Resources can read only the header of their file and fetch the slices they need", "[condensed]")
+{
+    GIVEN("A big resource file that begins with a header pointing to a slice that crosses a compression chunk boundary")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/header");
+
+        // The header holds the slice offset and size, each one padded to half of it
+        uint64_t sliceOffset = 262000;
+        uint64_t sliceSize = 1000;
+        auto PadHeaderValue = [](uint64_t _value)
+        {
+            std::string value = std::to_string(_value);
+            return std::string(size_t(MyHeaderResource::HeaderSize / 2) - value.size(), '0').append(value);
+        };
+        std::string resourceData = PadHeaderValue(sliceOffset) + PadHeaderValue(sliceSize);
+        for (uint32_t i = 0; resourceData.size() < 600000; i++)
+        {
+            resourceData.append(i % 5 == 0 ? std::to_string(i * 2654435761u) : "header");
+        }
+        std::string resourcePath = ResourceDirectory + "/header/resource.bin";
+        std::ofstream(resourcePath, std::ios::binary) << resourceData;
+        std::string expectedSlice = resourceData.substr(size_t(sliceOffset), size_t(sliceSize));
+
+        for (auto compression : { Packet::Compression::None, Packet::Compression::LZ4 })
+        {
+            WHEN("The resource is loaded from condensed files using " + GetCompressionName(compression))
+            {
+                {
+                    Packet::CondenseSettings condenseSettings;
+                    condenseSettings.compression = compression;
+
+                    Packet::System packetSystem;
+                    packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+                    REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+                }
+
+                Packet::System packetSystem;
+                packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory);
+                packetSystem.RegisterResourceFactory<MyHeaderFactory, MyHeaderResource>();
+
+                Packet::ResourceReference<MyHeaderResource> resourceReference;
+                packetSystem.RequestResource<MyHeaderResource>(resourceReference, Packet::Hash(resourcePath));
+                bool resourceLoaded = packetSystem.WaitForResource(resourceReference, MaximumTimeoutWaitMS);
+
+                THEN("Only the header is read into the resource data and the slice fetched while constructing matches the file")
+                {
+                    REQUIRE(resourceLoaded == true);
+                    REQUIRE(resourceReference->GetDataSize() == MyHeaderResource::HeaderSize);
+                    REQUIRE(resourceReference->GetFileSize() == resourceData.size());
+                    REQUIRE(resourceReference->GetSlice() == expectedSlice);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files can be read asynchronously", "[condensed]")
+{
+    GIVEN("A data folder with raw, compressed and solid resource files")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/async");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        for (uint32_t i = 0; i < 24; i++)
+        {
+            // Even files are random (so they are stored raw) and odd files are compressed
+            std::string resourceData;
+            uint32_t randomState = i + 1;
+            for (uint32_t j = 0; resourceData.size() < (i % 3 == 0 ? 300000u : i % 3 == 1 ? 5000u : 200u); j++)
+            {
+                randomState = randomState * 1664525u + 1013904223u;
+                resourceData.append(i % 2 == 0 ? std::string(1, char(randomState >> 24)) : "async");
+            }
+
+            std::string resourcePath = ResourceDirectory + "/async/file_" + std::to_string(i) + ".bin";
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.compression = Packet::Compression::LZ4;
+        condenseSettings.solidEntryMaximumSize = 1024;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        for (auto asyncReadMode : { Packet::AsyncReadMode::Automatic, Packet::AsyncReadMode::ThreadPool })
+        {
+            WHEN("All files and a missing file are read using a single batch with the " + GetAsyncReadModeName(asyncReadMode))
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, 
+                                                                                  &logger, 
+                                                                                  Packet::CondensedReaderMode::Stream, 
+                                                                                  __development__Packet::DefaultSolidBlockCacheSize, 
+                                                                                  Packet::CondensedVerifyMode::FirstRead, 
+                                                                                  {}, 
+                                                                                  asyncReadMode, 
+                                                                                  8);
+
+                std::vector<std::vector<uint8_t>> buffers(resourceFiles.size() + 1);
+                std::vector<__development__Packet::PacketReadRequest> requests;
+                for (uint32_t i = 0; i < resourceFiles.size(); i++)
+                {
+                    Packet::Hash hash = Packet::Hash(resourceFiles[i].first);
+                    buffers[i].resize(fileLoader.GetFileSize(hash));
+                    requests.push_back({ hash, 0, buffers[i].size(), buffers[i].data(), i });
+                }
+                buffers.back().resize(16);
+                requests.push_back({ Packet::Hash(ResourceDirectory + "/async/missing.bin"), 0, 16, buffers.back().data(), resourceFiles.size() });
+
+                fileLoader.SubmitReads(requests);
+
+                std::vector<__development__Packet::PacketReadCompletion> completions;
+                for (uint32_t attempt = 0; completions.size() < requests.size() && attempt < 5000; attempt++)
+                {
+                    if (fileLoader.DrainReadCompletions(completions) == 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+
+                std::set<uint64_t> completedReads;
+                uint32_t totalValidReads = 0;
+                uint32_t totalFailedReads = 0;
+                for (auto& completion : completions)
+                {
+                    completedReads.insert(completion.userData);
+                    if (completion.userData == resourceFiles.size())
+                    {
+                        totalFailedReads += completion.succeeded ? 0 : 1;
+                    }
+                    else if (completion.succeeded && std::string(buffers[completion.userData].begin(), buffers[completion.userData].end()) == resourceFiles[completion.userData].second)
+                    {
+                        totalValidReads++;
+                    }
+                }
+
+                THEN("Each read must complete once with the original file content and the missing file must fail")
+                {
+                    REQUIRE(completions.size() == requests.size());
+                    REQUIRE(completedReads.size() == requests.size());
+                    REQUIRE(totalValidReads == resourceFiles.size());
+                    REQUIRE(totalFailedReads == 1);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Neighbouring condensed reads are merged when read asynchronously", "[condensed]")
+{
+    GIVEN("A data folder with resource files stored next to each other")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/coalesce");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        uint32_t randomState = 7;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            std::string resourceData;
+            while (resourceData.size() < 4096)
+            {
+                randomState = randomState * 1664525u + 1013904223u;
+                resourceData.push_back(char(randomState >> 24));
+            }
+
+            std::string resourcePath = ResourceDirectory + "/coalesce/file_" + std::to_string(i) + ".bin";
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        // Get the files sorted by their location inside the condensed files
+        __development__Packet::PacketLogger manifestLogger;
+        __development__Packet::PacketCondensedManifest manifest;
+        REQUIRE(manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+            .append(__development__Packet::CondensedInfoName)
+            .append(__development__Packet::CondensedInfoExtension), &manifestLogger) == true);
+
+        std::vector<uint32_t> sortedFiles;
+        for (uint32_t i = 0; i < resourceFiles.size(); i++)
+        {
+            sortedFiles.push_back(i);
+        }
+        std::sort(sortedFiles.begin(), sortedFiles.end(), [&](uint32_t _a, uint32_t _b)
+        {
+            return manifest.FindEntry(Packet::Hash(resourceFiles[_a].first).GetHashValue())->location 
+                < manifest.FindEntry(Packet::Hash(resourceFiles[_b].first).GetHashValue())->location;
+        });
+
+        auto ReadFiles = [&](uint64_t _readCoalesceGap, uint32_t _step, uint32_t& _totalValidReadsOut)
+        {
+            __development__Packet::PacketLogger logger;
+            __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, 
+                                                                              &logger, 
+                                                                              Packet::CondensedReaderMode::Stream, 
+                                                                              __development__Packet::DefaultSolidBlockCacheSize, 
+                                                                              Packet::CondensedVerifyMode::FirstRead, 
+                                                                              {}, 
+                                                                              Packet::AsyncReadMode::Automatic, 
+                                                                              __development__Packet::DefaultAsyncReadQueueDepth, 
+                                                                              __development__Packet::DefaultAsyncReadThreads, 
+                                                                              _readCoalesceGap);
+
+            // Request the files in reverse location order, they are sorted by location again before being read
+            std::vector<std::vector<uint8_t>> buffers(resourceFiles.size());
+            std::vector<__development__Packet::PacketReadRequest> requests;
+            for (uint32_t i = uint32_t(sortedFiles.size()); i >= _step; i -= _step)
+            {
+                uint32_t fileIndex = sortedFiles[i - 1];
+                Packet::Hash hash = Packet::Hash(resourceFiles[fileIndex].first);
+                buffers[fileIndex].resize(fileLoader.GetFileSize(hash));
+                requests.push_back({ hash, 0, buffers[fileIndex].size(), buffers[fileIndex].data(), fileIndex });
+            }
+
+            fileLoader.SubmitReads(requests);
+
+            std::vector<__development__Packet::PacketReadCompletion> completions;
+            for (uint32_t attempt = 0; completions.size() < requests.size() && attempt < 5000; attempt++)
+            {
+                if (fileLoader.DrainReadCompletions(completions) == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            _totalValidReadsOut = 0;
+            for (auto& completion : completions)
+            {
+                auto& buffer = buffers[completion.userData];
+                if (completion.succeeded && std::string(buffer.begin(), buffer.end()) == resourceFiles[completion.userData].second)
+                {
+                    _totalValidReadsOut++;
+                }
+            }
+
+            return fileLoader.GetStats().totalCoalescedReads;
+        };
+
+        WHEN("Every file is read using the default coalesce gap")
+        {
+            uint32_t totalValidReads = 0;
+            uint64_t totalCoalescedReads = ReadFiles(__development__Packet::DefaultReadCoalesceGap, 1, totalValidReads);
+
+            THEN("All reads are merged and every buffer receives its file content")
+            {
+                REQUIRE(totalValidReads == resourceFiles.size());
+                REQUIRE(totalCoalescedReads == resourceFiles.size());
+            }
+        }
+
+        WHEN("Every other file is read without a coalesce gap")
+        {
+            uint32_t totalValidReads = 0;
+            uint64_t totalCoalescedReads = ReadFiles(0, 2, totalValidReads);
+
+            THEN("No read is merged and every buffer receives its file content")
+            {
+                REQUIRE(totalValidReads == resourceFiles.size() / 2);
+                REQUIRE(totalCoalescedReads == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Big condensed reads bypass the page cache using direct I/O", "[condensed]")
+{
+    GIVEN("A data folder with big resource files condensed using aligned entries")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/directio");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        uint32_t randomState = 11;
+        for (uint64_t fileSize : { uint64_t(200000), uint64_t(300001), uint64_t(196608), uint64_t(1000) })
+        {
+            std::string resourceData;
+            while (resourceData.size() < fileSize)
+            {
+                randomState = randomState * 1664525u + 1013904223u;
+                resourceData.push_back(char(randomState >> 24));
+            }
+
+            std::string resourcePath = ResourceDirectory + "/directio/file_" + std::to_string(resourceFiles.size()) + ".bin";
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::CondenseSettings condenseSettings;
+        condenseSettings.alignment = __development__Packet::DirectReadAlignment;
+        condenseSettings.alignmentMinimumSize = 65536;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket(condenseSettings) == true);
+
+        // Reads with at least 64KB use direct I/O, the last file is smaller and is read normally
+        __development__Packet::PacketLogger logger;
+        __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, 
+                                                                          &logger, 
+                                                                          Packet::CondensedReaderMode::Mapped, 
+                                                                          __development__Packet::DefaultSolidBlockCacheSize, 
+                                                                          Packet::CondensedVerifyMode::FirstRead, 
+                                                                          {}, 
+                                                                          Packet::AsyncReadMode::Automatic, 
+                                                                          __development__Packet::DefaultAsyncReadQueueDepth, 
+                                                                          __development__Packet::DefaultAsyncReadThreads, 
+                                                                          __development__Packet::DefaultReadCoalesceGap, 
+                                                                          65536);
+
+        WHEN("The files are read asynchronously into buffers with the alignment the loader asks for")
+        {
+            auto initialStats = fileLoader.GetStats();
+            std::vector<std::vector<uint8_t>> buffers(resourceFiles.size());
+            std::vector<__development__Packet::PacketReadRequest> requests;
+            uint64_t expectedBounceBufferBytes = 0;
+            uint32_t totalAlignedReads = 0;
+            for (uint32_t i = 0; i < resourceFiles.size(); i++)
+            {
+                Packet::Hash hash = Packet::Hash(resourceFiles[i].first);
+                uint64_t fileSize = fileLoader.GetFileSize(hash);
+                uint32_t alignment = std::max(fileLoader.GetReadAlignment(hash, 0, fileSize), 1u);
+                if (alignment == __development__Packet::DirectReadAlignment)
+                {
+                    expectedBounceBufferBytes += fileSize % alignment;
+                    totalAlignedReads++;
+                }
+
+                // Over allocate so the data can begin at an aligned address
+                buffers[i].resize(size_t(fileSize + alignment));
+                uint8_t* dataOut = buffers[i].data() + (alignment - reinterpret_cast<uintptr_t>(buffers[i].data()) % alignment) % alignment;
+                requests.push_back({ hash, 0, fileSize, dataOut, i });
+            }
+
+            fileLoader.SubmitReads(requests);
+
+            std::vector<__development__Packet::PacketReadCompletion> completions;
+            for (uint32_t attempt = 0; completions.size() < requests.size() && attempt < 5000; attempt++)
+            {
+                if (fileLoader.DrainReadCompletions(completions) == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            THEN("Every buffer receives its file content and only the unaligned tails use bounce buffers")
+            {
+                REQUIRE(completions.size() == requests.size());
+                for (auto& completion : completions)
+                {
+                    auto& request = requests[completion.userData];
+                    REQUIRE(completion.succeeded == true);
+                    REQUIRE(std::string(request.dataOut, request.dataOut + request.size) == resourceFiles[completion.userData].second);
+                }
+
+                REQUIRE(totalAlignedReads == 3);
+                REQUIRE(fileLoader.GetStats().totalDirectIoReads - initialStats.totalDirectIoReads == 3);
+                REQUIRE(fileLoader.GetStats().totalBounceBufferBytes - initialStats.totalBounceBufferBytes == expectedBounceBufferBytes);
+            }
+        }
+
+        WHEN("Ranges of the files are read synchronously into unaligned buffers")
+        {
+            auto initialStats = fileLoader.GetStats();
+            std::vector<bool> validRanges;
+            uint64_t totalRangeBytes = 0;
+            for (auto& resourceFile : resourceFiles)
+            {
+                Packet::Hash hash = Packet::Hash(resourceFile.first);
+                uint64_t rangeSize = resourceFile.second.size() - 3;
+                std::vector<uint8_t> buffer(size_t(rangeSize + 1));
+                validRanges.push_back(fileLoader.ReadRange(hash, 1, rangeSize, buffer.data() + 1) 
+                    && std::string(buffer.begin() + 1, buffer.end()) == resourceFile.second.substr(1, size_t(rangeSize)));
+                totalRangeBytes += rangeSize >= 65536 ? rangeSize : 0;
+            }
+
+            THEN("Every range is read correctly through the bounce buffers")
+            {
+                REQUIRE(std::count(validRanges.begin(), validRanges.end(), true) == int(resourceFiles.size()));
+                REQUIRE(fileLoader.GetStats().totalDirectIoReads - initialStats.totalDirectIoReads == 3);
+                REQUIRE(fileLoader.GetStats().totalBounceBufferBytes - initialStats.totalBounceBufferBytes == totalRangeBytes);
+            }
+        }
+
+        WHEN("Only the beginning of each file is read before anything else was read")
+        {
+            __development__Packet::PacketCondensedModeFileLoader headerFileLoader(ResourceDirectory, 
+                                                                                    &logger, 
+                                                                                    Packet::CondensedReaderMode::Mapped, 
+                                                                                    __development__Packet::DefaultSolidBlockCacheSize, 
+                                                                                    Packet::CondensedVerifyMode::FirstRead, 
+                                                                                    {}, 
+                                                                                    Packet::AsyncReadMode::Automatic, 
+                                                                                    __development__Packet::DefaultAsyncReadQueueDepth, 
+                                                                                    __development__Packet::DefaultAsyncReadThreads, 
+                                                                                    __development__Packet::DefaultReadCoalesceGap, 
+                                                                                    65536);
+
+            uint32_t totalValidHeaders = 0;
+            for (auto& resourceFile : resourceFiles)
+            {
+                std::vector<uint8_t> header(100);
+                if (headerFileLoader.ReadRange(Packet::Hash(resourceFile.first), 0, header.size(), header.data())
+                    && std::string(header.begin(), header.end()) == resourceFile.second.substr(0, header.size()))
+                {
+                    totalValidHeaders++;
+                }
+            }
+
+            auto stats = headerFileLoader.GetStats();
+
+            THEN("Each whole file is verified, the big ones are streamed through direct I/O without copying them")
+            {
+                REQUIRE(totalValidHeaders == resourceFiles.size());
+                REQUIRE(stats.totalVerifications == resourceFiles.size());
+                REQUIRE(stats.totalVerificationFailures == 0);
+                REQUIRE(stats.totalDirectIoReads == 0);
+                REQUIRE(stats.totalBounceBufferBytes == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Edit mode reads get the file size and data from a single open", "[edit]")
+{
+    GIVEN("A resource file read using the edit mode loader")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/metadata");
+        std::string resourcePath = ResourceDirectory + "/metadata/file.txt";
+        std::ofstream(resourcePath, std::ios::binary) << "original resource data";
+
+        __development__Packet::PacketLogger logger;
+        __development__Packet::PacketEditModeFileLoader fileLoader(ResourceDirectory, &logger);
+        Packet::Hash hash = Packet::Hash(resourcePath);
+
+        REQUIRE(fileLoader.FileExist(hash) == true);
+        REQUIRE(fileLoader.FileExist(Packet::Hash(ResourceDirectory + "/metadata")) == false);
+        REQUIRE(fileLoader.GetFileSize(hash) == std::string("original resource data").size());
+
+        WHEN("The file changes while its metadata is cached")
+        {
+            std::ofstream(resourcePath, std::ios::binary) << "modified data";
+            uint64_t cachedSize = fileLoader.GetFileSize(hash);
+
+            std::vector<uint8_t> data;
+            bool readSucceeded = fileLoader.ReadFile(hash, [&](uint64_t _size)
+            {
+                data.resize(size_t(_size));
+                return data.data();
+            });
+
+            THEN("Reading the whole file gets its current size and data and refreshes the cache")
+            {
+                REQUIRE(cachedSize == std::string("original resource data").size());
+                REQUIRE(readSucceeded == true);
+                REQUIRE(std::string(data.begin(), data.end()) == "modified data");
+                REQUIRE(fileLoader.GetFileSize(hash) == std::string("modified data").size());
+            }
+        }
+
+        WHEN("The file changes and its metadata is invalidated")
+        {
+            std::ofstream(resourcePath, std::ios::binary) << "another modification";
+            fileLoader.InvalidateFileMetadata(hash);
+
+            THEN("The current size is returned")
+            {
+                REQUIRE(fileLoader.GetFileSize(hash) == std::string("another modification").size());
+            }
+        }
+    }
+}
+
+SCENARIO("The edit mode directory index is kept current by the file watcher", "[edit]")
+{
+    GIVEN("An edit mode loader that indexed the data tree")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/index");
+        std::string resourcePath = ResourceDirectory + "/index/file.txt";
+        std::string newResourcePath = ResourceDirectory + "/index/new_file.txt";
+        std::filesystem::remove(newResourcePath);
+        std::ofstream(resourcePath, std::ios::binary) << "indexed data";
+
+        __development__Packet::PacketLogger logger;
+        __development__Packet::PacketEditModeFileLoader fileLoader(ResourceDirectory, &logger, __development__Packet::DefaultAsyncReadThreads, true);
+        Packet::Hash hash = Packet::Hash(resourcePath);
+
+        REQUIRE(fileLoader.FileExist(hash) == true);
+        REQUIRE(fileLoader.GetFileSize(hash) == std::string("indexed data").size());
+        REQUIRE(fileLoader.FileExist(Packet::Hash(newResourcePath)) == false);
+
+        // Wait until the loader reports the expected file size, the file watcher events are only processed by Update()
+        // (the resource manager calls it periodically)
+        auto WaitForFileSize = [&](Packet::Hash _hash, uint64_t _expectedSize, bool _shouldExist)
+        {
+            for (uint32_t attempt = 0; attempt < 200; attempt++)
+            {
+                fileLoader.Update();
+                if (fileLoader.FileExist(_hash) == _shouldExist && (!_shouldExist || fileLoader.GetFileSize(_hash) == _expectedSize))
+                {
+                    return true;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            return false;
+        };
+
+        WHEN("Files are created, modified and removed")
+        {
+            std::ofstream(newResourcePath, std::ios::binary) << "new data";
+            bool newFileFound = fileLoader.FileExist(Packet::Hash(newResourcePath));
+
+            std::ofstream(resourcePath, std::ios::binary) << "indexed data that was modified";
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            uint64_t sizeBeforeUpdate = fileLoader.GetFileSize(hash);
+            bool modifiedSizeFound = WaitForFileSize(hash, std::string("indexed data that was modified").size(), true);
+
+            std::filesystem::remove(newResourcePath);
+            bool removalFound = WaitForFileSize(Packet::Hash(newResourcePath), 0, false);
+
+            THEN("The index follows each change once the file watcher events are processed")
+            {
+                REQUIRE(sizeBeforeUpdate == std::string("indexed data").size());
+                REQUIRE(newFileFound == true);
+                REQUIRE(modifiedSizeFound == true);
+                REQUIRE(removalFound == true);
+            }
+        }
+    }
+}
+
+SCENARIO("Condensed files can be prefetched and evicted", "[condensed]")
+{
+    GIVEN("A condensed data folder with a few resource files")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/prefetch");
+
+        std::vector<std::pair<std::string, std::string>> resourceFiles;
+        uint32_t randomState = 13;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            std::string resourceData;
+            while (resourceData.size() < 20000 + i * 1000)
+            {
+                randomState = randomState * 1664525u + 1013904223u;
+                resourceData.push_back(char(randomState >> 24));
+            }
+
+            std::string resourcePath = ResourceDirectory + "/prefetch/file_" + std::to_string(i) + ".bin";
+            std::ofstream(resourcePath, std::ios::binary) << resourceData;
+            resourceFiles.push_back({ resourcePath, resourceData });
+        }
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+        REQUIRE(packetSystem.ConstructPacket() == true);
+
+        // Get the stored size of each file
+        __development__Packet::PacketLogger manifestLogger;
+        __development__Packet::PacketCondensedManifest manifest;
+        REQUIRE(manifest.Open(__development__Packet::GetRootFolder(ResourceDirectory)
+            .append(__development__Packet::CondensedInfoName)
+            .append(__development__Packet::CondensedInfoExtension), &manifestLogger) == true);
+
+        std::vector<Packet::Hash> hashes;
+        uint64_t totalStoredSize = 0;
+        for (auto& resourceFile : resourceFiles)
+        {
+            hashes.push_back(Packet::Hash(resourceFile.first));
+            totalStoredSize += manifest.FindEntry(hashes.back().GetHashValue())->storedSize;
+        }
+
+        for (auto readerMode : { Packet::CondensedReaderMode::Mapped, Packet::CondensedReaderMode::Stream })
+        {
+            WHEN("The files are prefetched, evicted and read by the " + GetModeName(readerMode))
+            {
+                __development__Packet::PacketLogger logger;
+                __development__Packet::PacketCondensedModeFileLoader fileLoader(ResourceDirectory, &logger, readerMode);
+
+                fileLoader.Prefetch(hashes);
+                fileLoader.Evict(hashes);
+
+                uint32_t totalValidReads = 0;
+                for (uint32_t i = 0; i < resourceFiles.size(); i++)
+                {
+                    std::vector<uint8_t> data(size_t(fileLoader.GetFileSize(hashes[i])));
+                    if (fileLoader.GetFileData(data.data(), data.size(), hashes[i]) 
+                        && std::string(data.begin(), data.end()) == resourceFiles[i].second)
+                    {
+                        totalValidReads++;
+                    }
+                }
+
+                THEN("The stored data of each file is advised and can still be read")
+                {
+                    REQUIRE(fileLoader.GetStats().totalPrefetchedBytes == totalStoredSize);
+                    REQUIRE(fileLoader.GetStats().totalEvictedBytes == totalStoredSize);
+                    REQUIRE(totalValidReads == resourceFiles.size());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Resource requests wake up the resource management thread", "[system]")
+{
+    GIVEN("A condensed data folder and a packet system whose management thread only wakes up when signalled")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/wakeup");
+
+        std::vector<std::string> resourcePaths;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            resourcePaths.push_back(ResourceDirectory + "/wakeup/resource_" + std::to_string(i) + ".txt");
+            CreateResourceFile(resourcePaths.back(), 100 + i);
+        }
+
+        // Empty resource files can't be constructed
+        std::string emptyResourcePath = ResourceDirectory + "/wakeup/empty.txt";
+        std::ofstream(emptyResourcePath, std::ios::binary);
+
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+            REQUIRE(packetSystem.ConstructPacket() == true);
+        }
+
+        Packet::SystemSettings settings;
+        settings.resourceThreadIdleTimeout = 0;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory, std::make_unique<__development__Packet::PacketLogger>(), settings);
+        packetSystem.RegisterResourceFactory<MyFactory, MyResource>();
+
+        WHEN("Resources are requested one after the other and then released")
+        {
+            uint32_t totalLoadedResources = 0;
+            for (auto& resourcePath : resourcePaths)
+            {
+                // Let the thread go back to sleep before each request
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+                Packet::ResourceReference<MyResource> resourceReference;
+                packetSystem.RequestResource<MyResource>(resourceReference, Packet::Hash(resourcePath));
+                if (packetSystem.WaitForResource(resourceReference, MaximumTimeoutWaitMS))
+                {
+                    totalLoadedResources++;
+                }
+            }
+
+            THEN("Every request is served, every released resource is deleted and the thread sleeps once it's idle")
+            {
+                REQUIRE(totalLoadedResources == resourcePaths.size());
+                REQUIRE(MustChangeToTrueUntilTimeout([&]()
+                {
+                    return packetSystem.GetAproximatedResourceAmount() == 0;
+                }, 5000));
+
+                uint64_t totalManagementPasses = packetSystem.GetResourceManagerStats().totalManagementPasses;
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                REQUIRE(packetSystem.GetResourceManagerStats().totalManagementPasses == totalManagementPasses);
+            }
+        }
+
+        WHEN("A resource that can't be constructed is requested and then released")
+        {
+            {
+                Packet::ResourceReference<MyResource> resourceReference;
+                packetSystem.RequestResource<MyResource>(resourceReference, Packet::Hash(emptyResourcePath));
+                REQUIRE(MustChangeToTrueUntilTimeout([&]()
+                {
+                    return resourceReference.Get() != nullptr && resourceReference.Get()->ConstructionFailed();
+                }, 5000));
+            }
+
+            THEN("The failed resource is deleted and the thread sleeps once it's idle")
+            {
+                REQUIRE(MustChangeToTrueUntilTimeout([&]()
+                {
+                    return packetSystem.GetAproximatedResourceAmount() == 0;
+                }, 5000));
+
+                uint64_t totalManagementPasses = packetSystem.GetResourceManagerStats().totalManagementPasses;
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                REQUIRE(packetSystem.GetResourceManagerStats().totalManagementPasses == totalManagementPasses);
+            }
+        }
+    }
+}
+
+SCENARIO("Resources can be constructed by multiple load threads", "[system]")
+{
+    GIVEN("A condensed data folder and a packet system with multiple load threads whose resources are slow to construct")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/parallel");
+
+        std::vector<std::string> resourcePaths;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            resourcePaths.push_back(ResourceDirectory + "/parallel/resource_" + std::to_string(i) + ".txt");
+            CreateResourceFile(resourcePaths.back(), 100 + i);
+        }
+
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+            REQUIRE(packetSystem.ConstructPacket() == true);
+        }
+
+        Packet::SystemSettings settings;
+        settings.resourceLoadThreads = 4;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory, std::make_unique<__development__Packet::PacketLogger>(), settings);
+        packetSystem.RegisterResourceFactory<MyFactory, MyResource>();
+
+        WHEN("Each resource is requested multiple times at once")
+        {
+            MyResource::constructDelay = 50;
+            MyResource::maximumConstructing = 0;
+            uint32_t initialConstructions = MyResource::totalConstructions;
+
+            std::vector<Packet::ResourceReference<MyResource>> resourceReferences(resourcePaths.size() * 3);
+            for (uint32_t i = 0; i < resourceReferences.size(); i++)
+            {
+                packetSystem.RequestResource<MyResource>(resourceReferences[i], Packet::Hash(resourcePaths[i % resourcePaths.size()]));
+            }
+
+            uint32_t totalLoadedReferences = 0;
+            for (auto& resourceReference : resourceReferences)
+            {
+                if (packetSystem.WaitForResource(resourceReference, MaximumTimeoutWaitMS))
+                {
+                    totalLoadedReferences++;
+                }
+            }
+
+            MyResource::constructDelay = 0;
+
+            THEN("Each resource is constructed once, with multiple resources being constructed at the same time")
+            {
+                REQUIRE(totalLoadedReferences == resourceReferences.size());
+                REQUIRE(MyResource::totalConstructions - initialConstructions == resourcePaths.size());
+                REQUIRE(MyResource::maximumConstructing > 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Resource requests with a higher priority are loaded first", "[system]")
+{
+    GIVEN("A condensed data folder and a packet system with a single load thread whose resources are slow to construct")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/priority");
+
+        std::vector<std::string> resourcePaths;
+        for (uint32_t i = 0; i < 152; i++)
+        {
+            resourcePaths.push_back(ResourceDirectory + "/priority/resource_" + std::to_string(i) + ".txt");
+            CreateResourceFile(resourcePaths.back(), 100 + i);
+        }
+
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+            REQUIRE(packetSystem.ConstructPacket() == true);
+        }
+
+        Packet::SystemSettings settings;
+        settings.resourceLoadThreads = 1;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory, std::make_unique<__development__Packet::PacketLogger>(), settings);
+        packetSystem.RegisterResourceFactory<MyFactory, MyResource>();
+
+        // Request all resources except the last two (each scenario uses one of them)
+        MyResource::constructDelay = 2;
+        std::vector<Packet::ResourceReference<MyResource>> backgroundReferences(resourcePaths.size() - 2);
+        for (uint32_t i = 0; i < backgroundReferences.size(); i++)
+        {
+            packetSystem.RequestResource<MyResource>(backgroundReferences[i], Packet::Hash(resourcePaths[i]));
+        }
+
+        WHEN("A resource is requested with a higher priority after them")
+        {
+            uint32_t initialConstructions = MyResource::totalConstructions;
+
+            Packet::ResourceBuildInfo buildInfo;
+            buildInfo.priority = 10;
+
+            Packet::ResourceReference<MyResource> resourceReference;
+            packetSystem.RequestResource<MyResource>(resourceReference, Packet::Hash(resourcePaths[resourcePaths.size() - 2]), buildInfo);
+            bool resourceLoaded = packetSystem.WaitForResource(resourceReference, MaximumTimeoutWaitMS);
+            uint32_t totalConstructionsBefore = MyResource::totalConstructions - initialConstructions;
+
+            THEN("It only waits for the loads already in flight")
+            {
+                // Its own construction is counted too
+                REQUIRE(resourceLoaded == true);
+                REQUIRE(totalConstructionsBefore <= __development__Packet::MaximumResourceLoadsInFlight + 1);
+            }
+        }
+
+        WHEN("A resource is requested after them and its priority is raised")
+        {
+            uint32_t initialConstructions = MyResource::totalConstructions;
+
+            Packet::ResourceReference<MyResource> resourceReference;
+            packetSystem.RequestResource<MyResource>(resourceReference, Packet::Hash(resourcePaths.back()));
+            bool priorityRaised = packetSystem.RaiseResourcePriority(resourceReference, 10);
+            bool resourceLoaded = packetSystem.WaitForResource(resourceReference, MaximumTimeoutWaitMS);
+            uint32_t totalConstructionsBefore = MyResource::totalConstructions - initialConstructions;
+
+            THEN("It only waits for the loads already in flight and its priority can't be raised anymore")
+            {
+                // A few loads may start before its priority is raised
+                REQUIRE(priorityRaised == true);
+                REQUIRE(resourceLoaded == true);
+                REQUIRE(totalConstructionsBefore <= __development__Packet::MaximumResourceLoadsInFlight + 4);
+                REQUIRE(packetSystem.RaiseResourcePriority(resourceReference, 20) == false);
+            }
+        }
+
+        for (auto& backgroundReference : backgroundReferences)
+        {
+            packetSystem.WaitForResource(backgroundReference, MaximumTimeoutWaitMS);
+        }
+        MyResource::constructDelay = 0;
+    }
+}
+
+SCENARIO("Resource requests are cancelled when their reference is released before they are processed", "[system]")
+{
+    GIVEN("A condensed data folder and a packet system busy loading other resources")
+    {
+        std::filesystem::create_directories(ResourceDirectory + "/cancel");
+
+        std::vector<std::string> resourcePaths;
+        for (uint32_t i = 0; i < 150; i++)
+        {
+            resourcePaths.push_back(ResourceDirectory + "/cancel/resource_" + std::to_string(i) + ".txt");
+            CreateResourceFile(resourcePaths.back(), 100 + i);
+        }
+
+        {
+            Packet::System packetSystem;
+            packetSystem.Initialize(Packet::OperationMode::Edit, ResourceDirectory);
+            REQUIRE(packetSystem.ConstructPacket() == true);
+        }
+
+        Packet::SystemSettings settings;
+        settings.resourceLoadThreads = 1;
+
+        Packet::System packetSystem;
+        packetSystem.Initialize(Packet::OperationMode::Condensed, ResourceDirectory, std::make_unique<__development__Packet::PacketLogger>(), settings);
+        packetSystem.RegisterResourceFactory<MyFactory, MyResource>();
+
+        MyResource::constructDelay = 2;
+        uint32_t initialConstructions = MyResource::totalConstructions;
+        std::vector<Packet::ResourceReference<MyResource>> backgroundReferences(100);
+        for (uint32_t i = 0; i < backgroundReferences.size(); i++)
+        {
+            packetSystem.RequestResource<MyResource>(backgroundReferences[i], Packet::Hash(resourcePaths[i]));
+        }
+
+        WHEN("Other resources are requested and their references are released or reset right away")
+        {
+            uint32_t totalDroppedRequests = 0;
+            for (uint32_t i = uint32_t(backgroundReferences.size()); i < resourcePaths.size(); i++)
+            {
+                Packet::ResourceReference<MyResource> resourceReference;
+                packetSystem.RequestResource<MyResource>(resourceReference, Packet::Hash(resourcePaths[i]));
+                if (i % 2 == 0)
+                {
+                    resourceReference.Reset();
+                }
+                totalDroppedRequests++;
+            }
+
+            for (auto& backgroundReference : backgroundReferences)
+            {
+                packetSystem.WaitForResource(backgroundReference, MaximumTimeoutWaitMS);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            uint64_t totalCancelledRequests = packetSystem.GetResourceManagerStats().totalCancelledRequests;
+            uint32_t totalConstructions = MyResource::totalConstructions - initialConstructions;
+
+            THEN("The cancelled requests are counted and their resources are never constructed")
+            {
+                REQUIRE(totalCancelledRequests > 0);
+                REQUIRE(totalCancelledRequests <= totalDroppedRequests);
+                REQUIRE(totalConstructions == backgroundReferences.size() + totalDroppedRequests - totalCancelledRequests);
+            }
+        }
+
+        MyResource::constructDelay = 0;
+    }
+}